@@ -5,3 +5,4 @@ rm -rf ./bin/
 rm -rf ./gen/
 rm -rf ./libs/
 rm -rf ./obj/
+rm -f ./host/*.o ./host/prng-bench ./host/prng-daemon-test
@@ -0,0 +1,454 @@
+/* Host stand-ins for the Android log, looper and sensor APIs used */
+/* by the generator core. The sensors are synthetic: each enabled  */
+/* sensor emits noisy readings at its event rate, and a looper     */
+/* sleeps until the next reading is due, so collection timing on   */
+/* the host follows the same shape as on a device.                 */
+/*                                                                 */
+/* Environment:                                                    */
+/*   PRNG_HOST_LOG      log to stderr when set                     */
+/*   PRNG_HOST_SENSORS  number of synthetic sensors (default all,  */
+/*                      0 simulates a device without sensors)      */
+
+#include <android/log.h>
+#include <android/looper.h>
+#include <android/sensor.h>
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#define COUNTOF(x) (sizeof(x) / sizeof(x[0]))
+
+/* Events pending in a queue are capped, like the kernel's buffers. */
+static const size_t MAX_PENDING_EVENTS = 256;
+
+/* On-change sensors (min delay 0) report this often. */
+static const int64_t ON_CHANGE_PERIOD_NS = 500LL * 1000 * 1000;
+
+struct ASensor {
+	int m_type;
+	const char* m_name;
+	int m_minDelay; /* microseconds, 0 for on-change */
+	float m_resolution;
+	float m_base[6]; /* resting reading per channel */
+	int m_channels;
+};
+
+struct ASensorManager {
+	int m_unused;
+};
+
+static const ASensor s_sensors[] = {
+	{ ASENSOR_TYPE_ACCELEROMETER, "Synthetic Accelerometer", 5000, 0.0023f,
+		{ 0.12f, 0.31f, 9.78f }, 3 },
+	{ ASENSOR_TYPE_GYROSCOPE, "Synthetic Gyroscope", 5000, 0.0011f,
+		{ 0.002f, -0.004f, 0.001f }, 3 },
+	{ ASENSOR_TYPE_MAGNETIC_FIELD, "Synthetic Magnetic Field", 20000, 0.06f,
+		{ 21.5f, -4.2f, -38.9f }, 3 },
+	{ 11 /*Rotation vector*/, "Synthetic Rotation Vector", 10000, 0.00001f,
+		{ 0.01f, 0.02f, 0.7f, 0.71f, 0.5f }, 5 },
+	{ 16 /*Uncalibrated gyroscope*/, "Synthetic Uncalibrated Gyroscope", 5000,
+		0.0011f, { 0.003f, -0.002f, 0.004f, 0.001f, -0.001f, 0.002f }, 6 },
+	{ 6 /*Pressure*/, "Synthetic Barometer", 40000, 0.01f, { 1013.25f }, 1 },
+	{ ASENSOR_TYPE_LIGHT, "Synthetic Light", 0, 1.0f, { 320.0f }, 1 },
+	{ ASENSOR_TYPE_PROXIMITY, "Synthetic Proximity", 0, 1.0f, { 5.0f }, 1 },
+};
+
+static ASensorManager s_manager;
+static ASensorRef s_sensorList[COUNTOF(s_sensors)];
+
+struct EnabledSensor {
+	const ASensor* m_sensor;
+	int m_handle;
+	int64_t m_period;
+	int64_t m_next;
+};
+
+struct ASensorEventQueue {
+	ALooper* m_looper;
+	int m_ident;
+	ALooper_callbackFunc m_callback;
+	void* m_data;
+
+	std::vector<EnabledSensor> m_enabled;
+	std::deque<ASensorEvent> m_pending;
+	uint64_t m_noise;
+};
+
+struct ALooper {
+	std::vector<ASensorEventQueue*> m_queues;
+	pthread_mutex_t m_lock;
+	pthread_cond_t m_cond;
+	int m_woken;
+	int m_refs;
+};
+
+static pthread_key_t s_looperKey;
+static pthread_once_t s_looperOnce = PTHREAD_ONCE_INIT;
+
+static int64_t MonotonicNanos() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* xorshift64*; only needs to look like sensor noise */
+static uint64_t NextNoise(uint64_t& state) {
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 2685821657736338717ULL;
+}
+
+/* Roughly normal noise in [-3, 3] from the sum of uniforms */
+static float Gaussian(uint64_t& state) {
+	float sum = 0.0f;
+	for (int i = 0; i < 4; i++)
+		sum += (float) (NextNoise(state) >> 40) / (float) (1 << 24);
+	return (sum - 2.0f) * 1.7320508f;
+}
+
+static void MakeEvent(ASensorEventQueue* queue, const EnabledSensor& enabled,
+		int64_t when, ASensorEvent& event) {
+	const ASensor* sensor = enabled.m_sensor;
+
+	memset(&event, 0x00, sizeof(event));
+	event.version = sizeof(ASensorEvent);
+	event.sensor = enabled.m_handle;
+	event.type = sensor->m_type;
+
+	/* Delivery jitter of a few microseconds */
+	event.timestamp = when + (int64_t) (NextNoise(queue->m_noise) % 5000);
+
+	for (int c = 0; c < sensor->m_channels; c++) {
+		const float noise = Gaussian(queue->m_noise) * sensor->m_resolution
+				* 8.0f;
+		event.data[c] = sensor->m_base[c] + noise;
+	}
+
+	event.vector.status = ASENSOR_STATUS_ACCURACY_HIGH;
+}
+
+/* Generate every reading that has come due by now */
+static void PumpQueue(ASensorEventQueue* queue, int64_t now) {
+	for (size_t i = 0; i < queue->m_enabled.size(); i++) {
+		EnabledSensor& enabled = queue->m_enabled[i];
+
+		while (enabled.m_next <= now) {
+			if (queue->m_pending.size() >= MAX_PENDING_EVENTS)
+				queue->m_pending.pop_front();
+
+			ASensorEvent event;
+			MakeEvent(queue, enabled, enabled.m_next, event);
+			queue->m_pending.push_back(event);
+
+			enabled.m_next += enabled.m_period;
+		}
+	}
+}
+
+static int64_t NextDue(const ASensorEventQueue* queue) {
+	int64_t next = INT64_MAX;
+	for (size_t i = 0; i < queue->m_enabled.size(); i++)
+		next = std::min(next, queue->m_enabled[i].m_next);
+	return next;
+}
+
+static size_t SensorCount() {
+	const char* env = getenv("PRNG_HOST_SENSORS");
+	if (env == NULL)
+		return COUNTOF(s_sensors);
+
+	const long n = strtol(env, NULL, 10);
+	if (n < 0)
+		return 0;
+	return std::min((size_t) n, COUNTOF(s_sensors));
+}
+
+/***************************** log.h *****************************/
+
+int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+	static const char s_levels[] = "??VDIWEFS";
+
+	if (getenv("PRNG_HOST_LOG") == NULL)
+		return 0;
+
+	char level = '?';
+	if (prio >= 0 && prio < (int) sizeof(s_levels) - 1)
+		level = s_levels[prio];
+
+	va_list args;
+	va_start(args, fmt);
+
+	fprintf(stderr, "%c/%s: ", level, tag);
+	int n = vfprintf(stderr, fmt, args);
+	fputc('\n', stderr);
+
+	va_end(args);
+	return n;
+}
+
+/**************************** looper.h ***************************/
+
+static void DeleteLooper(void* data) {
+	ALooper* looper = reinterpret_cast<ALooper*>(data);
+	ALooper_release(looper);
+}
+
+static void CreateLooperKey() {
+	pthread_key_create(&s_looperKey, DeleteLooper);
+}
+
+ALooper* ALooper_forThread() {
+	pthread_once(&s_looperOnce, CreateLooperKey);
+	return reinterpret_cast<ALooper*>(pthread_getspecific(s_looperKey));
+}
+
+ALooper* ALooper_prepare(int) {
+	ALooper* looper = ALooper_forThread();
+	if (looper != NULL)
+		return looper;
+
+	looper = new ALooper;
+	pthread_mutex_init(&looper->m_lock, NULL);
+	pthread_cond_init(&looper->m_cond, NULL);
+	looper->m_woken = 0;
+	looper->m_refs = 1;
+
+	pthread_setspecific(s_looperKey, looper);
+	return looper;
+}
+
+void ALooper_acquire(ALooper* looper) {
+	__atomic_add_fetch(&looper->m_refs, 1, __ATOMIC_RELAXED);
+}
+
+void ALooper_release(ALooper* looper) {
+	if (__atomic_sub_fetch(&looper->m_refs, 1, __ATOMIC_ACQ_REL) == 0) {
+		pthread_cond_destroy(&looper->m_cond);
+		pthread_mutex_destroy(&looper->m_lock);
+		delete looper;
+	}
+}
+
+void ALooper_wake(ALooper* looper) {
+	pthread_mutex_lock(&looper->m_lock);
+	looper->m_woken = 1;
+	pthread_cond_broadcast(&looper->m_cond);
+	pthread_mutex_unlock(&looper->m_lock);
+}
+
+/* Sleep until the next reading is due, the timeout passes, or a */
+/*   wake. Ready queues run their callback, or report their ident */
+/*   when they have none.                                        */
+int ALooper_pollOnce(int timeoutMillis, int* outFd, int* outEvents,
+		void** outData) {
+	ALooper* looper = ALooper_forThread();
+	if (looper == NULL)
+		return ALOOPER_POLL_ERROR;
+
+	const int64_t start = MonotonicNanos();
+	const int64_t deadline =
+			timeoutMillis < 0 ?
+					INT64_MAX : start + (int64_t) timeoutMillis * 1000000LL;
+
+	for (;;) {
+		const int64_t now = MonotonicNanos();
+		int64_t due = INT64_MAX;
+		bool ran = false;
+
+		for (size_t i = 0; i < looper->m_queues.size(); i++) {
+			ASensorEventQueue* queue = looper->m_queues[i];
+			PumpQueue(queue, now);
+
+			if (queue->m_pending.empty()) {
+				due = std::min(due, NextDue(queue));
+				continue;
+			}
+
+			if (queue->m_callback == NULL) {
+				if (outFd)
+					*outFd = -1;
+				if (outEvents)
+					*outEvents = ALOOPER_EVENT_INPUT;
+				if (outData)
+					*outData = queue->m_data;
+				return queue->m_ident;
+			}
+
+			if (queue->m_callback(-1, ALOOPER_EVENT_INPUT, queue->m_data) == 0)
+				queue->m_callback = NULL;
+			ran = true;
+		}
+
+		if (ran)
+			return ALOOPER_POLL_CALLBACK;
+
+		if (now >= deadline)
+			return ALOOPER_POLL_TIMEOUT;
+
+		const int64_t until = std::min(due, deadline);
+
+		pthread_mutex_lock(&looper->m_lock);
+		if (!looper->m_woken) {
+			struct timespec ts;
+			clock_gettime(CLOCK_REALTIME, &ts);
+
+			const int64_t wait = until - now;
+			int64_t nsec = ts.tv_nsec + wait;
+			ts.tv_sec += (time_t) (nsec / 1000000000LL);
+			ts.tv_nsec = (long) (nsec % 1000000000LL);
+
+			pthread_cond_timedwait(&looper->m_cond, &looper->m_lock, &ts);
+		}
+
+		const int woken = looper->m_woken;
+		looper->m_woken = 0;
+		pthread_mutex_unlock(&looper->m_lock);
+
+		if (woken)
+			return ALOOPER_POLL_WAKE;
+	}
+}
+
+/**************************** sensor.h ***************************/
+
+ASensorManager* ASensorManager_getInstance() {
+	return &s_manager;
+}
+
+int ASensorManager_getSensorList(ASensorManager*, ASensorList* list) {
+	const size_t count = SensorCount();
+
+	for (size_t i = 0; i < count; i++)
+		s_sensorList[i] = &s_sensors[i];
+
+	*list = s_sensorList;
+	return (int) count;
+}
+
+ASensorEventQueue* ASensorManager_createEventQueue(ASensorManager*,
+		ALooper* looper, int ident, ALooper_callbackFunc callback, void* data) {
+	if (looper == NULL)
+		return NULL;
+
+	ASensorEventQueue* queue = new ASensorEventQueue;
+	queue->m_looper = looper;
+	queue->m_ident = ident;
+	queue->m_callback = callback;
+	queue->m_data = data;
+	queue->m_noise = (uint64_t) MonotonicNanos() | 1;
+
+	looper->m_queues.push_back(queue);
+	return queue;
+}
+
+int ASensorManager_destroyEventQueue(ASensorManager*, ASensorEventQueue* queue) {
+	if (queue == NULL)
+		return -EINVAL;
+
+	std::vector<ASensorEventQueue*>& queues = queue->m_looper->m_queues;
+	queues.erase(std::remove(queues.begin(), queues.end(), queue),
+			queues.end());
+
+	delete queue;
+	return 0;
+}
+
+int ASensorEventQueue_enableSensor(ASensorEventQueue* queue,
+		ASensor const* sensor) {
+	for (size_t i = 0; i < queue->m_enabled.size(); i++) {
+		if (queue->m_enabled[i].m_sensor == sensor)
+			return 0;
+	}
+
+	EnabledSensor enabled;
+	enabled.m_sensor = sensor;
+	enabled.m_handle = (int) (sensor - s_sensors) + 1;
+	enabled.m_period =
+			sensor->m_minDelay ?
+					(int64_t) sensor->m_minDelay * 1000 : ON_CHANGE_PERIOD_NS;
+
+	/* The first reading arrives one period after enabling */
+	enabled.m_next = MonotonicNanos() + enabled.m_period;
+
+	queue->m_enabled.push_back(enabled);
+	return 0;
+}
+
+int ASensorEventQueue_disableSensor(ASensorEventQueue* queue,
+		ASensor const* sensor) {
+	for (size_t i = 0; i < queue->m_enabled.size(); i++) {
+		if (queue->m_enabled[i].m_sensor == sensor) {
+			queue->m_enabled.erase(queue->m_enabled.begin() + i);
+			return 0;
+		}
+	}
+	return -EINVAL;
+}
+
+int ASensorEventQueue_setEventRate(ASensorEventQueue* queue,
+		ASensor const* sensor, int32_t usec) {
+	for (size_t i = 0; i < queue->m_enabled.size(); i++) {
+		EnabledSensor& enabled = queue->m_enabled[i];
+		if (enabled.m_sensor != sensor)
+			continue;
+
+		/* On-change sensors ignore the requested rate */
+		if (sensor->m_minDelay == 0)
+			return 0;
+
+		const int64_t period = (int64_t) std::max<int32_t>(usec,
+				sensor->m_minDelay) * 1000;
+		enabled.m_next += period - enabled.m_period;
+		enabled.m_period = period;
+		return 0;
+	}
+	return -EINVAL;
+}
+
+int ASensorEventQueue_hasEvents(ASensorEventQueue* queue) {
+	PumpQueue(queue, MonotonicNanos());
+	return queue->m_pending.empty() ? 0 : 1;
+}
+
+ssize_t ASensorEventQueue_getEvents(ASensorEventQueue* queue,
+		ASensorEvent* events, size_t count) {
+	PumpQueue(queue, MonotonicNanos());
+
+	size_t n = 0;
+	while (n < count && !queue->m_pending.empty()) {
+		events[n++] = queue->m_pending.front();
+		queue->m_pending.pop_front();
+	}
+
+	return (ssize_t) n;
+}
+
+const char* ASensor_getName(ASensor const* sensor) {
+	return sensor->m_name;
+}
+
+const char* ASensor_getVendor(ASensor const* sensor) {
+	return "Host";
+}
+
+int ASensor_getType(ASensor const* sensor) {
+	return sensor->m_type;
+}
+
+float ASensor_getResolution(ASensor const* sensor) {
+	return sensor->m_resolution;
+}
+
+int ASensor_getMinDelay(ASensor const* sensor) {
+	return sensor->m_minDelay;
+}
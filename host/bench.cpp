@@ -0,0 +1,405 @@
+/* Microbenchmarks for each stage of the generator pipeline: the    */
+/* entropy sources, pool mixing, and output generation from 1 byte */
+/* to 16 MB. Each case runs for a time budget and reports latency   */
+/* percentiles and throughput. The harvester is not started, so the */
+/* numbers are for the calling thread alone.                        */
+/*                                                                  */
+/* Usage: prng-bench [-t millis] [-m max-bytes] [-b backend]        */
+/*                   [-w file | -r file [-x speed]] [-p file]       */
+/*                   [-s file] [-j workers]                         */
+/*   -t  time budget per case, default 250 ms                       */
+/*   -m  largest GenerateBlock request, default 16 MB               */
+/*   -b  auto, pool, aes or chacha (see BackendType)                */
+/*   -w  record the sensor events collected to file                 */
+/*   -r  collect from a recording instead of the synthetic sensors  */
+/*   -x  replay speed, default 1; 0 replays without waiting         */
+/*   -p  cache sensor profiles in file                              */
+/*   -s  mix in and replace the seed file, as at app start          */
+/*   -j  split requests of 1 MB and up across this many workers     */
+
+#include "prng.h"
+#include "backend.h"
+#include "entropy.h"
+#include "stream.h"
+#include "fastrandom.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <cryptopp/secblock.h>
+using CryptoPP::SecByteBlock;
+
+/* Every case gets at least this many samples, whatever the budget. */
+static const size_t MIN_SAMPLES = 5;
+
+/* And no more than this many, so the sample vectors stay small. */
+static const size_t MAX_SAMPLES = 200000;
+
+static double s_budget = 250.0; /* milliseconds */
+
+static double NowInMilliSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static double Percentile(const std::vector<double>& sorted, double p) {
+	if (sorted.empty())
+		return 0.0;
+
+	size_t idx = (size_t) (p * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+static void PrintHeader() {
+	printf("%-20s %10s %8s %12s %12s %12s %12s\n", "stage", "bytes", "samples",
+			"p50 (us)", "p99 (us)", "p999 (us)", "MB/s");
+}
+
+/* Report one case. Throughput uses the bytes produced or consumed */
+/*   per call; sources report the bytes they mixed in.            */
+static void PrintCase(const char* stage, size_t bytes,
+		std::vector<double>& samples, double totalBytes) {
+	std::sort(samples.begin(), samples.end());
+
+	double total = 0.0;
+	for (size_t i = 0; i < samples.size(); i++)
+		total += samples[i];
+
+	const double mbps = total > 0.0 ? totalBytes / total : 0.0;
+
+	printf("%-20s %10lu %8lu %12.2f %12.2f %12.2f %12.2f\n", stage,
+			(unsigned long) bytes, (unsigned long) samples.size(),
+			Percentile(samples, 0.50), Percentile(samples, 0.99),
+			Percentile(samples, 0.999), mbps);
+	fflush(stdout);
+}
+
+/* Runs fn until the budget is spent. Returns the per-call latency */
+/*   in microseconds; bytes accumulates what each call returned.  */
+template<class FN>
+static std::vector<double> RunCase(FN fn, double& bytes) {
+	std::vector<double> samples;
+	const double stop = NowInMilliSeconds() + s_budget;
+
+	bytes = 0.0;
+	while (samples.size() < MAX_SAMPLES
+			&& (samples.size() < MIN_SAMPLES || NowInMilliSeconds() < stop)) {
+		const double start = NowInMilliSeconds();
+		bytes += fn();
+		samples.push_back((NowInMilliSeconds() - start) * 1000.0);
+	}
+
+	return samples;
+}
+
+/* The collector's per-channel estimates after the sensor case */
+static void PrintEstimates() {
+	std::vector<ChannelEstimate> estimates(ReadEntropyEstimates(NULL, 0));
+	if (estimates.empty())
+		return;
+
+	ReadEntropyEstimates(&estimates[0], estimates.size());
+
+	for (size_t i = 0; i < estimates.size(); i++) {
+		const ChannelEstimate& e = estimates[i];
+		printf("  type %2d channel %d: %6lu samples, %.2f bits/sample, "
+				"%lu RCT and %lu APT failures\n", e.m_type, e.m_channel,
+				e.m_samples, e.m_minEntropy, e.m_rctFailures, e.m_aptFailures);
+	}
+}
+
+/* The library's own stage timings (instrument.h), for comparison */
+static void PrintLatency() {
+	static const char* const names[STAGE_COUNT] = { "jni-pin", "jni-unpin",
+			"sensor-data", "random-device", "process-info", "mix", "generate",
+			"seed-load", "seed-save", "accumulate", "getrandom", "urandom",
+			"cpu-random", "parallel-chunk", "stream-wait", "daemon-request" };
+
+	unsigned long long latency[STAGE_COUNT * LATENCY_FIELDS];
+	const size_t stages = ReadLatency(latency, COUNTOF(latency));
+
+	printf("\n%-20s %10s %12s %12s\n", "stage", "samples", "mean us",
+			"max us");
+
+	for (size_t s = 0; s < stages; s++) {
+		const unsigned long long* f = latency + s * LATENCY_FIELDS;
+		if (f[LATENCY_COUNT] == 0)
+			continue;
+
+		printf("%-20s %10llu %12.2f %12.2f\n", names[s], f[LATENCY_COUNT],
+				f[LATENCY_TOTAL_NANOS] / 1000.0 / f[LATENCY_COUNT],
+				f[LATENCY_MAX_NANOS] / 1000.0);
+	}
+}
+
+struct ProcessInfoCase {
+	double operator()() {
+		return AddProcessInfo();
+	}
+};
+
+struct RandomDeviceCase {
+	double operator()() {
+		return AddRandomDevice();
+	}
+};
+
+struct SensorCase {
+	explicit SensorCase(SensorContext& context) :
+			m_context(context) {
+	}
+	double operator()() {
+		return AddSensorData(m_context);
+	}
+	SensorContext& m_context;
+};
+
+struct MixCase {
+	MixCase(const byte* input, size_t size) :
+			m_input(input), m_size(size) {
+	}
+	double operator()() {
+		IncorporateEntropy(m_input, m_size);
+		return (double) m_size;
+	}
+	const byte* m_input;
+	size_t m_size;
+};
+
+struct GenerateCase {
+	GenerateCase(byte* output, size_t size) :
+			m_output(output), m_size(size) {
+	}
+	double operator()() {
+		GenerateBlock(m_output, m_size);
+		return (double) m_size;
+	}
+	byte* m_output;
+	size_t m_size;
+};
+
+/* No harvester runs here, so a budget above 0 measures the kernel */
+/*   fallback, and 0 the pool-only path.                          */
+struct WithinCase {
+	WithinCase(byte* output, size_t size, double milliseconds) :
+			m_output(output), m_size(size), m_milliseconds(milliseconds) {
+	}
+	double operator()() {
+		(void) GenerateWithin(m_output, m_size, m_milliseconds);
+		return (double) m_size;
+	}
+	byte* m_output;
+	size_t m_size;
+	double m_milliseconds;
+};
+
+/* The non-cryptographic generator, for scale */
+struct FastCase {
+	FastCase(FastRandom& generator, byte* output, size_t size) :
+			m_generator(generator), m_output(output), m_size(size) {
+	}
+	double operator()() {
+		m_generator.FillBytes(m_output, m_size);
+		return (double) m_size;
+	}
+	FastRandom& m_generator;
+	byte* m_output;
+	size_t m_size;
+};
+
+/* Streams maxBytes to /dev/null through a RandomStream */
+struct StreamCase {
+	StreamCase(RandomStream& stream, int fd, size_t size) :
+			m_stream(stream), m_fd(fd), m_size(size) {
+	}
+	double operator()() {
+		return (double) m_stream.WriteTo(m_fd, m_size);
+	}
+	RandomStream& m_stream;
+	int m_fd;
+	size_t m_size;
+};
+
+static int ParseBackend(const char* name) {
+	if (strcmp(name, "auto") == 0)
+		return BACKEND_AUTO;
+	if (strcmp(name, "pool") == 0)
+		return BACKEND_POOL;
+	if (strcmp(name, "aes") == 0)
+		return BACKEND_AES_CTR;
+	if (strcmp(name, "chacha") == 0)
+		return BACKEND_CHACHA20;
+	return -1;
+}
+
+static void Usage(const char* program) {
+	fprintf(stderr, "Usage: %s [-t millis] [-m max-bytes] [-b backend]\n",
+			program);
+	fprintf(stderr, "          [-w file | -r file [-x speed]] [-p file]\n");
+	fprintf(stderr, "          [-s file] [-j workers]\n");
+	fprintf(stderr, "  backend is one of auto, pool, aes, chacha\n");
+}
+
+int main(int argc, char* argv[]) {
+	size_t maxBytes = 16 * 1024 * 1024;
+	int backend = BACKEND_AUTO;
+	const char* recordPath = NULL;
+	const char* replayPath = NULL;
+	double speed = 1.0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "t:m:b:w:r:x:p:s:j:h")) != -1) {
+		switch (opt) {
+		case 't':
+			s_budget = atof(optarg);
+			break;
+		case 'm':
+			maxBytes = (size_t) strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			backend = ParseBackend(optarg);
+			if (backend < 0) {
+				Usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'w':
+			recordPath = optarg;
+			break;
+		case 'r':
+			replayPath = optarg;
+			break;
+		case 'x':
+			speed = atof(optarg);
+			break;
+		case 'p':
+			SetSensorProfilePath(optarg);
+			break;
+		case 's':
+			printf("seed file: %s\n", SetSeedFilePath(optarg) ?
+					"mixed in saved seed" : "no saved seed");
+			break;
+		case 'j':
+			/* Split requests of 1 MiB and up across this many workers */
+			if (!ConfigureParallel(1024 * 1024, (size_t) atoi(optarg))) {
+				Usage(argv[0]);
+				return 1;
+			}
+			break;
+		default:
+			Usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (s_budget <= 0.0 || maxBytes == 0 || speed < 0.0
+			|| (recordPath && replayPath)) {
+		Usage(argv[0]);
+		return 1;
+	}
+
+	try {
+		if (!SelectBackend(backend)) {
+			fprintf(stderr, "Failed to select backend\n");
+			return 1;
+		}
+
+		printf("backend: %s, budget: %.0f ms per case\n\n",
+				BackendName((BackendType) GetBackend()), s_budget);
+		PrintHeader();
+
+		double bytes;
+		std::vector<double> samples;
+
+		/************* Sources *************/
+
+		samples = RunCase(ProcessInfoCase(), bytes);
+		PrintCase("AddProcessInfo", (size_t) (bytes / samples.size()),
+				samples, bytes);
+
+		samples = RunCase(RandomDeviceCase(), bytes);
+		PrintCase("AddRandomDevice", (size_t) (bytes / samples.size()),
+				samples, bytes);
+
+		/* Sessions belong to the thread that polls them */
+		SensorContext context;
+		const bool session =
+				replayPath ?
+						OpenReplaySession(context, replayPath, speed) :
+						OpenSensorSession(context);
+
+		if (session) {
+			if (recordPath && !StartSensorRecording(recordPath)) {
+				fprintf(stderr, "Failed to record to %s\n", recordPath);
+				return 1;
+			}
+
+			samples = RunCase(SensorCase(context), bytes);
+			PrintCase("AddSensorData", (size_t) (bytes / samples.size()),
+					samples, bytes);
+			PrintEstimates();
+
+			if (recordPath)
+				StopSensorRecording();
+
+			CloseSensorSession(context);
+		} else {
+			printf("%-20s (no sensors)\n", "AddSensorData");
+		}
+
+		/************* Mixing *************/
+
+		static const size_t mixSizes[] = { 16, 64, 256, 4096 };
+		SecByteBlock input(mixSizes[COUNTOF(mixSizes) - 1]);
+		memset(input.begin(), 0xA5, input.size());
+
+		for (size_t i = 0; i < COUNTOF(mixSizes); i++) {
+			samples = RunCase(MixCase(input.begin(), mixSizes[i]), bytes);
+			PrintCase("IncorporateEntropy", mixSizes[i], samples, bytes);
+		}
+
+		/************* Output *************/
+
+		SecByteBlock output(maxBytes);
+		for (size_t size = 1; size <= maxBytes; size *= 4) {
+			samples = RunCase(GenerateCase(output.begin(), size), bytes);
+			PrintCase("GenerateBlock", size, samples, bytes);
+		}
+
+		samples = RunCase(WithinCase(output.begin(), 32, 0.0), bytes);
+		PrintCase("GenerateWithin 0ms", 32, samples, bytes);
+
+		samples = RunCase(WithinCase(output.begin(), 32, 1.0), bytes);
+		PrintCase("GenerateWithin 1ms", 32, samples, bytes);
+
+		FastRandom fast(1);
+		for (size_t size = 64; size <= maxBytes; size *= 64) {
+			samples = RunCase(FastCase(fast, output.begin(), size), bytes);
+			PrintCase("FastRandom", size, samples, bytes);
+		}
+
+		RandomStream stream;
+		const int null = open("/dev/null", O_WRONLY | O_CLOEXEC);
+		if (null >= 0 && stream.Start()) {
+			samples = RunCase(StreamCase(stream, null, maxBytes), bytes);
+			PrintCase("RandomStream", maxBytes, samples, bytes);
+		}
+		if (null >= 0)
+			close(null);
+
+		PrintLatency();
+	} catch (const CryptoPP::Exception& ex) {
+		fprintf(stderr, "Crypto++ exception: %s\n", ex.what());
+		return 1;
+	}
+
+	return 0;
+}
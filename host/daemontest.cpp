@@ -0,0 +1,392 @@
+/* Many-client harness for the entropy daemon (daemon.h). Starts  */
+/* the daemon in this process on an abstract socket and forks      */
+/* clients that send batched seed and generate requests at it.     */
+/* Every output's first bytes come back over a pipe and must be    */
+/* unique across all clients. Also checks that a bad request is    */
+/* refused and that clients fall back to local collection when     */
+/* the daemon is absent. Runs on the local machine only.           */
+/*                                                                 */
+/* Usage: prng-daemon-test [-c clients] [-n requests] [-b batch]   */
+/*   -c  client processes, default 16, at most 64                  */
+/*   -n  requests per client, default 200                          */
+/*   -b  outputs per request, default 8                            */
+
+#include "prng.h"
+#include "daemon.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/* The daemon serves this many connections at once and refuses */
+/*   more (DAEMON_MAX_CLIENTS in daemon.cpp).                    */
+static const size_t MAX_CLIENTS = 64;
+
+/* Bytes of each output sent back to the parent. */
+static const size_t PREFIX_BYTES = 16;
+
+/* Bytes asked for by each generate request in a batch. */
+static const uint32_t GENERATE_BYTES = 256;
+
+/* A client's results, written once to the parent's results pipe. */
+struct ClientResult {
+	unsigned long m_requests;
+	unsigned long m_failures;
+	unsigned long m_seeds;
+	unsigned long long m_bytes;
+	double m_seconds;
+	double m_p50;
+	double m_p99;
+};
+
+static double NowInMilliSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static double Percentile(const std::vector<double>& sorted, double p) {
+	if (sorted.empty())
+		return 0.0;
+
+	size_t idx = (size_t) (p * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+static bool WriteFully(int fd, const void* data, size_t size) {
+	const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+	while (size > 0) {
+		const ssize_t n = write(fd, ptr, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		ptr += n;
+		size -= (size_t) n;
+	}
+
+	return true;
+}
+
+/* One client process. Alternates seed and generate batches, and */
+/*   mixes in one daemon seed the way the harvester does.        */
+static int RunClient(const char* path, size_t requests, size_t batch,
+		int prefixes, int results) {
+	if (!UseDaemon(path))
+		return 1;
+
+	ClientResult result;
+	memset(&result, 0x00, sizeof(result));
+
+	std::vector<uint32_t> lengths(batch);
+	std::vector<uint8_t> output(batch * GENERATE_BYTES);
+	std::vector<double> samples;
+
+	const double start = NowInMilliSeconds();
+
+	for (size_t i = 0; i < requests; i++) {
+		const DaemonOp op = (i % 2) ? DAEMON_OP_GENERATE : DAEMON_OP_SEED;
+		const uint32_t length =
+				op == DAEMON_OP_SEED ?
+						(uint32_t) DAEMON_MAX_SEED_BYTES : GENERATE_BYTES;
+		std::fill(lengths.begin(), lengths.end(), length);
+
+		const double t0 = NowInMilliSeconds();
+		const bool ok = DaemonRequestBatch(op, &lengths[0], batch, &output[0]);
+		samples.push_back((NowInMilliSeconds() - t0) * 1000.0);
+
+		result.m_requests++;
+		if (!ok) {
+			result.m_failures++;
+			continue;
+		}
+
+		result.m_bytes += (unsigned long long) length * batch;
+		for (size_t j = 0; j < batch; j++) {
+			if (!WriteFully(prefixes, &output[j * length], PREFIX_BYTES))
+				return 1;
+		}
+	}
+
+	result.m_seconds = (NowInMilliSeconds() - start) / 1000.0;
+
+	if (AddDaemonSeed() > 0)
+		result.m_seeds++;
+
+	std::sort(samples.begin(), samples.end());
+	result.m_p50 = Percentile(samples, 0.50);
+	result.m_p99 = Percentile(samples, 0.99);
+
+	return WriteFully(results, &result, sizeof(result)) ? 0 : 1;
+}
+
+/* Reads both pipes until every client has closed them. */
+static void Collect(int prefixes, int results,
+		std::vector<std::string>& heads, std::vector<ClientResult>& clients) {
+	std::string pending;
+	bool open[2] = { true, true };
+
+	while (open[0] || open[1]) {
+		struct pollfd fds[2];
+		fds[0].fd = open[0] ? prefixes : -1;
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+		fds[1].fd = open[1] ? results : -1;
+		fds[1].events = POLLIN;
+		fds[1].revents = 0;
+
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		char buff[4096];
+		if (fds[0].revents) {
+			const ssize_t n = read(prefixes, buff, sizeof(buff));
+			if (n <= 0) {
+				open[0] = false;
+			} else {
+				pending.append(buff, (size_t) n);
+				while (pending.size() >= PREFIX_BYTES) {
+					heads.push_back(pending.substr(0, PREFIX_BYTES));
+					pending.erase(0, PREFIX_BYTES);
+				}
+			}
+		}
+
+		if (fds[1].revents) {
+			ClientResult result;
+			const ssize_t n = read(results, &result, sizeof(result));
+			if (n <= 0)
+				open[1] = false;
+			else if ((size_t) n == sizeof(result))
+				clients.push_back(result);
+		}
+	}
+}
+
+/* Sends raw bytes to the daemon and returns the status it answers */
+/*   with, or -1 if it closed the connection without one.          */
+static int SendRaw(const char* path, const void* request, size_t size) {
+	sockaddr_un address;
+	memset(&address, 0x00, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+	address.sun_path[0] = '\0';
+
+	const socklen_t length = (socklen_t) (offsetof(sockaddr_un, sun_path)
+			+ strlen(path));
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+
+	int status = -1;
+	DaemonResponse response;
+	if (connect(fd, reinterpret_cast<sockaddr*>(&address), length) == 0
+			&& WriteFully(fd, request, size)
+			&& recv(fd, &response, sizeof(response), MSG_WAITALL)
+					== (ssize_t) sizeof(response)) {
+		status = response.m_status;
+	}
+
+	close(fd);
+	return status;
+}
+
+/* A bad magic and an oversized seed are both refused. */
+static bool CheckBadRequests(const char* path) {
+	struct {
+		DaemonRequest m_header;
+		uint32_t m_length;
+	} request;
+
+	memset(&request, 0x00, sizeof(request));
+	request.m_header.m_magic = 0x12345678;
+	request.m_header.m_version = DAEMON_VERSION;
+	request.m_header.m_op = DAEMON_OP_SEED;
+	request.m_header.m_count = 1;
+	request.m_length = 16;
+
+	const int magic = SendRaw(path, &request, sizeof(request));
+
+	request.m_header.m_magic = DAEMON_MAGIC;
+	request.m_length = DAEMON_MAX_SEED_BYTES + 1;
+
+	const int oversized = SendRaw(path, &request, sizeof(request));
+
+	printf("bad magic: status %d, oversized seed: status %d\n", magic,
+			oversized);
+
+	return magic == DAEMON_BAD_REQUEST && oversized == DAEMON_BAD_REQUEST;
+}
+
+/* With no daemon listening, a client's seed fails quickly and the */
+/*   harvester's path falls back to local collection.              */
+static bool CheckFallback(const char* path) {
+	fflush(stdout);
+
+	const pid_t pid = fork();
+	if (pid == 0) {
+		if (!UseDaemon(path))
+			_exit(1);
+
+		const double start = NowInMilliSeconds();
+		const int first = AddDaemonSeed();
+		const int second = AddDaemonSeed();
+		const double elapsed = NowInMilliSeconds() - start;
+
+		unsigned long long stats[STAT_COUNT];
+		ReadStats(stats, STAT_COUNT);
+
+		printf("fallback: %.2f ms, %llu fallbacks\n", elapsed,
+				stats[STAT_DAEMON_FALLBACKS]);
+		fflush(stdout);
+
+		_exit(first == 0 && second == 0 && AddRandomDevice() > 0 ? 0 : 1);
+	}
+
+	int status = 0;
+	return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status)
+			&& WEXITSTATUS(status) == 0;
+}
+
+static void Usage(const char* program) {
+	fprintf(stderr, "Usage: %s [-c clients] [-n requests] [-b batch]\n",
+			program);
+}
+
+int main(int argc, char* argv[]) {
+	size_t clients = 16, requests = 200, batch = 8;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "c:n:b:h")) != -1) {
+		switch (opt) {
+		case 'c':
+			clients = strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			requests = strtoul(optarg, NULL, 10);
+			break;
+		case 'b':
+			batch = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			Usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (clients == 0 || clients > MAX_CLIENTS || requests == 0 || batch == 0
+			|| batch > DAEMON_MAX_BATCH) {
+		Usage(argv[0]);
+		return 1;
+	}
+
+	char path[64];
+	snprintf(path, sizeof(path), "@prng-daemon-test-%d", (int) getpid());
+
+	if (!StartDaemon(path)) {
+		fprintf(stderr, "Failed to start the daemon on %s\n", path);
+		return 1;
+	}
+
+	int prefixes[2], results[2];
+	if (pipe(prefixes) != 0 || pipe(results) != 0) {
+		fprintf(stderr, "pipe failed, error %d\n", errno);
+		return 1;
+	}
+
+	fflush(stdout);
+
+	const double start = NowInMilliSeconds();
+
+	std::vector<pid_t> children;
+	for (size_t i = 0; i < clients; i++) {
+		const pid_t pid = fork();
+		if (pid == 0) {
+			close(prefixes[0]);
+			close(results[0]);
+			_exit(RunClient(path, requests, batch, prefixes[1], results[1]));
+		}
+		if (pid < 0) {
+			fprintf(stderr, "fork failed, error %d\n", errno);
+			break;
+		}
+		children.push_back(pid);
+	}
+
+	close(prefixes[1]);
+	close(results[1]);
+
+	std::vector<std::string> heads;
+	std::vector<ClientResult> done;
+	Collect(prefixes[0], results[0], heads, done);
+
+	close(prefixes[0]);
+	close(results[0]);
+
+	bool passed = children.size() == clients;
+	for (size_t i = 0; i < children.size(); i++) {
+		int status = 0;
+		if (waitpid(children[i], &status, 0) != children[i]
+				|| !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			passed = false;
+	}
+
+	const double elapsed = (NowInMilliSeconds() - start) / 1000.0;
+
+	unsigned long failures = 0, seeds = 0;
+	unsigned long long bytes = 0;
+	double p50 = 0.0, p99 = 0.0;
+	for (size_t i = 0; i < done.size(); i++) {
+		failures += done[i].m_failures;
+		seeds += done[i].m_seeds;
+		bytes += done[i].m_bytes;
+		p50 = std::max(p50, done[i].m_p50);
+		p99 = std::max(p99, done[i].m_p99);
+	}
+
+	std::sort(heads.begin(), heads.end());
+	const size_t unique = (size_t) (std::unique(heads.begin(), heads.end())
+			- heads.begin());
+
+	printf("%lu clients x %lu requests x %lu outputs: %.2f s, %.2f MB/s\n",
+			(unsigned long) clients, (unsigned long) requests,
+			(unsigned long) batch, elapsed,
+			elapsed > 0.0 ? bytes / elapsed / 1e6 : 0.0);
+	printf("worst client p50 %.2f us, p99 %.2f us\n", p50, p99);
+	printf("%lu outputs, %lu unique, %lu failed requests, %lu seeds\n",
+			(unsigned long) heads.size(), (unsigned long) unique, failures,
+			seeds);
+
+	const size_t expected = clients * requests * batch;
+	if (done.size() != clients || failures != 0 || heads.size() != expected
+			|| unique != expected || seeds != clients)
+		passed = false;
+
+	if (!CheckBadRequests(path))
+		passed = false;
+
+	StopDaemon();
+
+	if (!CheckFallback(path))
+		passed = false;
+
+	printf("%s\n", passed ? "PASSED" : "FAILED");
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,31 @@
+/* Host stand-in for <android/log.h>. Only what libprng uses. */
+/* Messages go to stderr when PRNG_HOST_LOG is set in the     */
+/* environment, and are dropped otherwise.                    */
+
+#ifndef _Included_host_android_log
+#define _Included_host_android_log
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum android_LogPriority {
+	ANDROID_LOG_UNKNOWN = 0,
+	ANDROID_LOG_DEFAULT,
+	ANDROID_LOG_VERBOSE,
+	ANDROID_LOG_DEBUG,
+	ANDROID_LOG_INFO,
+	ANDROID_LOG_WARN,
+	ANDROID_LOG_ERROR,
+	ANDROID_LOG_FATAL,
+	ANDROID_LOG_SILENT
+} android_LogPriority;
+
+int __android_log_print(int prio, const char* tag, const char* fmt, ...)
+		__attribute__((format(printf, 3, 4)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
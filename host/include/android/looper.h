@@ -0,0 +1,48 @@
+/* Host stand-in for <android/looper.h>. Only what libprng uses. */
+/* A looper here only knows about the sensor queues attached to  */
+/* it; see android_host.cpp.                                     */
+
+#ifndef _Included_host_android_looper
+#define _Included_host_android_looper
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ALooper;
+typedef struct ALooper ALooper;
+
+typedef int (*ALooper_callbackFunc)(int fd, int events, void* data);
+
+enum {
+	ALOOPER_PREPARE_ALLOW_NON_CALLBACKS = 1 << 0
+};
+
+enum {
+	ALOOPER_POLL_WAKE = -1,
+	ALOOPER_POLL_CALLBACK = -2,
+	ALOOPER_POLL_TIMEOUT = -3,
+	ALOOPER_POLL_ERROR = -4
+};
+
+enum {
+	ALOOPER_EVENT_INPUT = 1 << 0,
+	ALOOPER_EVENT_OUTPUT = 1 << 1,
+	ALOOPER_EVENT_ERROR = 1 << 2,
+	ALOOPER_EVENT_HANGUP = 1 << 3,
+	ALOOPER_EVENT_INVALID = 1 << 4
+};
+
+ALooper* ALooper_forThread();
+ALooper* ALooper_prepare(int opts);
+void ALooper_acquire(ALooper* looper);
+void ALooper_release(ALooper* looper);
+int ALooper_pollOnce(int timeoutMillis, int* outFd, int* outEvents,
+		void** outData);
+void ALooper_wake(ALooper* looper);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,151 @@
+/* Host stand-in for <android/sensor.h>. Only what libprng uses.  */
+/* The structures match the NDK layout so staging and extraction  */
+/* code sees the same bytes it sees on a device. Sensors and their */
+/* events are synthetic; see android_host.cpp.                    */
+
+#ifndef _Included_host_android_sensor
+#define _Included_host_android_sensor
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <android/looper.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+	ASENSOR_TYPE_ACCELEROMETER = 1,
+	ASENSOR_TYPE_MAGNETIC_FIELD = 2,
+	ASENSOR_TYPE_GYROSCOPE = 4,
+	ASENSOR_TYPE_LIGHT = 5,
+	ASENSOR_TYPE_PROXIMITY = 8
+};
+
+enum {
+	ASENSOR_STATUS_NO_CONTACT = -1,
+	ASENSOR_STATUS_UNRELIABLE = 0,
+	ASENSOR_STATUS_ACCURACY_LOW = 1,
+	ASENSOR_STATUS_ACCURACY_MEDIUM = 2,
+	ASENSOR_STATUS_ACCURACY_HIGH = 3
+};
+
+typedef struct ASensorVector {
+	union {
+		float v[3];
+		struct {
+			float x;
+			float y;
+			float z;
+		};
+		struct {
+			float azimuth;
+			float pitch;
+			float roll;
+		};
+	};
+	int8_t status;
+	uint8_t reserved[3];
+} ASensorVector;
+
+typedef struct AMetaDataEvent {
+	int32_t what;
+	int32_t sensor;
+} AMetaDataEvent;
+
+typedef struct AUncalibratedEvent {
+	union {
+		float uncalib[3];
+		struct {
+			float x_uncalib;
+			float y_uncalib;
+			float z_uncalib;
+		};
+	};
+	union {
+		float bias[3];
+		struct {
+			float x_bias;
+			float y_bias;
+			float z_bias;
+		};
+	};
+} AUncalibratedEvent;
+
+typedef struct AHeartRateEvent {
+	float bpm;
+	int8_t status;
+} AHeartRateEvent;
+
+typedef struct ASensorEvent {
+	int32_t version; /* sizeof(struct ASensorEvent) */
+	int32_t sensor;
+	int32_t type;
+	int32_t reserved0;
+	int64_t timestamp;
+	union {
+		union {
+			float data[16];
+			ASensorVector vector;
+			ASensorVector acceleration;
+			ASensorVector magnetic;
+			float temperature;
+			float distance;
+			float light;
+			float pressure;
+			float relative_humidity;
+			AUncalibratedEvent uncalibrated_gyro;
+			AUncalibratedEvent uncalibrated_magnetic;
+			AMetaDataEvent meta_data;
+			AHeartRateEvent heart_rate;
+		};
+		union {
+			uint64_t data[8];
+			uint64_t step_counter;
+		} u64;
+	};
+	uint32_t flags;
+	int32_t reserved1[3];
+} ASensorEvent;
+
+struct ASensorManager;
+typedef struct ASensorManager ASensorManager;
+
+struct ASensorEventQueue;
+typedef struct ASensorEventQueue ASensorEventQueue;
+
+struct ASensor;
+typedef struct ASensor ASensor;
+
+typedef ASensor const* ASensorRef;
+typedef ASensorRef const* ASensorList;
+
+ASensorManager* ASensorManager_getInstance();
+int ASensorManager_getSensorList(ASensorManager* manager, ASensorList* list);
+ASensorEventQueue* ASensorManager_createEventQueue(ASensorManager* manager,
+		ALooper* looper, int ident, ALooper_callbackFunc callback, void* data);
+int ASensorManager_destroyEventQueue(ASensorManager* manager,
+		ASensorEventQueue* queue);
+
+int ASensorEventQueue_enableSensor(ASensorEventQueue* queue,
+		ASensor const* sensor);
+int ASensorEventQueue_disableSensor(ASensorEventQueue* queue,
+		ASensor const* sensor);
+int ASensorEventQueue_setEventRate(ASensorEventQueue* queue,
+		ASensor const* sensor, int32_t usec);
+int ASensorEventQueue_hasEvents(ASensorEventQueue* queue);
+ssize_t ASensorEventQueue_getEvents(ASensorEventQueue* queue,
+		ASensorEvent* events, size_t count);
+
+const char* ASensor_getName(ASensor const* sensor);
+const char* ASensor_getVendor(ASensor const* sensor);
+int ASensor_getType(ASensor const* sensor);
+float ASensor_getResolution(ASensor const* sensor);
+int ASensor_getMinDelay(ASensor const* sensor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
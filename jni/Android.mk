@@ -24,11 +24,17 @@ LOCAL_SHARED_LIBRARIES  := cryptopp
 include $(CLEAR_VARS)
 
 LOCAL_MODULE := prng
-LOCAL_SRC_FILES := prng.cpp
+LOCAL_SRC_FILES := libprng.cpp prng.cpp backend.cpp sensorlog.cpp \
+    sensorprofile.cpp entropy.cpp instrument.cpp seedfile.cpp \
+    accumulator.cpp osrandom.cpp workerpool.cpp stream.cpp daemon.cpp \
+    fastrandom.cpp prngapi.cpp
 LOCAL_CPPFLAGS := -Wall -fvisibility=hidden
 LOCAL_CPP_FEATURES := rtti exceptions
 LOCAL_LDFLAGS := -Wl,--exclude-libs,ALL -Wl,--as-needed
 
+# ATrace is looked up with dlsym (instrument.cpp)
+LOCAL_LDLIBS := -ldl
+
 # Configure for release unless NDK_DEBUG=1
 ifeq ($(NDK_DEBUG),1)
     LOCAL_CPPFLAGS := $(LOCAL_CPPFLAGS) -DDEBUG
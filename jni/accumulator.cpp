@@ -0,0 +1,115 @@
+#include "prng.h"
+#include "accumulator.h"
+
+#include <sched.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <cryptopp/misc.h>
+using CryptoPP::SecureWipeBuffer;
+
+/* Spreads thread ids, which are often aligned pointers, over the */
+/*   shards.                                                      */
+static size_t ShardIndex() {
+	uint64_t id = (uint64_t) (uintptr_t) pthread_self();
+	id *= 0x9E3779B97F4A7C15ULL;
+	return (size_t) (id >> 32) % ACCUMULATOR_SHARDS;
+}
+
+EntropyAccumulator::EntropyAccumulator() {
+	memset(m_shards, 0x00, sizeof(m_shards));
+}
+
+EntropyAccumulator::~EntropyAccumulator() {
+	SecureWipeBuffer((uint8_t*) m_shards, sizeof(m_shards));
+}
+
+bool EntropyAccumulator::Append(const uint8_t* input, size_t length) {
+	if (length == 0)
+		return true;
+	if (length > ACCUMULATOR_SHARD_BYTES)
+		return false;
+
+	Shard& shard = m_shards[ShardIndex()];
+
+	for (;;) {
+		const int active = __atomic_load_n(&shard.m_active, __ATOMIC_SEQ_CST);
+		Half& half = shard.m_half[active];
+
+		/* Register, then check the half is still active. A drain */
+		/*   flips first and then waits for writers, so either it */
+		/*   sees this writer or this writer sees the flip.       */
+		__atomic_add_fetch(&half.m_writers, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&shard.m_active, __ATOMIC_SEQ_CST) != active) {
+			__atomic_sub_fetch(&half.m_writers, 1, __ATOMIC_RELEASE);
+			continue;
+		}
+
+		const unsigned int offset = __atomic_fetch_add(&half.m_reserved,
+				(unsigned int) length, __ATOMIC_RELAXED);
+
+		/* Appends that claimed space after this one start past the */
+		/*   end too, so the written bytes stay contiguous.         */
+		const bool fits = offset + length <= ACCUMULATOR_SHARD_BYTES;
+		if (fits) {
+			memcpy(half.m_data + offset, input, length);
+			__atomic_add_fetch(&half.m_committed, (unsigned int) length,
+					__ATOMIC_RELEASE);
+		}
+
+		__atomic_sub_fetch(&half.m_writers, 1, __ATOMIC_RELEASE);
+		return fits;
+	}
+}
+
+size_t EntropyAccumulator::Drain(uint8_t* output) {
+	size_t total = 0;
+
+	for (size_t i = 0; i < ACCUMULATOR_SHARDS; i++) {
+		Shard& shard = m_shards[i];
+
+		const int active = __atomic_load_n(&shard.m_active, __ATOMIC_SEQ_CST);
+		Half& half = shard.m_half[active];
+
+		/* Nothing staged, so no need to flip */
+		if (__atomic_load_n(&half.m_reserved, __ATOMIC_RELAXED) == 0)
+			continue;
+
+		__atomic_store_n(&shard.m_active, active ^ 1, __ATOMIC_SEQ_CST);
+
+		/* Appends finish with a memcpy of at most a shard */
+		while (__atomic_load_n(&half.m_writers, __ATOMIC_ACQUIRE) != 0)
+			sched_yield();
+
+		const size_t committed = __atomic_load_n(&half.m_committed,
+				__ATOMIC_ACQUIRE);
+
+		memcpy(output + total, half.m_data, committed);
+		SecureWipeBuffer(half.m_data, committed);
+		total += committed;
+
+		__atomic_store_n(&half.m_committed, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&half.m_reserved, 0, __ATOMIC_RELEASE);
+	}
+
+	return total;
+}
+
+void EntropyAccumulator::ResetAfterFork() {
+	for (size_t i = 0; i < ACCUMULATOR_SHARDS; i++) {
+		for (size_t h = 0; h < 2; h++) {
+			Half& half = m_shards[i].m_half[h];
+			__atomic_store_n(&half.m_writers, 0, __ATOMIC_RELAXED);
+
+			/* An unfinished append leaves a hole; drain what was claimed */
+			const unsigned int reserved = __atomic_load_n(&half.m_reserved,
+					__ATOMIC_RELAXED);
+			if (reserved > half.m_committed) {
+				__atomic_store_n(&half.m_committed,
+						std::min<unsigned int>(reserved,
+								ACCUMULATOR_SHARD_BYTES), __ATOMIC_RELAXED);
+			}
+		}
+	}
+}
@@ -0,0 +1,76 @@
+/* Entropy accumulator. Sources append raw input to sharded staging */
+/* buffers without taking a lock, and the input reaches the central */
+/* pool in one batched conditioning step when a reseed is due (see  */
+/* CommitEntropy in prng.cpp). Producers never wait on the pool, so */
+/* harvesting and Java reseeds run alongside output generation.     */
+
+#ifndef _Included_com_cryptopp_prng_accumulator
+#define _Included_com_cryptopp_prng_accumulator
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Shards, and the staging bytes in each. A thread always appends */
+/*   to the same shard, picked from its thread id. An input larger */
+/*   than a shard is never staged.                                 */
+static const size_t ACCUMULATOR_SHARDS = 8;
+static const size_t ACCUMULATOR_SHARD_BYTES = 2048;
+
+/* The most Drain can return. */
+static const size_t ACCUMULATOR_CAPACITY = ACCUMULATOR_SHARDS
+		* ACCUMULATOR_SHARD_BYTES;
+
+class EntropyAccumulator
+{
+public:
+	EntropyAccumulator();
+	~EntropyAccumulator();
+
+	/* Appends input to the calling thread's shard. Lock free, and    */
+	/*   safe from any number of threads. Returns false, staging       */
+	/*   nothing, if the shard does not have room; the caller drains   */
+	/*   and conditions the input itself.                              */
+	bool Append(const uint8_t* input, size_t length);
+
+	/* Moves everything staged into output, which must hold           */
+	/*   ACCUMULATOR_CAPACITY bytes, and wipes the staging buffers.    */
+	/*   Returns the bytes moved. Appends that race with a drain land  */
+	/*   in this drain or the next. One drainer at a time; the caller  */
+	/*   serializes drains.                                            */
+	size_t Drain(uint8_t* output);
+
+	/* Called in a forked child, where appends that were in flight in */
+	/*   other threads will never finish.                             */
+	void ResetAfterFork();
+
+private:
+	// Not copyable
+	EntropyAccumulator(const EntropyAccumulator&);
+	EntropyAccumulator& operator=(const EntropyAccumulator&);
+
+	/* Each shard is double buffered. Appends go to the active half; */
+	/*   a drain flips the active half, waits for the appends still  */
+	/*   writing to the old one, and then empties it.                */
+	struct Half {
+		uint8_t m_data[ACCUMULATOR_SHARD_BYTES];
+
+		// Bytes claimed by appends, which may run past the end when
+		// an append does not fit, and bytes actually written
+		unsigned int m_reserved;
+		unsigned int m_committed;
+
+		// Appends between claiming this half and finishing the copy
+		int m_writers;
+	};
+
+	/* Aligned so shards written by different threads do not share */
+	/*   cache lines.                                              */
+	struct Shard {
+		Half m_half[2];
+		int m_active;
+	} __attribute__((aligned(64)));
+
+	Shard m_shards[ACCUMULATOR_SHARDS];
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include <string.h>
+
+#include <new>
+using std::nothrow;
+
+#include <cryptopp/cpu.h>
+
+#include <cryptopp/secblock.h>
+using CryptoPP::SecByteBlock;
+
+#include <cryptopp/randpool.h>
+using CryptoPP::RandomPool;
+
+#include <cryptopp/sha.h>
+using CryptoPP::SHA256;
+
+#include <cryptopp/aes.h>
+using CryptoPP::AES;
+
+#include <cryptopp/modes.h>
+using CryptoPP::CTR_Mode;
+
+#include <cryptopp/chacha.h>
+using CryptoPP::ChaCha;
+
+#include "backend.h"
+
+/* Key size for the stream cipher backends. AES-256 and ChaCha20 */
+/* both take 32 byte keys.                                       */
+static const size_t STREAM_KEY_BYTES = 32;
+
+/* The existing Crypto++ RandomPool (AES-256 in an OFB style   */
+/* construction, with SHA-256 mixing), as used before the      */
+/* backends existed.                                           */
+class PoolBackend : public Backend
+{
+public:
+	BackendType GetType() const {
+		return BACKEND_POOL;
+	}
+
+	void IncorporateEntropy(const byte* input, size_t length) {
+		m_pool.IncorporateEntropy(input, length);
+	}
+
+	void GenerateBlock(byte* output, size_t size) {
+		m_pool.GenerateBlock(output, size);
+	}
+
+private:
+	RandomPool m_pool;
+};
+
+/* A stream cipher keystream generator with fast key erasure. Each */
+/* GenerateBlock is followed by drawing a fresh key from the same  */
+/* keystream, so a later compromise of the state does not reveal   */
+/* earlier output. Entropy is mixed in with SHA-256 over the old   */
+/* key and the input. The IV is fixed at zero; the key never       */
+/* repeats, so the keystream never does either.                    */
+template <class CIPHER, size_t IV_BYTES, BackendType TYPE>
+class StreamBackend : public Backend
+{
+public:
+	StreamBackend()
+	: m_key(STREAM_KEY_BYTES)
+	{
+		memset(m_key.begin(), 0x00, m_key.size());
+		Rekey();
+	}
+
+	BackendType GetType() const {
+		return TYPE;
+	}
+
+	void IncorporateEntropy(const byte* input, size_t length) {
+		SHA256 hash;
+		hash.Update(m_key.begin(), m_key.size());
+		hash.Update(input, length);
+		hash.Final(m_key.begin());
+
+		Rekey();
+	}
+
+	void GenerateBlock(byte* output, size_t size) {
+		m_cipher.GenerateBlock(output, size);
+
+		m_cipher.GenerateBlock(m_key.begin(), m_key.size());
+		Rekey();
+	}
+
+private:
+	void Rekey() {
+		const byte iv[IV_BYTES] = { 0 };
+		m_cipher.SetKeyWithIV(m_key.begin(), m_key.size(), iv, sizeof(iv));
+	}
+
+	typename CIPHER::Encryption m_cipher;
+	SecByteBlock m_key;
+};
+
+/* Crypto++ dispatches to AES-NI or the ARMv8 crypto extensions */
+/*   at runtime when the CPU has them.                          */
+typedef StreamBackend<CTR_Mode<AES>, AES::BLOCKSIZE, BACKEND_AES_CTR> AesCtrBackend;
+typedef StreamBackend<ChaCha, 8, BACKEND_CHACHA20> ChaChaBackend;
+
+static bool HasAesInstructions() {
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64)
+	return CryptoPP::HasAESNI();
+#elif (CRYPTOPP_BOOL_ARM32 || CRYPTOPP_BOOL_ARMV8)
+	return CryptoPP::HasAES();
+#else
+	return false;
+#endif
+}
+
+BackendType ResolveBackend(BackendType type) {
+	switch (type) {
+	case BACKEND_AUTO:
+		/* Software AES is slower than ChaCha20 and not constant time */
+		return HasAesInstructions() ? BACKEND_AES_CTR : BACKEND_CHACHA20;
+	case BACKEND_POOL:
+	case BACKEND_AES_CTR:
+	case BACKEND_CHACHA20:
+		return type;
+	default:
+		;
+	}
+	return BACKEND_AUTO;
+}
+
+const char* BackendName(BackendType type) {
+	switch (type) {
+	case BACKEND_AUTO:
+		return "Auto";
+	case BACKEND_POOL:
+		return "RandomPool";
+	case BACKEND_AES_CTR:
+		return "AES-CTR";
+	case BACKEND_CHACHA20:
+		return "ChaCha20";
+	default:
+		;
+	}
+	return "Unknown";
+}
+
+Backend* NewBackend(BackendType type) {
+	switch (ResolveBackend(type)) {
+	case BACKEND_POOL:
+		return new (nothrow) PoolBackend;
+	case BACKEND_AES_CTR:
+		return new (nothrow) AesCtrBackend;
+	case BACKEND_CHACHA20:
+		return new (nothrow) ChaChaBackend;
+	default:
+		;
+	}
+	return NULL;
+}
@@ -0,0 +1,46 @@
+#include <cryptopp/cryptlib.h>
+
+/* Generator backends for the per-thread generators */
+
+#ifndef _Included_com_cryptopp_prng_backend
+#define _Included_com_cryptopp_prng_backend
+
+/* The values are part of the Java API (see the BACKEND_* constants */
+/* in PRNG.java). BACKEND_AUTO picks the fastest secure backend for */
+/* the device: AES-CTR when the CPU has AES instructions, otherwise */
+/* ChaCha20.                                                        */
+enum BackendType {
+	BACKEND_AUTO = 0,
+	BACKEND_POOL = 1,
+	BACKEND_AES_CTR = 2,
+	BACKEND_CHACHA20 = 3
+};
+
+/* A seedable generator. A backend starts out unkeyed; callers must */
+/* call IncorporateEntropy before the first GenerateBlock. Methods  */
+/* throw Crypto++ exceptions. Backends are not thread safe.         */
+class Backend
+{
+public:
+	virtual ~Backend() {}
+
+	virtual BackendType GetType() const = 0;
+
+	/* Mix input into the key. Nothing already mixed in is lost. */
+	virtual void IncorporateEntropy(const byte* input, size_t length) = 0;
+
+	virtual void GenerateBlock(byte* output, size_t size) = 0;
+};
+
+/* Resolves BACKEND_AUTO to a concrete type. Returns BACKEND_AUTO */
+/* if type is not a known backend.                                */
+BackendType ResolveBackend(BackendType type);
+
+/* Returns a human readable name for logging. */
+const char* BackendName(BackendType type);
+
+/* Returns a new backend of the resolved type, or NULL if type is */
+/* not a known backend. The caller owns the backend.              */
+Backend* NewBackend(BackendType type);
+
+#endif
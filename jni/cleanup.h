@@ -1,5 +1,7 @@
 #include <jni.h>
 
+#include "instrument.h"
+
 /* Header for class com_deltoid_prng_cleanup */
 
 #ifndef _Included_com_deltoid_prng_cleanup
@@ -13,6 +15,7 @@ public:
 	{
 		if(m_env && m_arr)
 		{
+			TraceSection section(STAGE_JNI_PIN);
 			m_ptr = m_env->GetByteArrayElements(m_arr, NULL);
 			m_len = m_env->GetArrayLength(m_arr);
 		}
@@ -22,6 +25,7 @@ public:
 	{
 		if(m_env && m_arr)
 		{
+			TraceSection section(STAGE_JNI_UNPIN);
 			m_env->ReleaseByteArrayElements(m_arr, m_ptr, JNI_ABORT);
 		}
 	}
@@ -52,6 +56,7 @@ public:
 	{
 		if(m_env && m_arr)
 		{
+			TraceSection section(STAGE_JNI_PIN);
 			m_ptr = m_env->GetByteArrayElements(m_arr, NULL);
 			m_len = m_env->GetArrayLength(m_arr);
 		}
@@ -61,6 +66,7 @@ public:
 	{
 		if(m_env && m_arr)
 		{
+			TraceSection section(STAGE_JNI_UNPIN);
 			m_env->ReleaseByteArrayElements(m_arr, m_ptr, 0);
 		}
 	}
@@ -83,4 +89,308 @@ private:
 	jint m_len;
 };
 
+/* Pins the array with GetPrimitiveArrayCritical, so ART hands back */
+/* the heap array instead of a copy. No JNI calls may be made while */
+/* the buffer is alive, and it should not be held for long since it */
+/* may hold off the garbage collector.                              */
+class ReadCriticalBuffer
+{
+public:
+	explicit ReadCriticalBuffer(JNIEnv*& env, jbyteArray& barr)
+	: m_env(env), m_arr(barr), m_ptr(NULL), m_len(0)
+	{
+		if(m_env && m_arr)
+		{
+			TraceSection section(STAGE_JNI_PIN);
+			m_len = m_env->GetArrayLength(m_arr);
+			m_ptr = m_env->GetPrimitiveArrayCritical(m_arr, NULL);
+		}
+	}
+
+	~ReadCriticalBuffer()
+	{
+		if(m_env && m_arr && m_ptr)
+		{
+			TraceSection section(STAGE_JNI_UNPIN);
+			m_env->ReleasePrimitiveArrayCritical(m_arr, m_ptr, JNI_ABORT);
+		}
+	}
+
+	const byte* GetByteArray() const {
+		return (const byte*) m_ptr;
+	}
+
+	size_t GetArrayLen() const {
+		if(m_len < 0)
+			return 0;
+		return (size_t) m_len;
+	}
+
+private:
+	JNIEnv*& m_env;
+	jbyteArray& m_arr;
+
+	void* m_ptr;
+	jint m_len;
+};
+
+class WriteCriticalBuffer
+{
+public:
+	explicit WriteCriticalBuffer(JNIEnv*& env, jbyteArray& barr)
+	: m_env(env), m_arr(barr), m_ptr(NULL), m_len(0)
+	{
+		if(m_env && m_arr)
+		{
+			TraceSection section(STAGE_JNI_PIN);
+			m_len = m_env->GetArrayLength(m_arr);
+			m_ptr = m_env->GetPrimitiveArrayCritical(m_arr, NULL);
+		}
+	}
+
+	~WriteCriticalBuffer()
+	{
+		if(m_env && m_arr && m_ptr)
+		{
+			TraceSection section(STAGE_JNI_UNPIN);
+			m_env->ReleasePrimitiveArrayCritical(m_arr, m_ptr, 0);
+		}
+	}
+
+	byte* GetByteArray() const {
+		return (byte*) m_ptr;
+	}
+
+	size_t GetArrayLen() const {
+		if(m_len < 0)
+			return 0;
+		return (size_t) m_len;
+	}
+
+private:
+	JNIEnv*& m_env;
+	jbyteArray& m_arr;
+
+	void* m_ptr;
+	jint m_len;
+};
+
+/* Critical section over a primitive array of any type (int[],   */
+/* long[], double[], float[]). Same rules as WriteCriticalBuffer. */
+template <class T>
+class WriteCriticalArray
+{
+public:
+	explicit WriteCriticalArray(JNIEnv*& env, jarray arr)
+	: m_env(env), m_arr(arr), m_ptr(NULL), m_len(0)
+	{
+		if(m_env && m_arr)
+		{
+			TraceSection section(STAGE_JNI_PIN);
+			m_len = m_env->GetArrayLength(m_arr);
+			m_ptr = m_env->GetPrimitiveArrayCritical(m_arr, NULL);
+		}
+	}
+
+	~WriteCriticalArray()
+	{
+		if(m_env && m_arr && m_ptr)
+		{
+			TraceSection section(STAGE_JNI_UNPIN);
+			m_env->ReleasePrimitiveArrayCritical(m_arr, m_ptr, 0);
+		}
+	}
+
+	T* GetArray() const {
+		return (T*) m_ptr;
+	}
+
+	size_t GetArrayLen() const {
+		if(m_len < 0)
+			return 0;
+		return (size_t) m_len;
+	}
+
+private:
+	JNIEnv*& m_env;
+	jarray m_arr;
+
+	void* m_ptr;
+	jint m_len;
+};
+
+/* Largest output generated, or seed mixed in, inside a critical    */
+/* section. Smaller than MIN_PARALLEL_THRESHOLD in prng.cpp, so a   */
+/* pinned request is never split across the worker pool.            */
+static const jint MAX_CRITICAL_BYTES = 32 * 1024;
+
+/* Seed array for the generator. Seeds of up to MAX_CRITICAL_BYTES  */
+/* are pinned like ReadCriticalBuffer. A larger seed is hashed into */
+/* the pool under the pool lock, so it is taken with                */
+/* GetByteArrayElements like ReadByteBuffer instead.                */
+class ReadInputBuffer
+{
+public:
+	explicit ReadInputBuffer(JNIEnv*& env, jbyteArray& barr, jint wanted = -1)
+	: m_env(env), m_arr(barr), m_ptr(NULL), m_len(0), m_critical(false)
+	{
+		if(m_env && m_arr)
+		{
+			TraceSection section(STAGE_JNI_PIN);
+			m_len = m_env->GetArrayLength(m_arr);
+			m_critical = (wanted < 0 ? m_len : wanted) <= MAX_CRITICAL_BYTES;
+			if(m_critical)
+				m_ptr = m_env->GetPrimitiveArrayCritical(m_arr, NULL);
+			else
+				m_ptr = m_env->GetByteArrayElements(m_arr, NULL);
+		}
+	}
+
+	~ReadInputBuffer()
+	{
+		if(m_env && m_arr && m_ptr)
+		{
+			TraceSection section(STAGE_JNI_UNPIN);
+			if(m_critical)
+				m_env->ReleasePrimitiveArrayCritical(m_arr, m_ptr, JNI_ABORT);
+			else
+				m_env->ReleaseByteArrayElements(m_arr, (jbyte*) m_ptr, JNI_ABORT);
+		}
+	}
+
+	const byte* GetByteArray() const {
+		return (const byte*) m_ptr;
+	}
+
+	size_t GetArrayLen() const {
+		if(m_len < 0)
+			return 0;
+		return (size_t) m_len;
+	}
+
+private:
+	JNIEnv*& m_env;
+	jbyteArray& m_arr;
+
+	void* m_ptr;
+	jint m_len;
+	bool m_critical;
+};
+
+/* Output array for the generator. Writes of up to                 */
+/* MAX_CRITICAL_BYTES pin the array like WriteCriticalBuffer.      */
+/* Larger ones may wait on the worker pool, so they take the array */
+/* with GetByteArrayElements like WriteByteBuffer and the garbage  */
+/* collector is not held off meanwhile.                            */
+class WriteOutputBuffer
+{
+public:
+	explicit WriteOutputBuffer(JNIEnv*& env, jbyteArray& barr, jint wanted = -1)
+	: m_env(env), m_arr(barr), m_ptr(NULL), m_len(0), m_critical(false)
+	{
+		if(m_env && m_arr)
+		{
+			TraceSection section(STAGE_JNI_PIN);
+			m_len = m_env->GetArrayLength(m_arr);
+			m_critical = (wanted < 0 ? m_len : wanted) <= MAX_CRITICAL_BYTES;
+			if(m_critical)
+				m_ptr = m_env->GetPrimitiveArrayCritical(m_arr, NULL);
+			else
+				m_ptr = m_env->GetByteArrayElements(m_arr, NULL);
+		}
+	}
+
+	~WriteOutputBuffer()
+	{
+		if(m_env && m_arr && m_ptr)
+		{
+			TraceSection section(STAGE_JNI_UNPIN);
+			if(m_critical)
+				m_env->ReleasePrimitiveArrayCritical(m_arr, m_ptr, 0);
+			else
+				m_env->ReleaseByteArrayElements(m_arr, (jbyte*) m_ptr, 0);
+		}
+	}
+
+	byte* GetByteArray() const {
+		return (byte*) m_ptr;
+	}
+
+	size_t GetArrayLen() const {
+		if(m_len < 0)
+			return 0;
+		return (size_t) m_len;
+	}
+
+private:
+	JNIEnv*& m_env;
+	jbyteArray& m_arr;
+
+	void* m_ptr;
+	jint m_len;
+	bool m_critical;
+};
+
+/* The memory behind a direct java.nio.ByteBuffer. Nothing to pin */
+/* or release, so output is written straight into it.             */
+class DirectByteBuffer
+{
+public:
+	explicit DirectByteBuffer(JNIEnv*& env, jobject& buffer)
+	: m_ptr(NULL), m_len(0)
+	{
+		if(env && buffer)
+		{
+			m_ptr = env->GetDirectBufferAddress(buffer);
+			m_len = env->GetDirectBufferCapacity(buffer);
+		}
+	}
+
+	byte* GetByteArray() const {
+		return (byte*) m_ptr;
+	}
+
+	size_t GetArrayLen() const {
+		if(m_len < 0)
+			return 0;
+		return (size_t) m_len;
+	}
+
+private:
+	void* m_ptr;
+	jlong m_len;
+};
+
+/* Modified UTF-8 chars of a java.lang.String, such as a file path. */
+class ReadStringChars
+{
+public:
+	explicit ReadStringChars(JNIEnv*& env, jstring& str)
+	: m_env(env), m_str(str), m_ptr(NULL)
+	{
+		if(m_env && m_str)
+		{
+			m_ptr = m_env->GetStringUTFChars(m_str, NULL);
+		}
+	}
+
+	~ReadStringChars()
+	{
+		if(m_env && m_str && m_ptr)
+		{
+			m_env->ReleaseStringUTFChars(m_str, m_ptr);
+		}
+	}
+
+	const char* GetChars() const {
+		return m_ptr;
+	}
+
+private:
+	JNIEnv*& m_env;
+	jstring& m_str;
+
+	const char* m_ptr;
+};
+
 #endif
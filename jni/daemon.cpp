@@ -0,0 +1,646 @@
+#include "prng.h"
+#include "daemon.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <new>
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <cryptopp/cryptlib.h>
+using CryptoPP::Exception;
+
+#include <cryptopp/misc.h>
+using CryptoPP::SecureWipeBuffer;
+
+#include <cryptopp/secblock.h>
+using CryptoPP::SecByteBlock;
+
+/* Connections served at once; more are closed on accept. */
+static const size_t DAEMON_MAX_CLIENTS = 64;
+static const int DAEMON_BACKLOG = 16;
+
+/* A client gives up on a daemon that does not answer in this */
+/*   long, and does not try it again for the retry interval.  */
+static const int DAEMON_TIMEOUT_IN_MILLISECONDS = 250;
+static const double DAEMON_RETRY_INTERVAL_IN_MILLISECONDS = 5.0f * 1000;
+
+/* Server state, guarded by s_serverLock. */
+struct DaemonServer {
+	DaemonServer() :
+			m_running(false), m_stopping(false), m_listen(-1), m_clients(0) {
+		m_wake[0] = m_wake[1] = -1;
+	}
+
+	bool m_running;
+	string m_path;
+
+	// Set while StopDaemon runs with the lock released. Other callers
+	// wait on s_serverCond for it to clear
+	bool m_stopping;
+
+	int m_listen;
+	pthread_t m_thread;
+
+	// Written by StopDaemon to wake the accept loop
+	int m_wake[2];
+
+	// Open connections. StopDaemon shuts them down and waits for
+	// m_clients to reach 0
+	vector<int> m_fds;
+	size_t m_clients;
+};
+
+static DaemonServer s_server;
+static pthread_mutex_t s_serverLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_serverCond = PTHREAD_COND_INITIALIZER;
+
+/* Client state, guarded by s_clientLock. One connection per */
+/*   process; requests from several threads take turns.       */
+struct DaemonClient {
+	DaemonClient() :
+			m_fd(-1), m_retryAt(0.0) {
+	}
+
+	string m_path;
+	int m_fd;
+
+	// MonotonicNanoSeconds() in ms before which a failed daemon is
+	// not tried again
+	double m_retryAt;
+};
+
+static DaemonClient s_client;
+static pthread_mutex_t s_clientLock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t s_forkOnce = PTHREAD_ONCE_INIT;
+
+static double NowInMilliSeconds() {
+	return (double) MonotonicNanoSeconds() / 1e6;
+}
+
+/* Fills address from path. Returns false if path does not fit. */
+static bool MakeAddress(const char* path, sockaddr_un& address,
+		socklen_t& length) {
+	memset(&address, 0x00, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	const size_t size = strlen(path);
+	if (size == 0 || size >= sizeof(address.sun_path)) {
+		LOG_ERROR("Daemon: socket path %s is not valid", path);
+		return false;
+	}
+
+	memcpy(address.sun_path, path, size);
+
+	/* Abstract names start with a NUL and are not terminated */
+	if (path[0] == '@')
+		address.sun_path[0] = '\0';
+
+	length = (socklen_t) (offsetof(sockaddr_un, sun_path) + size
+			+ (path[0] == '@' ? 0 : 1));
+	return true;
+}
+
+/* Loop over short transfers and EINTR. send with MSG_NOSIGNAL, */
+/*   so a peer that went away is an error and not a SIGPIPE.     */
+static bool RecvFully(int fd, void* buffer, size_t size) {
+	uint8_t* ptr = reinterpret_cast<uint8_t*>(buffer);
+	while (size > 0) {
+		const ssize_t n = recv(fd, ptr, size, 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		ptr += n;
+		size -= (size_t) n;
+	}
+
+	return true;
+}
+
+static bool SendFully(int fd, const void* buffer, size_t size) {
+	const uint8_t* ptr = reinterpret_cast<const uint8_t*>(buffer);
+	while (size > 0) {
+		const ssize_t n = send(fd, ptr, size, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		ptr += n;
+		size -= (size_t) n;
+	}
+
+	return true;
+}
+
+static bool SendResponse(int fd, DaemonStatus status, size_t count,
+		const uint8_t* output, size_t length) {
+	DaemonResponse response;
+	memset(&response, 0x00, sizeof(response));
+	response.m_magic = DAEMON_MAGIC;
+	response.m_version = DAEMON_VERSION;
+	response.m_status = (uint8_t) status;
+	response.m_count = (uint16_t) count;
+	response.m_length = (uint32_t) length;
+
+	return SendFully(fd, &response, sizeof(response))
+			&& (length == 0 || SendFully(fd, output, length));
+}
+
+/* Returns the total response size, or 0 if the request is bad. */
+static size_t CheckRequest(const DaemonRequest& request,
+		const uint32_t* lengths) {
+	if (request.m_op != DAEMON_OP_SEED && request.m_op != DAEMON_OP_GENERATE)
+		return 0;
+
+	size_t total = 0;
+	for (size_t i = 0; i < request.m_count; i++) {
+		if (lengths[i] == 0)
+			return 0;
+		if (request.m_op == DAEMON_OP_SEED
+				&& lengths[i] > DAEMON_MAX_SEED_BYTES)
+			return 0;
+		if (lengths[i] > DAEMON_MAX_RESPONSE_BYTES - total)
+			return 0;
+
+		total += lengths[i];
+	}
+
+	return total;
+}
+
+/* Only peers running as the server's user, or root, are served. */
+static bool IsTrustedPeer(int fd) {
+	struct ucred credentials;
+	socklen_t size = sizeof(credentials);
+
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0) {
+		LOG_ERROR("Daemon: SO_PEERCRED failed, error %d", errno);
+		return false;
+	}
+
+	if (credentials.uid != getuid() && credentials.uid != 0) {
+		LOG_WARN("Daemon: refused pid %d, uid %d", (int )credentials.pid,
+				(int )credentials.uid);
+		return false;
+	}
+
+	return true;
+}
+
+/* Serves one connection until the peer closes it or sends a bad */
+/*   request. The whole batch is generated in one call.          */
+static void ServeClient(int fd) {
+	SecByteBlock output;
+	uint32_t lengths[DAEMON_MAX_BATCH];
+
+	for (;;) {
+		DaemonRequest request;
+		if (!RecvFully(fd, &request, sizeof(request)))
+			break;
+
+		if (request.m_magic != DAEMON_MAGIC
+				|| request.m_version != DAEMON_VERSION || request.m_count == 0
+				|| request.m_count > DAEMON_MAX_BATCH) {
+			(void) SendResponse(fd, DAEMON_BAD_REQUEST, 0, NULL, 0);
+			break;
+		}
+
+		if (!RecvFully(fd, lengths, request.m_count * sizeof(uint32_t)))
+			break;
+
+		const size_t total = CheckRequest(request, lengths);
+		if (total == 0) {
+			(void) SendResponse(fd, DAEMON_BAD_REQUEST, 0, NULL, 0);
+			break;
+		}
+
+		if (output.size() < total)
+			output.CleanNew(total);
+
+		DaemonStatus status = DAEMON_OK;
+		try {
+			GenerateBlock(output.data(), total);
+		} catch (const Exception& ex) {
+			LOG_ERROR("Daemon: Crypto++ exception: \"%s\"", ex.what());
+			status = DAEMON_FAILED;
+		}
+
+		const bool sent =
+				status == DAEMON_OK ?
+						SendResponse(fd, status, request.m_count,
+								output.data(), total) :
+						SendResponse(fd, status, 0, NULL, 0);
+
+		SecureWipeBuffer(output.data(), total);
+		AddStat(STAT_DAEMON_REQUESTS);
+
+		if (!sent)
+			break;
+	}
+}
+
+static void* ClientThread(void* data) {
+	const int fd = (int) (intptr_t) data;
+
+	if (IsTrustedPeer(fd))
+		ServeClient(fd);
+
+	MutexLock lock(s_serverLock);
+
+	for (size_t i = 0; i < s_server.m_fds.size(); i++) {
+		if (s_server.m_fds[i] == fd) {
+			s_server.m_fds.erase(s_server.m_fds.begin() + i);
+			break;
+		}
+	}
+
+	close(fd);
+
+	s_server.m_clients--;
+	pthread_cond_broadcast(&s_serverCond);
+
+	return NULL;
+}
+
+/* Takes ownership of fd. */
+static void AcceptClient(int fd) {
+	MutexLock lock(s_serverLock);
+
+	if (s_server.m_clients >= DAEMON_MAX_CLIENTS) {
+		LOG_WARN("Daemon: %d clients, refusing another",
+				(int )s_server.m_clients);
+		close(fd);
+		return;
+	}
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	pthread_t thread;
+	int rc = pthread_create(&thread, &attr, ClientThread,
+			(void*) (intptr_t) fd);
+	pthread_attr_destroy(&attr);
+
+	if (rc != 0) {
+		LOG_ERROR("Daemon: pthread_create failed, error %d", rc);
+		close(fd);
+		return;
+	}
+
+	s_server.m_fds.push_back(fd);
+	s_server.m_clients++;
+}
+
+static void* AcceptThread(void*) {
+	LOG_DEBUG("Entered AcceptThread");
+
+	for (;;) {
+		struct pollfd fds[2];
+		fds[0].fd = s_server.m_listen;
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+		fds[1].fd = s_server.m_wake[0];
+		fds[1].events = POLLIN;
+		fds[1].revents = 0;
+
+		const int n = poll(fds, 2, -1);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 || fds[1].revents)
+			break;
+		if (!(fds[0].revents & POLLIN))
+			continue;
+
+		const int fd = accept(s_server.m_listen, NULL, NULL);
+		if (fd < 0) {
+			if (errno != EINTR && errno != ECONNABORTED) {
+				LOG_WARN("Daemon: accept failed, error %d", errno);
+			}
+			continue;
+		}
+
+		(void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+		AcceptClient(fd);
+	}
+
+	return NULL;
+}
+
+static void CloseServerSockets() {
+	if (s_server.m_listen >= 0)
+		close(s_server.m_listen);
+	if (s_server.m_wake[0] >= 0) {
+		close(s_server.m_wake[0]);
+		close(s_server.m_wake[1]);
+	}
+
+	s_server.m_listen = -1;
+	s_server.m_wake[0] = s_server.m_wake[1] = -1;
+}
+
+static void Disconnect() {
+	if (s_client.m_fd >= 0)
+		close(s_client.m_fd);
+
+	s_client.m_fd = -1;
+}
+
+/* Both locks are held across fork, so a child never inherits one */
+/*   held by a thread that did not come with it. The child keeps   */
+/*   neither the server, whose threads are gone, nor the parent's  */
+/*   connection, whose replies would interleave with the parent's. */
+static void LockDaemon() {
+	pthread_mutex_lock(&s_clientLock);
+	pthread_mutex_lock(&s_serverLock);
+}
+
+static void UnlockDaemon() {
+	pthread_mutex_unlock(&s_serverLock);
+	pthread_mutex_unlock(&s_clientLock);
+}
+
+static void ChildAfterFork() {
+	if (s_server.m_running) {
+		for (size_t i = 0; i < s_server.m_fds.size(); i++)
+			close(s_server.m_fds[i]);
+
+		s_server.m_fds.clear();
+		s_server.m_clients = 0;
+		CloseServerSockets();
+		s_server.m_running = false;
+	}
+	s_server.m_stopping = false;
+
+	Disconnect();
+
+	UnlockDaemon();
+}
+
+static void InstallForkHandlers() {
+	int rc = pthread_atfork(LockDaemon, UnlockDaemon, ChildAfterFork);
+	if (rc != 0) {
+		LOG_ERROR("Daemon: pthread_atfork failed, error %d", rc);
+	}
+}
+
+int StartDaemon(const char* path) {
+	if (path == NULL) {
+		LOG_ERROR("Daemon: socket path is NULL");
+		return 0;
+	}
+
+	sockaddr_un address;
+	socklen_t length;
+	if (!MakeAddress(path, address, length))
+		return 0;
+
+	pthread_once(&s_forkOnce, InstallForkHandlers);
+
+	MutexLock lock(s_serverLock);
+
+	/* Let a stop in progress finish before serving again */
+	while (s_server.m_stopping)
+		pthread_cond_wait(&s_serverCond, &s_serverLock);
+
+	if (s_server.m_running) {
+		LOG_DEBUG("Daemon: already serving %s", s_server.m_path.c_str());
+		return 1;
+	}
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		LOG_ERROR("Daemon: socket failed, error %d", errno);
+		return 0;
+	}
+
+	(void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+	s_server.m_listen = fd;
+
+	/* A file left behind by a server that died */
+	if (path[0] != '@')
+		(void) unlink(path);
+
+	if (bind(fd, reinterpret_cast<sockaddr*>(&address), length) != 0
+			|| listen(fd, DAEMON_BACKLOG) != 0) {
+		LOG_ERROR("Daemon: failed to listen on %s, error %d", path, errno);
+		CloseServerSockets();
+		return 0;
+	}
+
+	if (pipe(s_server.m_wake) != 0) {
+		LOG_ERROR("Daemon: pipe failed, error %d", errno);
+		s_server.m_wake[0] = s_server.m_wake[1] = -1;
+		CloseServerSockets();
+		return 0;
+	}
+
+	(void) fcntl(s_server.m_wake[0], F_SETFD, FD_CLOEXEC);
+	(void) fcntl(s_server.m_wake[1], F_SETFD, FD_CLOEXEC);
+
+	int rc = pthread_create(&s_server.m_thread, NULL, AcceptThread, NULL);
+	if (rc != 0) {
+		LOG_ERROR("Daemon: pthread_create failed, error %d", rc);
+		CloseServerSockets();
+		return 0;
+	}
+
+	s_server.m_running = true;
+	s_server.m_path = path;
+
+	LOG_INFO("Daemon: serving %s", path);
+
+	return 1;
+}
+
+/* Returns 1 if this call stopped the daemon. A concurrent caller */
+/*   waits for that stop to finish and returns 0.                  */
+int StopDaemon() {
+	MutexLock lock(s_serverLock);
+
+	if (s_server.m_stopping) {
+		while (s_server.m_stopping)
+			pthread_cond_wait(&s_serverCond, &s_serverLock);
+		return 0;
+	}
+
+	if (!s_server.m_running) {
+		LOG_DEBUG("Daemon: not running");
+		return 0;
+	}
+
+	/* Only this caller joins the accept thread */
+	s_server.m_stopping = true;
+
+	const char wake = 1;
+	(void) write(s_server.m_wake[1], &wake, 1);
+
+	pthread_mutex_unlock(&s_serverLock);
+	pthread_join(s_server.m_thread, NULL);
+	pthread_mutex_lock(&s_serverLock);
+
+	/* Wakes each client thread out of recv */
+	for (size_t i = 0; i < s_server.m_fds.size(); i++)
+		(void) shutdown(s_server.m_fds[i], SHUT_RDWR);
+
+	while (s_server.m_clients != 0)
+		pthread_cond_wait(&s_serverCond, &s_serverLock);
+
+	if (s_server.m_path[0] != '@')
+		(void) unlink(s_server.m_path.c_str());
+
+	CloseServerSockets();
+	s_server.m_running = false;
+	s_server.m_stopping = false;
+	pthread_cond_broadcast(&s_serverCond);
+
+	LOG_INFO("Daemon: stopped serving %s", s_server.m_path.c_str());
+
+	return 1;
+}
+
+/* True if this process is the daemon, which harvests for itself. */
+static bool IsServing() {
+	MutexLock lock(s_serverLock);
+	return s_server.m_running;
+}
+
+/* Opens the connection if there is none. The caller holds s_clientLock. */
+static bool Connect() {
+	if (s_client.m_fd >= 0)
+		return true;
+
+	if (NowInMilliSeconds() < s_client.m_retryAt)
+		return false;
+
+	sockaddr_un address;
+	socklen_t length;
+	if (!MakeAddress(s_client.m_path.c_str(), address, length))
+		return false;
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		LOG_ERROR("Daemon: socket failed, error %d", errno);
+		return false;
+	}
+
+	(void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	struct timeval timeout;
+	timeout.tv_sec = DAEMON_TIMEOUT_IN_MILLISECONDS / 1000;
+	timeout.tv_usec = (DAEMON_TIMEOUT_IN_MILLISECONDS % 1000) * 1000;
+	(void) setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	(void) setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	if (connect(fd, reinterpret_cast<sockaddr*>(&address), length) != 0) {
+		LOG_DEBUG("Daemon: no daemon at %s, error %d", s_client.m_path.c_str(),
+				errno);
+		close(fd);
+		s_client.m_retryAt = NowInMilliSeconds()
+				+ DAEMON_RETRY_INTERVAL_IN_MILLISECONDS;
+		return false;
+	}
+
+	s_client.m_fd = fd;
+
+	LOG_DEBUG("Daemon: connected to %s", s_client.m_path.c_str());
+
+	return true;
+}
+
+int UseDaemon(const char* path) {
+	sockaddr_un address;
+	socklen_t length;
+	if (path != NULL && !MakeAddress(path, address, length))
+		return 0;
+
+	pthread_once(&s_forkOnce, InstallForkHandlers);
+
+	MutexLock lock(s_clientLock);
+
+	Disconnect();
+	s_client.m_path = path ? path : "";
+	s_client.m_retryAt = 0.0;
+
+	LOG_INFO("Daemon: %s%s", path ? "using " : "local collection",
+			path ? path : "");
+
+	return 1;
+}
+
+bool DaemonRequestBatch(DaemonOp op, const uint32_t* lengths, size_t count,
+		uint8_t* output) {
+	if (count == 0 || count > DAEMON_MAX_BATCH)
+		return false;
+
+	size_t total = 0;
+	for (size_t i = 0; i < count; i++)
+		total += lengths[i];
+
+	MutexLock lock(s_clientLock);
+
+	if (s_client.m_path.empty() || IsServing())
+		return false;
+
+	if (!Connect()) {
+		AddStat(STAT_DAEMON_FALLBACKS);
+		return false;
+	}
+
+	TraceSection section(STAGE_DAEMON_REQUEST);
+
+	/* Header and lengths go out in one send */
+	uint8_t request[sizeof(DaemonRequest) + DAEMON_MAX_BATCH * sizeof(uint32_t)];
+	DaemonRequest header;
+	memset(&header, 0x00, sizeof(header));
+	header.m_magic = DAEMON_MAGIC;
+	header.m_version = DAEMON_VERSION;
+	header.m_op = (uint8_t) op;
+	header.m_count = (uint16_t) count;
+
+	memcpy(request, &header, sizeof(header));
+	memcpy(request + sizeof(header), lengths, count * sizeof(uint32_t));
+
+	DaemonResponse response;
+	bool ok = SendFully(s_client.m_fd, request,
+			sizeof(header) + count * sizeof(uint32_t))
+			&& RecvFully(s_client.m_fd, &response, sizeof(response));
+
+	ok = ok && response.m_magic == DAEMON_MAGIC
+			&& response.m_version == DAEMON_VERSION
+			&& response.m_status == DAEMON_OK && response.m_count == count
+			&& response.m_length == total
+			&& RecvFully(s_client.m_fd, output, total);
+
+	if (!ok) {
+		LOG_WARN("Daemon: request to %s failed", s_client.m_path.c_str());
+		Disconnect();
+		s_client.m_retryAt = NowInMilliSeconds()
+				+ DAEMON_RETRY_INTERVAL_IN_MILLISECONDS;
+		AddStat(STAT_DAEMON_FALLBACKS);
+		return false;
+	}
+
+	return true;
+}
+
+bool DaemonSeed(uint8_t* seed, size_t size) {
+	if (size == 0 || size > DAEMON_MAX_SEED_BYTES)
+		return false;
+
+	const uint32_t length = (uint32_t) size;
+	return DaemonRequestBatch(DAEMON_OP_SEED, &length, 1, seed);
+}
@@ -0,0 +1,77 @@
+/* Entropy daemon. One process runs the harvester and serves seed  */
+/* material and output to the app's other processes over a Unix    */
+/* domain socket, so they skip their own sensor rounds. Clients     */
+/* reseed their local generator from it and fall back to local      */
+/* collection when it is absent. Only peers running under the       */
+/* server's uid (or root) are served.                               */
+/*                                                                  */
+/* A path starting with '@' names a socket in the abstract          */
+/* namespace, which needs no file and goes away with the server.    */
+
+#ifndef _Included_com_cryptopp_prng_daemon
+#define _Included_com_cryptopp_prng_daemon
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Protocol. A request is a DaemonRequest and m_count uint32_t      */
+/*   lengths; the response is a DaemonResponse and, on success, the */
+/*   requested outputs back to back, m_length bytes in all. Fields  */
+/*   are in host order since both ends share the device. Clients    */
+/*   may pipeline requests; responses come back in order. A bad     */
+/*   request is answered with DAEMON_BAD_REQUEST and the server     */
+/*   closes the connection.                                         */
+
+static const uint32_t DAEMON_MAGIC = 0x444E5250; /* "PRND" */
+static const uint8_t DAEMON_VERSION = 1;
+
+enum DaemonOp {
+	DAEMON_OP_SEED = 1, DAEMON_OP_GENERATE = 2
+};
+
+enum DaemonStatus {
+	DAEMON_OK = 0, DAEMON_BAD_REQUEST = 1, DAEMON_FAILED = 2
+};
+
+/* Limits on one request: lengths per batch, bytes per seed, and */
+/*   bytes in a response.                                        */
+static const size_t DAEMON_MAX_BATCH = 64;
+static const size_t DAEMON_MAX_SEED_BYTES = 64;
+static const size_t DAEMON_MAX_RESPONSE_BYTES = 1024 * 1024;
+
+struct DaemonRequest {
+	uint32_t m_magic;
+	uint8_t m_version;
+	uint8_t m_op;
+	uint16_t m_count;
+};
+
+struct DaemonResponse {
+	uint32_t m_magic;
+	uint8_t m_version;
+	uint8_t m_status;
+	uint16_t m_count;
+	uint32_t m_length;
+};
+
+/* Server. Returns 1 if the daemon is listening on path. */
+int StartDaemon(const char* path);
+
+/* Returns 1 if the daemon was stopped, 0 if it was not running. */
+int StopDaemon();
+
+/* Client. Points the process at a daemon; NULL goes back to local */
+/*   collection. Connects lazily. Returns 1 on success.            */
+int UseDaemon(const char* path);
+
+/* Sends one batched request: count outputs of lengths[i] bytes, */
+/*   written back to back to output. Returns false if no daemon  */
+/*   is in use or it could not be reached; a failed daemon is    */
+/*   retried after DAEMON_RETRY_INTERVAL_IN_MILLISECONDS.        */
+bool DaemonRequestBatch(DaemonOp op, const uint32_t* lengths, size_t count,
+		uint8_t* output);
+
+/* Fetches one seed of size bytes. */
+bool DaemonSeed(uint8_t* seed, size_t size);
+
+#endif
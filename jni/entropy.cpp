@@ -0,0 +1,294 @@
+#include "entropy.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+/* False positive rate for both health tests, alpha = 2^-20. */
+static const double HEALTH_ALPHA_BITS = 20.0;
+
+/* Adaptive proportion window for non-binary samples. */
+static const unsigned int APT_WINDOW = 512;
+
+/* Samples before a channel's estimate is credited. Until then the */
+/*   health tests run against ASSUMED_MIN_ENTROPY.                 */
+static const unsigned long WARMUP_SAMPLES = 128;
+static const double ASSUMED_MIN_ENTROPY = 1.0;
+
+/* The histogram is halved when it reaches this many samples, so the */
+/*   estimate follows a sensor whose behaviour changes.              */
+static const unsigned long HISTOGRAM_LIMIT = 8192;
+
+/* Samples are bytes, but neighbouring samples of a channel are not */
+/*   independent, so no channel is credited more than 3 bits a      */
+/*   sample. An estimate below the floor is treated as no entropy.  */
+static const double MAX_MIN_ENTROPY = 3.0;
+static const double MIN_CREDITED_ENTROPY = 0.1;
+
+/* Lag predictors for the prediction estimate: repeat the previous */
+/*   sample, and extend the previous step.                         */
+enum Predictor {
+	PREDICT_REPEAT = 0, PREDICT_STEP, PREDICTORS
+};
+
+/* 99% upper confidence bound, as in 90B section 6.3.1 */
+static const double MCV_Z = 2.576;
+
+struct EntropyEstimator::Channel {
+	Channel(int type, int channel) :
+			m_total(0), m_max(0), m_prev(0), m_step(0), m_history(0), m_predictions(
+					0), m_estimate(ASSUMED_MIN_ENTROPY), m_last(0), m_run(0), m_rctCutoff(
+					0), m_aptFirst(0), m_aptCount(0), m_aptSeen(0), m_aptCutoff(
+					0), m_failed(false) {
+		memset(m_histogram, 0x00, sizeof(m_histogram));
+		memset(m_hits, 0x00, sizeof(m_hits));
+		m_info.m_type = type;
+		m_info.m_channel = channel;
+		UpdateCutoffs();
+	}
+
+	void UpdateCutoffs();
+	void UpdateEstimate();
+
+	ChannelEstimate m_info;
+
+	// Most common value estimate
+	uint32_t m_histogram[256];
+	unsigned long m_total;
+	uint32_t m_max;
+
+	// Prediction estimate: the last sample and step, how many of
+	// them are known (0 to 2), and each predictor's hits
+	uint8_t m_prev;
+	uint8_t m_step;
+	unsigned int m_history;
+	unsigned long m_predictions;
+	unsigned long m_hits[PREDICTORS];
+
+	// The credited estimate, the lower of the two and the cap
+	double m_estimate;
+
+	// Repetition count test
+	uint8_t m_last;
+	unsigned int m_run;
+	unsigned int m_rctCutoff;
+
+	// Adaptive proportion test
+	uint8_t m_aptFirst;
+	unsigned int m_aptCount;
+	unsigned int m_aptSeen;
+	unsigned int m_aptCutoff;
+
+	// Set by a health test failure, cleared by BeginRound
+	bool m_failed;
+};
+
+/* 99% upper bound on a proportion of hits in n trials. */
+static double UpperBound(double hits, double n) {
+	const double p = hits / n;
+	return std::min(1.0,
+			p + MCV_Z * sqrt(p * (1.0 - p) / std::max(n - 1.0, 1.0)));
+}
+
+/* Smallest c with P(X >= c) <= 2^-20 for X ~ Binomial(n, p). */
+static unsigned int BinomialCutoff(unsigned int n, double p) {
+	const double alpha = pow(2.0, -HEALTH_ALPHA_BITS);
+
+	if (p >= 1.0)
+		return n;
+
+	/* Walk the upper tail down from n, in log space */
+	double tail = 0.0;
+	const double lp = log(p), lq = log1p(-p);
+
+	for (unsigned int k = n; k > 0; k--) {
+		const double lpmf = lgamma(n + 1.0) - lgamma(k + 1.0)
+				- lgamma(n - k + 1.0) + k * lp + (n - k) * lq;
+		tail += exp(lpmf);
+		if (tail > alpha)
+			return k + 1;
+	}
+
+	return 1;
+}
+
+void EntropyEstimator::Channel::UpdateCutoffs() {
+	const double h = std::max(m_estimate, MIN_CREDITED_ENTROPY);
+
+	/* 90B section 4.4.1: C = 1 + ceil(-log2(alpha) / H) */
+	m_rctCutoff = 1 + (unsigned int) ceil(HEALTH_ALPHA_BITS / h);
+
+	/* 90B section 4.4.2 */
+	m_aptCutoff = std::min(APT_WINDOW,
+			BinomialCutoff(APT_WINDOW, pow(2.0, -h)));
+}
+
+void EntropyEstimator::Channel::UpdateEstimate() {
+	const double mcv = -log2(UpperBound(m_max, (double) m_total));
+
+	/* The best predictor's hit rate, never below a uniform guess */
+	double prediction = MAX_MIN_ENTROPY;
+	if (m_predictions > 0) {
+		unsigned long hits = 0;
+		for (int i = 0; i < PREDICTORS; i++)
+			hits = std::max(hits, m_hits[i]);
+
+		const double p = std::max(1.0 / 256,
+				UpperBound((double) hits, (double) m_predictions));
+		prediction = -log2(p);
+	}
+
+	m_estimate = std::max(0.0,
+			std::min(MAX_MIN_ENTROPY, std::min(mcv, prediction)));
+
+	m_info.m_samples = m_total;
+	m_info.m_minEntropy = m_estimate;
+}
+
+ChannelEstimate::ChannelEstimate() :
+		m_type(0), m_channel(0), m_samples(0), m_minEntropy(0.0), m_rctFailures(
+				0), m_aptFailures(0) {
+}
+
+EntropyEstimator::EntropyEstimator() :
+		m_rctFailures(0), m_aptFailures(0) {
+}
+
+EntropyEstimator::~EntropyEstimator() {
+	for (size_t i = 0; i < m_channels.size(); i++)
+		delete m_channels[i];
+}
+
+void EntropyEstimator::BeginRound() {
+	for (size_t i = 0; i < m_channels.size(); i++)
+		m_channels[i]->m_failed = false;
+}
+
+EntropyEstimator::Channel* EntropyEstimator::FindChannel(int type,
+		int channel) {
+	for (size_t i = 0; i < m_channels.size(); i++) {
+		Channel* c = m_channels[i];
+		if (c->m_info.m_type == type && c->m_info.m_channel == channel)
+			return c;
+	}
+
+	Channel* c = new Channel(type, channel);
+	m_channels.push_back(c);
+	return c;
+}
+
+double EntropyEstimator::ObserveSample(Channel& c, uint8_t sample) {
+
+	/************ Repetition count test ************/
+
+	if (c.m_info.m_samples > 0 && sample == c.m_last) {
+		if (++c.m_run >= c.m_rctCutoff) {
+			c.m_info.m_rctFailures++;
+			m_rctFailures++;
+			c.m_failed = true;
+			c.m_run = 1;
+		}
+	} else {
+		c.m_last = sample;
+		c.m_run = 1;
+	}
+
+	/*********** Adaptive proportion test **********/
+
+	if (c.m_aptSeen == 0) {
+		c.m_aptFirst = sample;
+		c.m_aptCount = 1;
+		c.m_aptSeen = 1;
+	} else {
+		if (sample == c.m_aptFirst && ++c.m_aptCount >= c.m_aptCutoff) {
+			c.m_info.m_aptFailures++;
+			m_aptFailures++;
+			c.m_failed = true;
+			c.m_aptSeen = 0;
+		} else if (++c.m_aptSeen >= APT_WINDOW) {
+			c.m_aptSeen = 0;
+		}
+	}
+
+	/*********** Prediction estimate ***************/
+
+	if (c.m_history > 0) {
+		if (sample == c.m_prev)
+			c.m_hits[PREDICT_REPEAT]++;
+		if (c.m_history > 1 && sample == (uint8_t) (c.m_prev + c.m_step))
+			c.m_hits[PREDICT_STEP]++;
+
+		c.m_predictions++;
+		c.m_step = (uint8_t) (sample - c.m_prev);
+	}
+
+	c.m_prev = sample;
+	if (c.m_history < 2)
+		c.m_history++;
+
+	/******** Most common value estimate **********/
+
+	const uint32_t count = ++c.m_histogram[sample];
+	c.m_max = std::max(c.m_max, count);
+	c.m_total++;
+
+	if (c.m_total >= HISTOGRAM_LIMIT) {
+		c.m_max = 0;
+		c.m_total = 0;
+		for (size_t i = 0; i < 256; i++) {
+			c.m_histogram[i] /= 2;
+			c.m_max = std::max(c.m_max, c.m_histogram[i]);
+			c.m_total += c.m_histogram[i];
+		}
+
+		c.m_predictions /= 2;
+		for (int i = 0; i < PREDICTORS; i++)
+			c.m_hits[i] /= 2;
+	}
+
+	c.UpdateEstimate();
+
+	/* New cutoffs at each adaptive proportion window */
+	if (c.m_aptSeen == 0)
+		c.UpdateCutoffs();
+
+	if (c.m_failed || c.m_info.m_samples < WARMUP_SAMPLES
+			|| c.m_estimate < MIN_CREDITED_ENTROPY)
+		return 0.0;
+
+	return c.m_estimate;
+}
+
+double EntropyEstimator::Observe(const ASensorEvent& event, int channels) {
+	channels = std::min(channels, ENTROPY_VALUE_CHANNELS);
+
+	double credited = ObserveSample(*FindChannel(event.type, 0),
+			(uint8_t) event.timestamp);
+
+	for (int i = 0; i < channels; i++) {
+		uint32_t bits;
+		memcpy(&bits, &event.data[i], sizeof(bits));
+
+		credited += ObserveSample(*FindChannel(event.type, i + 1),
+				(uint8_t) bits);
+	}
+
+	return credited;
+}
+
+unsigned long EntropyEstimator::RctFailures() const {
+	return m_rctFailures;
+}
+
+unsigned long EntropyEstimator::AptFailures() const {
+	return m_aptFailures;
+}
+
+size_t EntropyEstimator::Snapshot(ChannelEstimate* estimates,
+		size_t count) const {
+	for (size_t i = 0; i < count && i < m_channels.size(); i++)
+		estimates[i] = m_channels[i]->m_info;
+
+	return m_channels.size();
+}
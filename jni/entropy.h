@@ -0,0 +1,82 @@
+/* Online entropy estimation for sensor channels, after NIST       */
+/* SP 800-90B. Each channel (the timestamp, and each value word of  */
+/* a sensor type) is sampled as the low byte of the field the       */
+/* collector stages. Every sample runs through the repetition count */
+/* and adaptive proportion health tests (90B section 4.4), and      */
+/* feeds two min-entropy estimates: most common value (section      */
+/* 6.3.1), which assumes IID samples, and a prediction estimate     */
+/* (after section 6.3.8) that catches counters and steady steps,    */
+/* which timestamps are. Healthy channels are credited the lower    */
+/* of the two per sample, capped well below the 8 bits of a byte.   */
+/* The health test cutoffs use the same figure.                     */
+
+#ifndef _Included_com_cryptopp_prng_entropy
+#define _Included_com_cryptopp_prng_entropy
+
+#include <android/sensor.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+/* Channel 0 is the timestamp; 1 to ENTROPY_VALUE_CHANNELS are the */
+/*   value words. Matches MAX_SENSOR_CHANNELS.                     */
+static const int ENTROPY_VALUE_CHANNELS = 6;
+
+/* A channel's state, also returned by EntropyEstimator::Snapshot. */
+struct ChannelEstimate {
+	ChannelEstimate();
+
+	int m_type;
+	int m_channel;
+
+	// Samples in the estimate, and the estimate in bits per sample
+	unsigned long m_samples;
+	double m_minEntropy;
+
+	// Health test failures since the process started
+	unsigned long m_rctFailures;
+	unsigned long m_aptFailures;
+};
+
+class EntropyEstimator
+{
+public:
+	EntropyEstimator();
+	~EntropyEstimator();
+
+	/* Starts a collection round. Channels that failed a health test */
+	/*   in the last round are credited again.                       */
+	void BeginRound();
+
+	/* Tests and estimates one event's channels. channels is the   */
+	/*   number of value words staged for the type. Returns the    */
+	/*   bits credited, 0 for channels that are still warming up  */
+	/*   or have failed a health test this round.                  */
+	double Observe(const ASensorEvent& event, int channels);
+
+	/* Health test failures in every channel, since construction. */
+	unsigned long RctFailures() const;
+	unsigned long AptFailures() const;
+
+	/* Copies up to count channel estimates. Returns the number of */
+	/*   channels, which may be more than count.                  */
+	size_t Snapshot(ChannelEstimate* estimates, size_t count) const;
+
+private:
+	// Not copyable
+	EntropyEstimator(const EntropyEstimator&);
+	EntropyEstimator& operator=(const EntropyEstimator&);
+
+	struct Channel;
+
+	Channel* FindChannel(int type, int channel);
+	double ObserveSample(Channel& channel, uint8_t sample);
+
+	std::vector<Channel*> m_channels;
+	unsigned long m_rctFailures;
+	unsigned long m_aptFailures;
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "prng.h"
+#include "fastrandom.h"
+
+#include <string.h>
+
+#include <new>
+
+/* xoshiro256** jump polynomials: 2^128 and 2^192 steps. */
+static const uint64_t JUMP[4] = { 0x180ec6d33cfd0abaull,
+		0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+static const uint64_t LONG_JUMP[4] = { 0x76e15d3efefdcbbfull,
+		0xc5004e441c522fb3ull, 0x77710069854ee241ull, 0x39109bb02acbe635ull };
+
+static inline uint64_t RotateLeft(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t SplitMix64(uint64_t& state) {
+	uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+FastRandom::FastRandom(uint64_t seed) :
+		m_pos(FAST_RANDOM_LANES) {
+	/* SplitMix64 never gives four zero words in a row, so the */
+	/*   state is never the all zero fixed point               */
+	for (size_t j = 0; j < 4; j++)
+		m_state[j][0] = SplitMix64(seed);
+
+	for (size_t i = 1; i < FAST_RANDOM_LANES; i++) {
+		for (size_t j = 0; j < 4; j++)
+			m_state[j][i] = m_state[j][i - 1];
+		JumpLane(i, JUMP);
+	}
+
+	memset(m_out, 0x00, sizeof(m_out));
+}
+
+/* Each loop runs over the lanes with no dependency between them, */
+/*   which is what the vectorizer needs. The multiplies by 5 and  */
+/*   9 are written as shifts, since NEON and SSE2 have no 64-bit  */
+/*   multiply.                                                    */
+void FastRandom::Step(uint64_t* out) {
+	uint64_t* s0 = m_state[0];
+	uint64_t* s1 = m_state[1];
+	uint64_t* s2 = m_state[2];
+	uint64_t* s3 = m_state[3];
+
+	for (size_t i = 0; i < FAST_RANDOM_LANES; i++) {
+		const uint64_t x = (s1[i] << 2) + s1[i];
+		const uint64_t r = RotateLeft(x, 7);
+		out[i] = (r << 3) + r;
+	}
+
+	for (size_t i = 0; i < FAST_RANDOM_LANES; i++) {
+		const uint64_t t = s1[i] << 17;
+
+		s2[i] ^= s0[i];
+		s3[i] ^= s1[i];
+		s1[i] ^= s2[i];
+		s0[i] ^= s3[i];
+
+		s2[i] ^= t;
+		s3[i] = RotateLeft(s3[i], 45);
+	}
+}
+
+void FastRandom::JumpLane(size_t lane, const uint64_t* polynomial) {
+	uint64_t s[4] = { 0, 0, 0, 0 };
+
+	for (size_t w = 0; w < 4; w++) {
+		for (int b = 0; b < 64; b++) {
+			if (polynomial[w] & (1ull << b)) {
+				for (size_t j = 0; j < 4; j++)
+					s[j] ^= m_state[j][lane];
+			}
+
+			/* One step of this lane alone */
+			const uint64_t t = m_state[1][lane] << 17;
+
+			m_state[2][lane] ^= m_state[0][lane];
+			m_state[3][lane] ^= m_state[1][lane];
+			m_state[1][lane] ^= m_state[2][lane];
+			m_state[0][lane] ^= m_state[3][lane];
+
+			m_state[2][lane] ^= t;
+			m_state[3][lane] = RotateLeft(m_state[3][lane], 45);
+		}
+	}
+
+	for (size_t j = 0; j < 4; j++)
+		m_state[j][lane] = s[j];
+}
+
+void FastRandom::Jump() {
+	for (size_t i = 0; i < FAST_RANDOM_LANES; i++)
+		JumpLane(i, LONG_JUMP);
+
+	/* Outputs left from before the jump are dropped */
+	m_pos = FAST_RANDOM_LANES;
+}
+
+FastRandom* FastRandom::Split() {
+	FastRandom* other = new (std::nothrow) FastRandom(*this);
+	if (other == NULL) {
+		LOG_ERROR("FastRandom: failed to allocate generator");
+		return NULL;
+	}
+
+	Jump();
+	return other;
+}
+
+void FastRandom::FillWords(uint8_t* output, size_t words) {
+	/* Finish the last step first, so the stream does not depend */
+	/*   on how it is drawn                                      */
+	while (words > 0 && m_pos < FAST_RANDOM_LANES) {
+		const uint64_t w = Next64();
+		memcpy(output, &w, sizeof(w));
+		output += sizeof(w);
+		words--;
+	}
+
+	uint64_t block[FAST_RANDOM_LANES];
+	while (words >= FAST_RANDOM_LANES) {
+		Step(block);
+		memcpy(output, block, sizeof(block));
+		output += sizeof(block);
+		words -= FAST_RANDOM_LANES;
+	}
+
+	while (words > 0) {
+		const uint64_t w = Next64();
+		memcpy(output, &w, sizeof(w));
+		output += sizeof(w);
+		words--;
+	}
+}
+
+void FastRandom::FillBytes(uint8_t* output, size_t size) {
+	const size_t words = size / sizeof(uint64_t);
+	FillWords(output, words);
+
+	/* A partial word uses the low bytes of one more word */
+	const size_t rest = size % sizeof(uint64_t);
+	if (rest != 0) {
+		const uint64_t w = Next64();
+		memcpy(output + words * sizeof(uint64_t), &w, rest);
+	}
+}
+
+void FastRandom::FillInts(int32_t* output, size_t count, uint32_t bound) {
+	FillBytes((uint8_t*) output, count * sizeof(uint32_t));
+
+	const uint32_t threshold = (0u - bound) % bound;
+
+	for (size_t i = 0; i < count; i++) {
+		uint32_t x;
+		memcpy(&x, &output[i], sizeof(x));
+
+		uint64_t m = (uint64_t) x * bound;
+		while ((uint32_t) m < threshold) {
+			x = (uint32_t) (Next64() >> 32);
+			m = (uint64_t) x * bound;
+		}
+
+		output[i] = (int32_t) (m >> 32);
+	}
+}
+
+void FastRandom::FillLongs(int64_t* output, size_t count, int64_t lo,
+		int64_t hi) {
+	FillWords((uint8_t*) output, count);
+
+	const uint64_t range = (uint64_t) hi - (uint64_t) lo;
+	const uint64_t threshold = (0ull - range) % range;
+
+	for (size_t i = 0; i < count; i++) {
+		uint64_t x, low, high;
+		memcpy(&x, &output[i], sizeof(x));
+
+		high = MultiplyHigh64(x, range, low);
+		while (low < threshold) {
+			x = Next64();
+			high = MultiplyHigh64(x, range, low);
+		}
+
+		output[i] = (int64_t) ((uint64_t) lo + high);
+	}
+}
+
+void FastRandom::FillDoubles(double* output, size_t count) {
+	FillWords((uint8_t*) output, count);
+
+	for (size_t i = 0; i < count; i++) {
+		uint64_t x;
+		memcpy(&x, &output[i], sizeof(x));
+		output[i] = (double) (x >> 11) * (1.0 / 9007199254740992.0);
+	}
+}
@@ -0,0 +1,74 @@
+/* Non-cryptographic generator for simulations and load tests.     */
+/* Output is predictable from a few words and MUST NOT be used for */
+/* keys, nonces, tokens or anything else an attacker may see. It   */
+/* shares nothing with the secure pool: no entropy, no reseeding.  */
+/*                                                                 */
+/* xoshiro256** (Blackman and Vigna) run as FAST_RANDOM_LANES      */
+/* independent lanes. Lane i starts i jumps of 2^128 after lane 0, */
+/* and one step advances every lane, so the bulk fills are a loop  */
+/* the compiler vectorizes. The stream is the lanes' outputs in    */
+/* turn, so a seed gives the same sequence however it is drawn.    */
+
+#ifndef _Included_com_cryptopp_prng_fastrandom
+#define _Included_com_cryptopp_prng_fastrandom
+
+#include <stddef.h>
+#include <stdint.h>
+
+static const size_t FAST_RANDOM_LANES = 4;
+
+class FastRandom
+{
+public:
+	/* Expands seed into the lanes' states with SplitMix64. */
+	explicit FastRandom(uint64_t seed);
+
+	uint64_t Next64() {
+		if (m_pos == FAST_RANDOM_LANES) {
+			Step(m_out);
+			m_pos = 0;
+		}
+
+		return m_out[m_pos++];
+	}
+
+	/* Advances every lane 2^192 outputs, the xoshiro long jump. */
+	/*   2^64 jumps fit before a lane reaches the next one.      */
+	void Jump();
+
+	/* Returns a new generator at this one's position, and jumps */
+	/*   this one. Gives each thread its own stream. NULL if it  */
+	/*   could not be allocated.                                 */
+	FastRandom* Split();
+
+	/* The fills below continue the same stream as Next64. */
+	void FillBytes(uint8_t* output, size_t size);
+
+	/* Unbiased values in [0, bound), or [lo, hi) with lo < hi, */
+	/*   reduced as the secure FillInts and FillLongs do.       */
+	void FillInts(int32_t* output, size_t count, uint32_t bound);
+	void FillLongs(int64_t* output, size_t count, int64_t lo, int64_t hi);
+
+	/* Doubles in [0, 1) from the top 53 bits of each word. */
+	void FillDoubles(double* output, size_t count);
+
+private:
+	/* One step of every lane; writes each lane's output to out. */
+	void Step(uint64_t* out);
+
+	/* Applies a xoshiro jump polynomial to lane. */
+	void JumpLane(size_t lane, const uint64_t* polynomial);
+
+	/* Fills output with whole words, which may be unaligned. */
+	void FillWords(uint8_t* output, size_t words);
+
+	// State word j of lane i is m_state[j][i], so a step is four
+	// independent lane loops over each word
+	uint64_t m_state[4][FAST_RANDOM_LANES];
+
+	// Outputs of the last step not yet returned are m_out[m_pos..]
+	uint64_t m_out[FAST_RANDOM_LANES];
+	size_t m_pos;
+};
+
+#endif
@@ -0,0 +1,297 @@
+#include "prng.h"
+#include "instrument.h"
+
+#include <time.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <new>
+using std::nothrow;
+
+#ifdef __ANDROID__
+# include <dlfcn.h>
+#endif
+
+/* One thread's counters. Written only by the owning thread, read */
+/*   by ReadStats and ReadLatency with relaxed __atomic loads.    */
+struct ThreadCounters {
+	ThreadCounters() :
+			m_prev(NULL), m_next(NULL) {
+		memset(m_stats, 0x00, sizeof(m_stats));
+		memset(m_latency, 0x00, sizeof(m_latency));
+	}
+
+	unsigned long long m_stats[STAT_COUNT];
+	unsigned long long m_latency[STAGE_COUNT][LATENCY_FIELDS];
+
+	// Links in s_live, guarded by s_countersLock
+	ThreadCounters* m_prev;
+	ThreadCounters* m_next;
+};
+
+/* Every live thread's block, and the sums of threads that exited. */
+/*   A thread only takes s_countersLock when it first records and  */
+/*   when it exits.                                                */
+static ThreadCounters* s_live = NULL;
+static ThreadCounters s_retired;
+static pthread_mutex_t s_countersLock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_key_t s_countersKey;
+static pthread_once_t s_countersOnce = PTHREAD_ONCE_INIT;
+static bool s_countersKeyValid = false;
+
+static const char* const s_stageNames[STAGE_COUNT] = {
+	"prng:jni-pin",
+	"prng:jni-unpin",
+	"prng:sensor-data",
+	"prng:random-device",
+	"prng:process-info",
+	"prng:mix",
+	"prng:generate",
+	"prng:seed-load",
+	"prng:seed-save",
+	"prng:accumulate",
+	"prng:getrandom",
+	"prng:urandom",
+	"prng:cpu-random",
+	"prng:parallel-chunk",
+	"prng:stream-wait",
+	"prng:daemon-request"
+};
+
+/* The owning thread is the only writer, so a load and a store is */
+/*   enough; readers see either the old or the new value.         */
+static inline void Bump(unsigned long long& counter, unsigned long long value) {
+	__atomic_store_n(&counter, __atomic_load_n(&counter, __ATOMIC_RELAXED)
+			+ value, __ATOMIC_RELAXED);
+}
+
+/* Folds an exiting thread's counts into s_retired. */
+static void RetireCounters(void* data) {
+	ThreadCounters* counters = reinterpret_cast<ThreadCounters*>(data);
+
+	MutexLock lock(s_countersLock);
+
+	for (size_t i = 0; i < STAT_COUNT; i++)
+		s_retired.m_stats[i] += counters->m_stats[i];
+
+	for (size_t s = 0; s < STAGE_COUNT; s++) {
+		unsigned long long* from = counters->m_latency[s];
+		unsigned long long* to = s_retired.m_latency[s];
+
+		for (size_t f = 0; f < LATENCY_FIELDS; f++) {
+			if (f == LATENCY_MAX_NANOS)
+				to[f] = std::max(to[f], from[f]);
+			else
+				to[f] += from[f];
+		}
+	}
+
+	if (counters->m_prev)
+		counters->m_prev->m_next = counters->m_next;
+	else
+		s_live = counters->m_next;
+
+	if (counters->m_next)
+		counters->m_next->m_prev = counters->m_prev;
+
+	delete counters;
+}
+
+/* Held across fork, so a child never inherits the registry locked */
+/*   by a thread that did not come with it.                         */
+static void LockCounters() {
+	pthread_mutex_lock(&s_countersLock);
+}
+
+static void UnlockCounters() {
+	pthread_mutex_unlock(&s_countersLock);
+}
+
+static void CreateCountersKey() {
+	int rc = pthread_key_create(&s_countersKey, RetireCounters);
+	if (rc != 0) {
+		LOG_ERROR("Instrument: pthread_key_create failed, error %d", rc);
+		return;
+	}
+
+	rc = pthread_atfork(LockCounters, UnlockCounters, UnlockCounters);
+	if (rc != 0) {
+		LOG_ERROR("Instrument: pthread_atfork failed, error %d", rc);
+	}
+
+	s_countersKeyValid = true;
+}
+
+/* Returns the calling thread's block, creating it on first use. */
+/*   Returns NULL if it could not be created; the sample is lost. */
+static ThreadCounters* GetThreadCounters() {
+	pthread_once(&s_countersOnce, CreateCountersKey);
+	if (!s_countersKeyValid)
+		return NULL;
+
+	ThreadCounters* counters = reinterpret_cast<ThreadCounters*>(
+			pthread_getspecific(s_countersKey));
+	if (counters != NULL)
+		return counters;
+
+	counters = new (nothrow) ThreadCounters;
+	if (counters == NULL)
+		return NULL;
+
+	if (pthread_setspecific(s_countersKey, counters) != 0) {
+		delete counters;
+		return NULL;
+	}
+
+	MutexLock lock(s_countersLock);
+
+	counters->m_next = s_live;
+	if (s_live)
+		s_live->m_prev = counters;
+	s_live = counters;
+
+	return counters;
+}
+
+void AddStat(StatIndex index, unsigned long long value) {
+	ThreadCounters* counters = GetThreadCounters();
+	if (counters == NULL)
+		return;
+
+	Bump(counters->m_stats[index], value);
+}
+
+static size_t LatencyBucket(uint64_t nanoseconds) {
+	if (nanoseconds < 128)
+		return 0;
+
+	/* Index of the highest set bit, 7 or more here */
+	const size_t bit = 63 - __builtin_clzll(nanoseconds);
+	return std::min(bit - 6, LATENCY_BUCKETS - 1);
+}
+
+void RecordLatency(TraceStage stage, uint64_t nanoseconds) {
+	ThreadCounters* counters = GetThreadCounters();
+	if (counters == NULL)
+		return;
+
+	unsigned long long* fields = counters->m_latency[stage];
+
+	Bump(fields[LATENCY_COUNT], 1);
+	Bump(fields[LATENCY_TOTAL_NANOS], nanoseconds);
+	Bump(fields[LATENCY_FIRST_BUCKET + LatencyBucket(nanoseconds)], 1);
+
+	if (nanoseconds > fields[LATENCY_MAX_NANOS]) {
+		__atomic_store_n(&fields[LATENCY_MAX_NANOS],
+				(unsigned long long) nanoseconds, __ATOMIC_RELAXED);
+	}
+}
+
+uint64_t MonotonicNanoSeconds() {
+	struct timespec res;
+	clock_gettime(CLOCK_MONOTONIC, &res);
+
+	return (uint64_t) res.tv_sec * 1000000000ULL + (uint64_t) res.tv_nsec;
+}
+
+size_t ReadStats(unsigned long long* values, size_t count) {
+	count = std::min<size_t>(count, STAT_COUNT);
+
+	MutexLock lock(s_countersLock);
+
+	for (size_t i = 0; i < count; i++) {
+		values[i] = s_retired.m_stats[i];
+
+		for (ThreadCounters* c = s_live; c != NULL; c = c->m_next)
+			values[i] += __atomic_load_n(&c->m_stats[i], __ATOMIC_RELAXED);
+	}
+
+	return count;
+}
+
+size_t ReadLatency(unsigned long long* values, size_t count) {
+	const size_t stages = std::min<size_t>(count / LATENCY_FIELDS,
+			STAGE_COUNT);
+
+	MutexLock lock(s_countersLock);
+
+	for (size_t s = 0; s < stages; s++) {
+		unsigned long long* to = values + s * LATENCY_FIELDS;
+		memcpy(to, s_retired.m_latency[s], sizeof(s_retired.m_latency[s]));
+
+		for (ThreadCounters* c = s_live; c != NULL; c = c->m_next) {
+			for (size_t f = 0; f < LATENCY_FIELDS; f++) {
+				const unsigned long long v = __atomic_load_n(
+						&c->m_latency[s][f], __ATOMIC_RELAXED);
+
+				if (f == LATENCY_MAX_NANOS)
+					to[f] = std::max(to[f], v);
+				else
+					to[f] += v;
+			}
+		}
+	}
+
+	return stages;
+}
+
+/* ATrace_beginSection and ATrace_endSection arrived in API 23, and */
+/*   the library still loads on older devices, so they are looked   */
+/*   up at runtime. On a host there is no trace buffer, and the     */
+/*   sections are no-ops.                                           */
+#ifdef __ANDROID__
+typedef void (*ATraceBeginFn)(const char*);
+typedef void (*ATraceEndFn)(void);
+
+static ATraceBeginFn s_traceBegin = NULL;
+static ATraceEndFn s_traceEnd = NULL;
+static pthread_once_t s_traceOnce = PTHREAD_ONCE_INIT;
+
+static void LoadTrace() {
+	void* lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+	if (lib == NULL)
+		return;
+
+	ATraceBeginFn begin = reinterpret_cast<ATraceBeginFn>(dlsym(lib,
+			"ATrace_beginSection"));
+	ATraceEndFn end = reinterpret_cast<ATraceEndFn>(dlsym(lib,
+			"ATrace_endSection"));
+
+	/* Both or neither, so sections always pair up */
+	if (begin && end) {
+		s_traceBegin = begin;
+		s_traceEnd = end;
+	}
+}
+
+static inline void BeginTrace(TraceStage stage) {
+	pthread_once(&s_traceOnce, LoadTrace);
+	if (s_traceBegin)
+		s_traceBegin(s_stageNames[stage]);
+}
+
+static inline void EndTrace() {
+	if (s_traceEnd)
+		s_traceEnd();
+}
+#else
+static inline void BeginTrace(TraceStage stage) {
+	(void) s_stageNames[stage];
+}
+
+static inline void EndTrace() {
+}
+#endif
+
+TraceSection::TraceSection(TraceStage stage) :
+		m_stage(stage) {
+	BeginTrace(m_stage);
+	m_start = MonotonicNanoSeconds();
+}
+
+TraceSection::~TraceSection() {
+	RecordLatency(m_stage, MonotonicNanoSeconds() - m_start);
+	EndTrace();
+}
@@ -0,0 +1,122 @@
+/* Instrumentation. Counters and latency histograms are kept per   */
+/* thread: only the owning thread writes its block, with relaxed    */
+/* __atomic stores and no read-modify-write, so recording a sample  */
+/* never takes a lock or bounces a cache line between cores. Reads  */
+/* sum every thread's block. Timed stages also show up as ATrace    */
+/* sections in systrace and Perfetto captures on API 23 and above.  */
+
+#ifndef _Included_com_cryptopp_prng_instrument
+#define _Included_com_cryptopp_prng_instrument
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Counters returned by CryptoPP_GetStats. The indexes are part of */
+/*   the Java API (see the STAT_* constants in PRNG.java), so only */
+/*   append to this list.                                          */
+enum StatIndex {
+	STAT_RING_HITS = 0,
+	STAT_RING_MISSES,
+	STAT_RING_BYPASSES,
+	STAT_RING_REFILLS,
+	STAT_RING_REFILL_BYTES,
+	STAT_SENSOR_ROUNDS,
+	STAT_SENSOR_TARGET_MET,
+	STAT_SENSOR_CREDITED_BITS,
+	STAT_HEALTH_RCT_FAILURES,
+	STAT_HEALTH_APT_FAILURES,
+	STAT_RESEED_BYTES,
+	STAT_RESEED_TIME,
+	STAT_RESEED_FORK,
+	STAT_RESEED_EXPLICIT,
+	STAT_SEED_LOADS,
+	STAT_SEED_SAVES,
+	STAT_SEED_FAILURES,
+	STAT_ENTROPY_COMMITS,
+	STAT_ENTROPY_COMMIT_BYTES,
+	STAT_ACCUMULATOR_OVERFLOWS,
+	STAT_PARALLEL_REQUESTS,
+	STAT_PARALLEL_FALLBACKS,
+	STAT_STREAM_BYTES,
+	STAT_DAEMON_REQUESTS,
+	STAT_DAEMON_SEEDS,
+	STAT_DAEMON_FALLBACKS,
+	STAT_DEADLINE_REQUESTS,
+	STAT_DEADLINE_ROUNDS,
+	STAT_DEADLINE_FALLBACKS,
+	STAT_COUNT
+};
+
+/* Timed stages, returned by CryptoPP_GetLatencyStats. Part of the */
+/*   Java API (the STAGE_* constants in PRNG.java), so only append. */
+enum TraceStage {
+	STAGE_JNI_PIN = 0,
+	STAGE_JNI_UNPIN,
+	STAGE_SENSOR_DATA,
+	STAGE_RANDOM_DEVICE,
+	STAGE_PROCESS_INFO,
+	STAGE_MIX,
+	STAGE_GENERATE,
+	STAGE_SEED_LOAD,
+	STAGE_SEED_SAVE,
+	STAGE_ACCUMULATE,
+	STAGE_GETRANDOM,
+	STAGE_URANDOM,
+	STAGE_CPU_RANDOM,
+	STAGE_PARALLEL_CHUNK,
+	STAGE_STREAM_WAIT,
+	STAGE_DAEMON_REQUEST,
+	STAGE_COUNT
+};
+
+/* Histogram buckets are powers of two. Bucket 0 holds samples  */
+/*   under 128 ns, bucket i holds [2^(i+6), 2^(i+7)) ns, and the */
+/*   last bucket holds everything from 2^29 ns (about 0.5 s) up. */
+static const size_t LATENCY_BUCKETS = 24;
+
+/* Values per stage written by ReadLatency: samples, total and */
+/*   maximum nanoseconds, then the buckets.                   */
+enum LatencyField {
+	LATENCY_COUNT = 0,
+	LATENCY_TOTAL_NANOS,
+	LATENCY_MAX_NANOS,
+	LATENCY_FIRST_BUCKET,
+	LATENCY_FIELDS = LATENCY_FIRST_BUCKET + LATENCY_BUCKETS
+};
+
+/* Adds value to a counter in the calling thread's block. */
+void AddStat(StatIndex index, unsigned long long value = 1);
+
+/* Adds one sample to a stage's histogram in the calling thread's */
+/*   block.                                                       */
+void RecordLatency(TraceStage stage, uint64_t nanoseconds);
+
+/* CLOCK_MONOTONIC in nanoseconds. */
+uint64_t MonotonicNanoSeconds();
+
+/* Copies up to count counters, indexed by StatIndex, summed over */
+/*   every thread. Returns the number copied.                    */
+size_t ReadStats(unsigned long long* values, size_t count);
+
+/* Copies whole stages, LATENCY_FIELDS values each, while they fit */
+/*   in count values. Returns the number of stages copied.         */
+size_t ReadLatency(unsigned long long* values, size_t count);
+
+/* Times a stage for its lifetime, and brackets it with an ATrace */
+/*   section when tracing is available.                           */
+class TraceSection
+{
+public:
+	explicit TraceSection(TraceStage stage);
+	~TraceSection();
+
+private:
+	// Not copyable
+	TraceSection(const TraceSection&);
+	TraceSection& operator=(const TraceSection&);
+
+	TraceStage m_stage;
+	uint64_t m_start;
+};
+
+#endif
@@ -0,0 +1,77 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_cryptopp_prng_NonCryptoRandom */
+
+#ifndef _Included_com_cryptopp_prng_NonCryptoRandom
+#define _Included_com_cryptopp_prng_NonCryptoRandom
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_Create
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Create
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_Split
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Split
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_Jump
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Jump
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_Destroy
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Destroy
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_NextBytes
+ * Signature: (J[BII)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextBytes
+  (JNIEnv *, jclass, jlong, jbyteArray, jint, jint);
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_NextInts
+ * Signature: (J[II)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextInts
+  (JNIEnv *, jclass, jlong, jintArray, jint);
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_NextLongs
+ * Signature: (J[JJJ)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextLongs
+  (JNIEnv *, jclass, jlong, jlongArray, jlong, jlong);
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_NextDoubles
+ * Signature: (J[D)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextDoubles
+  (JNIEnv *, jclass, jlong, jdoubleArray);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -1,276 +1,32 @@
-// Debug settings in this block
-#if 1
-# undef NDEBUG
-# undef DEBUG
-# undef NDK_DEBUG
-
-# define DEBUG 1
-# define NDK_DEBUG 1
-#endif
-
-// Release settings in this block
-#if 0
-# undef NDEBUG
-# undef DEBUG
-# undef NDK_DEBUG
-
-# define NDEBUG 1
-#endif
-
-//#if defined(DEBUG) || defined(NDK_DEBUG)
-//# error Debug is defined
-//#endif
-
-#include <android/sensor.h>
-#include <android/looper.h>
-#include <android/log.h>
+#include "prng.h"
 
 #include <jni.h>
-#include <time.h>
-#include <unistd.h>
-
-#define LOG_TAG "PRNG"
-#define LOG_DEBUG(...) ((void)__android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__))
-#define LOG_INFO(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
-#define LOG_WARN(...) ((void)__android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__))
-#define LOG_ERROR(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
-
-#if defined(NDEBUG)
-# undef LOG_VERBOSE
-# define LOG_VERBOSE(...)
-# undef LOG_DEBUG
-# define LOG_DEBUG(...)
-#endif
-
-#define COUNTOF(x) (sizeof(x) / sizeof(x[0]))
-
-#include <stdexcept>
-using std::runtime_error;
-
-#include <string>
-using std::string;
 
+#include <new>
+#include <algorithm>
 #include <vector>
-using std::vector;
-
-#include <fstream>
-using std::ifstream;
-
-#include <cryptopp/osrng.h>
-using CryptoPP::AutoSeededRandomPool;
 
 #include <cryptopp/cryptlib.h>
 using CryptoPP::Exception;
 
 #include "libprng.h"
+#include "libnoncrypto.h"
+#include "prngapi.h"
 #include "cleanup.h"
+#include "backend.h"
+#include "entropy.h"
+#include "stream.h"
+#include "daemon.h"
+#include "fastrandom.h"
 
-static double TimeInMilliSeconds(double offset /*milliseconds*/);
-static int SamplesPerSecondToMicroSecond(int samples);
-
-#ifndef NDEBUG
-static const char* SensorTypeToName(int sensorType);
-#endif
+/* Doubles per channel written by CryptoPP_GetEntropyEstimates: */
+/*   type, channel, samples, min-entropy, RCT and APT failures.  */
+/*   Matches ESTIMATE_FIELDS in PRNG.java.                       */
+static const size_t ESTIMATE_FIELDS = 6;
 
 /* https://groups.google.com/forum/#!topic/android-ndk/ukQBmKJH2eM */
 static const int EXPECTED_JNI_VERSION = JNI_VERSION_1_6;
 
-/* Used for a delay in sampling sensors. That is, we read a   */
-/* sample, and then delay N microseconds before reading from  */
-/* the sensor again. This gives the sensor time to latch a    */
-/* a new reading.                                             */
-static const int PREFERRED_INTERVAL_MICROSECONDS =
-		SamplesPerSecondToMicroSecond(30 /*samples per second*/);
-
-/* App_glue.h defines this. If its not defined, then define it. */
-#ifndef LOOPER_ID_USER
-# define LOOPER_ID_USER 3
-#endif
-
-static const int LOOPER_ID_PRNG = LOOPER_ID_USER + 1;
-
-/* Assuming each float (32-bits) in the {x,y,z} tuple has         */
-/* 6-bits of entropy, and each time stamp (64-bits) has 4-bits    */
-/* of entropy, then each event has 22-bits. We want 32-bytes or   */
-/* 256-bits for to mix into the PRNG for each call to GetBytes,   */
-/* so we need 11.6 or 12 events. Note that sizeof(ASensorEvent)   */
-/* is over 100 bytes, and it holds other info. Also, the          */
-/* accelerometer (if present) appears to produce almost 28-bits   */
-/* per member in the tuple.                                       */
-
-/* How many sensor events we would like to sample. If we     */
-/* reach TIME_LIMIT_IN_MILLISECONDS, then we stop sampling.  */
-/* If we sample 0 events, then we fall back to the random    */
-/* device and try to grab RANDOM_DEVICE_BYTES bytes.         */
-static const int SENSOR_SAMPLE_COUNT = 12;
-
-/* Sampling time limit, in milliseconds. 200 to 400 ms is    */
-/* the sweet spot. Its the same time for the blink of an     */
-/* eye. Keep in mind that Java may add from 30 to 80 ms. A   */
-/* sensor rich device will be done in 125 ms because there   */
-/* are so many readings.                                     */
-static const double TIME_LIMIT_IN_MILLISECONDS = 0.250f * 1000;
-
-/* How many bytes to read from /dev/urandom. We read from the */
-/* random device as a fallback to ensure something is read    */
-/* before providing bytes in GetBytes().                      */
-static const int RANDOM_DEVICE_BYTES = 16;
-
-/* Prototypes */
-static int AddSensorData();
-static int AddRandomDevice();
-static int AddProcessInfo();
-
-struct SensorContext {
-
-	SensorContext() :
-			m_looper(NULL), m_manager(NULL), m_queue(NULL), m_signaled(0), m_stop(
-					0.0f) {
-	}
-
-	~SensorContext() {
-		m_looper = NULL;
-		m_manager = NULL;
-		m_queue = NULL;
-		m_signaled = 1;
-		m_stop = 0.0f;
-	}
-
-	// Looper
-	ALooper* m_looper;
-
-	// Sensor Manager
-	ASensorManager* m_manager;
-
-	// And the queue
-	ASensorEventQueue* m_queue;
-
-	// If not signaled, then processing should continue.
-	// If signaled, then processing should stop.
-	int m_signaled;
-
-	/* Time when the callback should stop */
-	double m_stop;
-};
-
-struct Sensor {
-	Sensor() :
-			m_type(0), m_sensor(NULL) {
-	}
-
-	explicit Sensor(int type, string name, const ASensor* sensor) :
-			m_type(type), m_name(name), m_sensor(sensor) {
-	}
-
-	int m_type;
-	string m_name;
-	const ASensor* m_sensor;
-};
-
-typedef vector<Sensor> SensorArray;
-
-#ifndef NDEBUG
-struct RawFloat {
-	union {
-		byte b[sizeof(float)];
-		unsigned int n[sizeof(float) / sizeof(unsigned int)];
-		float f;
-	};
-};
-#endif
-
-/* Return the time in milliseconds. If offset = 0.0f, then it returns  */
-/*  now. Positive offsets are milliseconds into the future. Negative   */
-/*  offsets are milliseconds in the past.                              */
-static double TimeInMilliSeconds(double offset /*seconds*/= 0.0f) {
-	struct timespec res;
-	clock_gettime(CLOCK_REALTIME, &res);
-
-	double t = 1000.0 * (double) res.tv_sec + (double) res.tv_nsec / 1e6;
-	return t + offset;
-}
-
-/* Given a sample rate, returns the microseconds in an interval */
-static int SamplesPerSecondToMicroSecond(int samples) {
-	return (int) ((1 / (double) samples) * 1000 * 1000);
-}
-
-static AutoSeededRandomPool& GetPRNG() {
-	static AutoSeededRandomPool prng;
-	return prng;
-}
-
-static SensorArray& GetSensorArray() {
-	static SensorArray s_list;
-	static volatile bool s_init = false;
-
-	if (!s_init) {
-		LOG_DEBUG("SensorArray: initializing list");
-
-		ASensorList sensorArray;
-		ASensorManager* sensorManager = ASensorManager_getInstance();
-		int n = ASensorManager_getSensorList(sensorManager, &sensorArray);
-
-		if (n < 0) {
-			LOG_ERROR("SensorArray: failed to retrieve list");
-		} else if (n == 0) {
-			LOG_WARN("SensorArray: no sensors available");
-		} else {
-			s_list.reserve(static_cast<size_t>(n));
-
-			for (int i = 0; i < n; i++) {
-				const ASensor* sensor = sensorArray[i];
-				if (sensor == NULL)
-					continue;
-
-				const char* name = ASensor_getName(sensor);
-				int type = ASensor_getType(sensor);
-
-#ifndef NDEBUG
-				const char* vendor = ASensor_getVendor(sensor);
-				int min_delay = ASensor_getMinDelay(sensor);
-				float resolution = ASensor_getResolution(sensor);
-
-				LOG_DEBUG("SensorArray: %s (%s) %d %d %f", name, vendor, type,
-						min_delay, resolution);
-#endif
-
-				s_list.push_back(Sensor(type, name, sensor));
-			}
-
-			LOG_DEBUG("SensorArray: added %d sensors", (int )s_list.size());
-		}
-
-		s_init = true;
-	}
-
-	return s_list;
-}
-
-static int SensorEvent(int fd, int events, void* data) {
-
-	LOG_DEBUG("Entered SensorEvent");
-
-	SensorContext* context = reinterpret_cast<SensorContext*>(data);
-	if (!context) {
-		LOG_ERROR("SensorEvent: context is not valid");
-		return 0;
-	}
-
-	/**************** Return Values ****************/
-	/* 1: continue processing; 0: stop processing. */
-	/***********************************************/
-
-	/* Return 0 while the context is signaled.  */
-	if (context->m_signaled) {
-		LOG_DEBUG("SensorEvent: signaled to stop");
-		return 0;
-	}
-
-	/* Return 1 while the context is not signaled. */
-	return 1;
-}
-
 jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
 	LOG_DEBUG("Entered JNI_OnLoad");
 
@@ -290,7 +46,7 @@ jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
 		return -1;
 	}
 
-	JNINativeMethod methods[2];
+	JNINativeMethod methods[38];
 
 	methods[0].name = "CryptoPP_Reseed";
 	methods[0].signature = "([B)I";
@@ -302,16 +58,273 @@ jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
 	methods[1].fnPtr =
 			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytes);
 
+	methods[2].name = "CryptoPP_StartHarvester";
+	methods[2].signature = "()I";
+	methods[2].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1StartHarvester);
+
+	methods[3].name = "CryptoPP_StopHarvester";
+	methods[3].signature = "()I";
+	methods[3].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1StopHarvester);
+
+	methods[4].name = "CryptoPP_PauseHarvester";
+	methods[4].signature = "()I";
+	methods[4].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1PauseHarvester);
+
+	methods[5].name = "CryptoPP_ResumeHarvester";
+	methods[5].signature = "()I";
+	methods[5].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1ResumeHarvester);
+
+	methods[6].name = "CryptoPP_ConfigureRing";
+	methods[6].signature = "(III)I";
+	methods[6].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1ConfigureRing);
+
+	methods[7].name = "CryptoPP_GetStats";
+	methods[7].signature = "([J)I";
+	methods[7].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1GetStats);
+
+	methods[8].name = "CryptoPP_ReseedRange";
+	methods[8].signature = "([BII)I";
+	methods[8].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1ReseedRange);
+
+	methods[9].name = "CryptoPP_GetBytesRange";
+	methods[9].signature = "([BII)I";
+	methods[9].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesRange);
+
+	methods[10].name = "CryptoPP_GetBytesDirect";
+	methods[10].signature = "(Ljava/nio/ByteBuffer;II)I";
+	methods[10].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesDirect);
+
+	methods[11].name = "CryptoPP_GetBytesBatch";
+	methods[11].signature = "([[B)I";
+	methods[11].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesBatch);
+
+	methods[12].name = "CryptoPP_NextInts";
+	methods[12].signature = "([II)I";
+	methods[12].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1NextInts);
+
+	methods[13].name = "CryptoPP_NextLongs";
+	methods[13].signature = "([JJJ)I";
+	methods[13].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1NextLongs);
+
+	methods[14].name = "CryptoPP_NextDoubles";
+	methods[14].signature = "([D)I";
+	methods[14].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1NextDoubles);
+
+	methods[15].name = "CryptoPP_NextFloats";
+	methods[15].signature = "([F)I";
+	methods[15].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1NextFloats);
+
+	methods[16].name = "CryptoPP_SelectBackend";
+	methods[16].signature = "(I)I";
+	methods[16].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1SelectBackend);
+
+	methods[17].name = "CryptoPP_GetBackend";
+	methods[17].signature = "()I";
+	methods[17].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBackend);
+
+	methods[18].name = "CryptoPP_StartRecording";
+	methods[18].signature = "(Ljava/lang/String;)I";
+	methods[18].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1StartRecording);
+
+	methods[19].name = "CryptoPP_StopRecording";
+	methods[19].signature = "()I";
+	methods[19].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1StopRecording);
+
+	methods[20].name = "CryptoPP_SetProfilePath";
+	methods[20].signature = "(Ljava/lang/String;)I";
+	methods[20].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1SetProfilePath);
+
+	methods[21].name = "CryptoPP_GetEntropyEstimates";
+	methods[21].signature = "([D)I";
+	methods[21].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1GetEntropyEstimates);
+
+	methods[22].name = "CryptoPP_RequestReseed";
+	methods[22].signature = "()I";
+	methods[22].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1RequestReseed);
+
+	methods[23].name = "CryptoPP_ConfigureReseed";
+	methods[23].signature = "(JI)I";
+	methods[23].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1ConfigureReseed);
+
+	methods[24].name = "CryptoPP_GetLatencyStats";
+	methods[24].signature = "([J)I";
+	methods[24].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1GetLatencyStats);
+
+	methods[25].name = "CryptoPP_SetSeedFile";
+	methods[25].signature = "(Ljava/lang/String;)I";
+	methods[25].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1SetSeedFile);
+
+	methods[26].name = "CryptoPP_IsReady";
+	methods[26].signature = "()I";
+	methods[26].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1IsReady);
+
+	methods[27].name = "CryptoPP_AwaitReady";
+	methods[27].signature = "(I)I";
+	methods[27].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1AwaitReady);
+
+	methods[28].name = "CryptoPP_ConfigureParallel";
+	methods[28].signature = "(JI)I";
+	methods[28].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1ConfigureParallel);
+
+	methods[29].name = "CryptoPP_OpenStream";
+	methods[29].signature = "()J";
+	methods[29].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1OpenStream);
+
+	methods[30].name = "CryptoPP_WriteStream";
+	methods[30].signature = "(JIJ)J";
+	methods[30].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1WriteStream);
+
+	methods[31].name = "CryptoPP_ReadStream";
+	methods[31].signature = "(J[BII)I";
+	methods[31].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1ReadStream);
+
+	methods[32].name = "CryptoPP_CancelStream";
+	methods[32].signature = "(J)I";
+	methods[32].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1CancelStream);
+
+	methods[33].name = "CryptoPP_CloseStream";
+	methods[33].signature = "(J)I";
+	methods[33].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1CloseStream);
+
+	methods[34].name = "CryptoPP_StartDaemon";
+	methods[34].signature = "(Ljava/lang/String;)I";
+	methods[34].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1StartDaemon);
+
+	methods[35].name = "CryptoPP_StopDaemon";
+	methods[35].signature = "()I";
+	methods[35].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1StopDaemon);
+
+	methods[36].name = "CryptoPP_UseDaemon";
+	methods[36].signature = "(Ljava/lang/String;)I";
+	methods[36].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1UseDaemon);
+
+	methods[37].name = "CryptoPP_GetBytesWithin";
+	methods[37].signature = "([BJ)I";
+	methods[37].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesWithin);
+
+	/* Clear what a failure leaves pending, since the next JNI */
+	/*   call may not be made with an exception outstanding     */
 	jclass cls = env->FindClass("com/cryptopp/prng/PRNG");
 	if (cls == NULL) {
 		LOG_ERROR("JNI_OnLoad: FindClass com/cryptopp/prng/PRNG failed");
-	} else {
-		env->RegisterNatives(cls, methods, COUNTOF(methods));
+		env->ExceptionClear();
+	} else if (env->RegisterNatives(cls, methods, COUNTOF(methods)) != JNI_OK) {
+		LOG_ERROR("JNI_OnLoad: RegisterNatives for PRNG failed");
+		env->ExceptionClear();
+	}
+
+	/* The non-cryptographic generator has its own class, so it */
+	/*   cannot be mistaken for the PRNG methods                 */
+	JNINativeMethod fastMethods[8];
+
+	fastMethods[0].name = "NonCrypto_Create";
+	fastMethods[0].signature = "(J)J";
+	fastMethods[0].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Create);
+
+	fastMethods[1].name = "NonCrypto_Split";
+	fastMethods[1].signature = "(J)J";
+	fastMethods[1].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Split);
+
+	fastMethods[2].name = "NonCrypto_Jump";
+	fastMethods[2].signature = "(J)I";
+	fastMethods[2].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Jump);
+
+	fastMethods[3].name = "NonCrypto_Destroy";
+	fastMethods[3].signature = "(J)I";
+	fastMethods[3].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Destroy);
+
+	fastMethods[4].name = "NonCrypto_NextBytes";
+	fastMethods[4].signature = "(J[BII)I";
+	fastMethods[4].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextBytes);
+
+	fastMethods[5].name = "NonCrypto_NextInts";
+	fastMethods[5].signature = "(J[II)I";
+	fastMethods[5].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextInts);
+
+	fastMethods[6].name = "NonCrypto_NextLongs";
+	fastMethods[6].signature = "(J[JJJ)I";
+	fastMethods[6].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextLongs);
+
+	fastMethods[7].name = "NonCrypto_NextDoubles";
+	fastMethods[7].signature = "(J[D)I";
+	fastMethods[7].fnPtr =
+			reinterpret_cast<void*>(Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextDoubles);
+
+	cls = env->FindClass("com/cryptopp/prng/NonCryptoRandom");
+	if (cls == NULL) {
+		LOG_ERROR("JNI_OnLoad: FindClass com/cryptopp/prng/NonCryptoRandom failed");
+		env->ExceptionClear();
+	} else if (env->RegisterNatives(cls, fastMethods, COUNTOF(fastMethods))
+			!= JNI_OK) {
+		LOG_ERROR("JNI_OnLoad: RegisterNatives for NonCryptoRandom failed");
+		env->ExceptionClear();
 	}
 
+	/* Start harvesting and build the pool in the background (see */
+	/*   CryptoPP_AwaitReady)                                      */
+	(void) prng_init();
+
 	return EXPECTED_JNI_VERSION;
 }
 
+void JNICALL JNI_OnUnload(JavaVM* vm, void* reserved) {
+	LOG_DEBUG("Entered JNI_OnUnload");
+
+	prng_shutdown();
+}
+
+/* Returns true if [offset, offset + length) lies within capacity. */
+static bool IsValidRange(jint offset, jint length, size_t capacity) {
+	if (offset < 0 || length < 0)
+		return false;
+
+	return (size_t) offset <= capacity
+			&& (size_t) length <= capacity - (size_t) offset;
+}
+
 /*
  * Class:     com_cryptopp_prng_PRNG
  * Method:    CryptoPP_Reseed
@@ -322,43 +335,57 @@ jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1Reseed(JNIEnv* env, jclass,
 
 	LOG_DEBUG("Entered Reseed");
 
-	int consumed = 0;
+	if (!env) {
+		LOG_ERROR("Reseed: environment is NULL");
+		return 0;
+	}
 
-	try {
-		if (!env) {
-			LOG_ERROR("Reseed: environment is NULL");
-			return 0;
-		}
+	if (!seed) {
+		// OK if the caller passed NULL for the array
+		LOG_WARN("Reseed: byte array is NULL");
+		return 0;
+	}
 
-		if (!seed) {
-			// OK if the caller passed NULL for the array
-			LOG_WARN("GetBytes: byte array is NULL");
-			return 0;
-		}
+	ReadInputBuffer buffer(env, seed);
+
+	return (jint) prng_reseed(buffer.GetByteArray(), buffer.GetArrayLen());
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ReseedRange
+ * Signature: ([BII)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ReseedRange(
+		JNIEnv* env, jclass, jbyteArray seed, jint offset, jint length) {
 
-		ReadByteBuffer buffer(env, seed);
+	LOG_DEBUG("Entered ReseedRange");
 
-		const byte* seed_arr = buffer.GetByteArray();
-		size_t seed_len = buffer.GetArrayLen();
+	if (!env) {
+		LOG_ERROR("ReseedRange: environment is NULL");
+		return 0;
+	}
 
-		if ((seed_arr == NULL)) {
-			LOG_ERROR("Reseed: array pointer is not valid");
-		} else if ((seed_len == 0)) {
-			LOG_ERROR("Reseed: array size is not valid");
-		} else {
-			AutoSeededRandomPool& prng = GetPRNG();
-			prng.IncorporateEntropy(seed_arr, seed_len);
+	if (!seed) {
+		// OK if the caller passed NULL for the array
+		LOG_WARN("ReseedRange: byte array is NULL");
+		return 0;
+	}
 
-			LOG_INFO("Reseed: seeded with %d bytes", (int )seed_len);
+	ReadInputBuffer buffer(env, seed, length);
 
-			consumed += (int) seed_len;
-		}
-	} catch (const Exception& ex) {
-		LOG_ERROR("Reseed: Crypto++ exception: \"%s\"", ex.what());
+	if (buffer.GetByteArray() == NULL) {
+		LOG_ERROR("ReseedRange: array pointer is not valid");
+		return 0;
+	}
+
+	if (!IsValidRange(offset, length, buffer.GetArrayLen())) {
+		LOG_ERROR("ReseedRange: range is not valid");
 		return 0;
 	}
 
-	return consumed;
+	return (jint) prng_reseed(buffer.GetByteArray() + offset,
+			(size_t) length);
 }
 
 /*
@@ -371,377 +398,1219 @@ JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytes(
 
 	LOG_DEBUG("Entered GetBytes");
 
-	int retrieved = 0;
+	if (!env) {
+		LOG_ERROR("GetBytes: environment is NULL");
+		return 0;
+	}
+
+	if (!bytes) {
+		// OK if the caller passed NULL for the array
+		LOG_WARN("GetBytes: byte array is NULL");
+		return 0;
+	}
 
-	// Always mix in data during a call to GetBytes, even if the array is null.
-	// Any entropy gathered will help future calls with a non-null array.
-	int rc1, rc2, rc3;
+	/* Pin the heap array rather than copy it in and back out, */
+	/*   unless the request is large enough to wait on workers  */
+	WriteOutputBuffer buffer(env, bytes);
+
+	return (jint) prng_get_bytes(buffer.GetByteArray(),
+			buffer.GetArrayLen());
+}
 
-	rc1 = AddProcessInfo();
-	assert(rc1 > 0);
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBytesWithin
+ * Signature: ([BJ)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesWithin(
+		JNIEnv* env, jclass, jbyteArray bytes, jlong micros) {
 
-	rc2 = AddSensorData();
-	assert(rc2 > 0);
+	LOG_DEBUG("Entered GetBytesWithin");
 
-	/* Fallback to a random device on failure. This is not */
-	/*   catastrophic since the Crypto++ generator is OK   */
-	if (rc1 <= 0 || rc2 <= 0) {
-		rc3 = AddRandomDevice();
-		assert(rc3 > 0);
+	if (!env) {
+		LOG_ERROR("GetBytesWithin: environment is NULL");
+		return -1;
 	}
 
-	try {
+	if (!bytes) {
+		// OK if the caller passed NULL for the array
+		LOG_WARN("GetBytesWithin: byte array is NULL");
+		return -1;
+	}
 
-		if (!env) {
-			LOG_ERROR("GetBytes: environment is NULL");
-			return 0;
-		}
+	if (micros < 0) {
+		LOG_ERROR("GetBytesWithin: deadline is not valid");
+		return -1;
+	}
 
-		if (!bytes) {
-			// OK if the caller passed NULL for the array
-			LOG_WARN("GetBytes: byte array is NULL");
-			return 0;
-		}
+	/* Not a critical section: the call may wait on the harvester, */
+	/*   and the GC must not be held off meanwhile                 */
+	WriteByteBuffer buffer(env, bytes);
+	if (!buffer.GetByteArray()) {
+		LOG_ERROR("GetBytesWithin: GetByteArrayElements failed");
+		return -1;
+	}
 
-		WriteByteBuffer buffer(env, bytes);
+	double credited = 0.0;
+	if (prng_get_bytes_within(buffer.GetByteArray(), buffer.GetArrayLen(),
+			(uint64_t) micros, &credited) == 0)
+		return -1;
 
-		byte* prng_arr = buffer.GetByteArray();
-		size_t prng_len = buffer.GetArrayLen();
+	return (jint) credited;
+}
 
-		if ((prng_arr == NULL)) {
-			LOG_ERROR("GetBytes: array pointer is not valid");
-		} else if ((prng_len == 0)) {
-			LOG_ERROR("GetBytes: array size is not valid");
-		} else {
-			AutoSeededRandomPool& prng = GetPRNG();
-			prng.GenerateBlock(prng_arr, prng_len);
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBytesRange
+ * Signature: ([BII)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesRange(
+		JNIEnv* env, jclass, jbyteArray bytes, jint offset, jint length) {
 
-			LOG_INFO("GetBytes: generated %d bytes", (int )prng_len);
+	LOG_DEBUG("Entered GetBytesRange");
 
-			retrieved += (int) prng_len;
-		}
-	} catch (const Exception& ex) {
-		LOG_ERROR("GetBytes: Crypto++ exception: \"%s\"", ex.what());
+	if (!env) {
+		LOG_ERROR("GetBytesRange: environment is NULL");
 		return 0;
 	}
 
-	return retrieved;
-}
+	if (!bytes) {
+		// OK if the caller passed NULL for the array
+		LOG_WARN("GetBytesRange: byte array is NULL");
+		return 0;
+	}
 
-static int AddSensorData() {
-	LOG_DEBUG("Entered AddSensorData");
+	WriteOutputBuffer buffer(env, bytes, length);
 
-	const SensorArray& sensorArray = GetSensorArray();
-	if (sensorArray.size() == 0) {
-		LOG_WARN("SensorData: no sensors available");
+	if (buffer.GetByteArray() == NULL) {
+		LOG_ERROR("GetBytesRange: array pointer is not valid");
 		return 0;
 	}
 
-	ALooper* looper = ALooper_forThread();
-	if (looper == NULL)
-		looper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
-
-	if (looper == NULL) {
-		LOG_ERROR("SensorData: looper is not valid");
+	if (!IsValidRange(offset, length, buffer.GetArrayLen())) {
+		LOG_ERROR("GetBytesRange: range is not valid");
 		return 0;
 	}
 
-	LOG_DEBUG("SensorData: created looper");
+	return (jint) prng_get_bytes(buffer.GetByteArray() + offset,
+			(size_t) length);
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBytesDirect
+ * Signature: (Ljava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesDirect(
+		JNIEnv* env, jclass, jobject buffer, jint offset, jint length) {
 
-	ASensorManager* sensorManager = ASensorManager_getInstance();
+	LOG_DEBUG("Entered GetBytesDirect");
 
-	if (sensorManager == NULL) {
-		LOG_ERROR("SensorData: sensor manager is not valid");
+	if (!env) {
+		LOG_ERROR("GetBytesDirect: environment is NULL");
 		return 0;
 	}
 
-	LOG_DEBUG("SensorData: created sensor manager");
+	if (!buffer) {
+		// OK if the caller passed NULL for the buffer
+		LOG_WARN("GetBytesDirect: byte buffer is NULL");
+		return 0;
+	}
 
-	SensorContext context;
+	DirectByteBuffer direct(env, buffer);
 
-	ASensorEventQueue* queue = ASensorManager_createEventQueue(sensorManager,
-			looper, LOOPER_ID_PRNG, SensorEvent,
-			reinterpret_cast<void*>(&context));
+	if (direct.GetByteArray() == NULL) {
+		LOG_ERROR("GetBytesDirect: buffer is not a direct buffer");
+		return 0;
+	}
 
-	if (queue == NULL) {
-		LOG_ERROR("SensorData: queue is not valid");
+	if (!IsValidRange(offset, length, direct.GetArrayLen())) {
+		LOG_ERROR("GetBytesDirect: range is not valid");
 		return 0;
 	}
 
-	LOG_DEBUG("SensorData: created event queue");
+	return (jint) prng_get_bytes(direct.GetByteArray() + offset,
+			(size_t) length);
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBytesBatch
+ * Signature: ([[B)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesBatch(
+		JNIEnv* env, jclass, jobjectArray arrays) {
+
+	LOG_DEBUG("Entered GetBytesBatch");
 
-	context.m_manager = sensorManager;
-	context.m_looper = looper;
-	context.m_queue = queue;
-	context.m_stop = TimeInMilliSeconds(TIME_LIMIT_IN_MILLISECONDS);
+	if (!env) {
+		LOG_ERROR("GetBytesBatch: environment is NULL");
+		return 0;
+	}
 
-	/* Accumulate the various delays. */
-	int sensor_delay = 0;
+	if (!arrays) {
+		// OK if the caller passed NULL for the array
+		LOG_WARN("GetBytesBatch: array of arrays is NULL");
+		return 0;
+	}
 
-	for (size_t i = 0; i < sensorArray.size(); i++) {
+	const jsize count = env->GetArrayLength(arrays);
+	int retrieved = 0;
 
-		const ASensor* sensor = sensorArray[i].m_sensor;
-		if (sensor == NULL) {
-			LOG_WARN("SensorData: sensor number %i is not valid", (int)i);
+	/* One JNI crossing for the whole batch. Each element is pinned */
+	/*   on its own, since GetObjectArrayElement is a JNI call and  */
+	/*   may not be made inside a critical section.                 */
+	for (jsize i = 0; i < count; i++) {
+		jbyteArray bytes = (jbyteArray) env->GetObjectArrayElement(arrays, i);
+		if (!bytes) {
+			LOG_WARN("GetBytesBatch: byte array %d is NULL", (int )i);
 			continue;
 		}
 
-		// Take the larger of our preferred versus the sensor's rate
-		//   Even if a sensor advertises 'min_delay = 0', we still
-		//   try and extract data from it. Often we can get a reading.
-		int rate = ASensor_getMinDelay(sensor);
-		int pref = PREFERRED_INTERVAL_MICROSECONDS;
-		int adj = std::max<int>(rate, pref);
+		{
+			WriteOutputBuffer buffer(env, bytes);
+			retrieved += (jint) prng_get_bytes(buffer.GetByteArray(),
+					buffer.GetArrayLen());
+		}
+
+		/* Large batches would otherwise exhaust the local ref table */
+		env->DeleteLocalRef(bytes);
+	}
+
+	LOG_DEBUG("GetBytesBatch: filled %d arrays, %d bytes", (int )count,
+			retrieved);
+
+	return retrieved;
+}
 
-		/* sensor_delay is the max delay of all sensors. */
-		/*   Its used below to usleep(3) on error.       */
-		sensor_delay = std::max<int>(adj, sensor_delay);
+/* Fillers for FillCriticalArray, one per typed fill in prngapi.h */
+struct FillIntsTo {
+	explicit FillIntsTo(jint bound) : m_bound((uint32_t) bound) {}
+	size_t operator()(jint* arr, size_t len) const {
+		return prng_fill_ints(arr, len, m_bound);
+	}
+	uint32_t m_bound;
+};
 
-		ASensorEventQueue_enableSensor(queue, sensor);
-		ASensorEventQueue_setEventRate(queue, sensor, adj);
+struct FillLongsTo {
+	FillLongsTo(jlong lo, jlong hi) : m_lo(lo), m_hi(hi) {}
+	size_t operator()(jlong* arr, size_t len) const {
+		return prng_fill_longs(reinterpret_cast<int64_t*>(arr), len, m_lo, m_hi);
 	}
+	int64_t m_lo, m_hi;
+};
 
-	LOG_DEBUG("SensorData: enabled sensors");
+struct FillDoublesTo {
+	size_t operator()(jdouble* arr, size_t len) const {
+		return prng_fill_doubles(arr, len);
+	}
+};
 
-	///////////////////////////////////////////////////////////
+struct FillFloatsTo {
+	size_t operator()(jfloat* arr, size_t len) const {
+		return prng_fill_floats(arr, len);
+	}
+};
 
-	ASensorEvent sensor_events[SENSOR_SAMPLE_COUNT * 2];
-	int totalSensors = 0, n = 0;
-	const double time_start = TimeInMilliSeconds();
-	double time_now = time_start;
+/* Fills values a run of at most MAX_CRITICAL_BYTES at a time, each  */
+/*   under its own critical section. A typed fill generates its      */
+/*   whole run in one call, so capping the run keeps it off the      */
+/*   worker pool and the GC is never held off for a large array.     */
+/*   Returns the number of elements filled, or 0 on failure.         */
+template <class T, class Fill>
+static size_t FillCriticalArray(JNIEnv* env, jarray values, size_t len,
+		const Fill& fill) {
+	const size_t step = MAX_CRITICAL_BYTES / sizeof(T);
+	size_t done = 0;
+
+	while (done < len) {
+		WriteCriticalArray<T> array(env, values);
+		if (array.GetArray() == NULL)
+			return 0;
 
-	const int SENSOR_DELAY = sensor_delay;
-	LOG_DEBUG("SensorData: sensor delay is %d microseconds", SENSOR_DELAY);
+		const size_t count = std::min(step, len - done);
+		if (fill(array.GetArray() + done, count) != count)
+			return 0;
+		done += count;
+	}
 
-	while (context.m_signaled == 0) {
+	return done;
+}
 
-		n = ASensorEventQueue_hasEvents(queue);
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_NextInts
+ * Signature: ([II)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1NextInts(
+		JNIEnv* env, jclass, jintArray values, jint bound) {
 
-#ifdef NDEBUG
-		if (n <= 0) {
-			LOG_DEBUG("SensorData: no events, waiting for measurement");
-			usleep(SENSOR_DELAY);
-			continue;
-		}
-#else
-		if (n == 0) {
-			LOG_DEBUG("SensorData: no events, waiting for measurement (1)");
-			usleep(SENSOR_DELAY);
-			continue;
-		} else if (n < 0) {
-			LOG_DEBUG("SensorData: no events, waiting for measurement (2)");
-			usleep(SENSOR_DELAY);
-			continue;
-		}
-#endif
-
-		/* If we get this far, we should not encounter an error */
-		n = ASensorEventQueue_getEvents(queue, sensor_events,
-				COUNTOF(sensor_events));
-		if (n == 0) {
-			LOG_WARN("SensorData: no events (warn)");
-			usleep(SENSOR_DELAY);
-			continue;
-		} else if (n < 0) {
-			LOG_ERROR("SensorData: no events (error)");
-			usleep(SENSOR_DELAY);
-			continue;
-		}
+	LOG_DEBUG("Entered NextInts");
 
-#ifndef NDEBUG
-		for (int i = 0; i < n; i++) {
-			const ASensorEvent ee = sensor_events[i];
-			const ASensorVector vv = ee.vector;
-			LOG_DEBUG("SensorData: %s, v[0]: %.9f, v[1]: %.9f, v[2]: %.9f ",
-					SensorTypeToName(ee.type), vv.v[0], vv.v[1], vv.v[2]);
-
-			RawFloat x, y, z;
-			x.f = vv.x, y.f = vv.y, z.f = vv.z;
-			LOG_DEBUG("                x: %08x%08x, y: %08x%08x, z: %08x%08x",
-					x.n[0], x.n[1], y.n[0], y.n[1], z.n[0], z.n[1]);
-		}
-#endif
-
-		try {
-			AutoSeededRandomPool& prng = GetPRNG();
-			prng.IncorporateEntropy((const byte*) sensor_events,
-					n * sizeof(ASensorEvent));
-		} catch (Exception& ex) {
-			LOG_ERROR("SensorData: Crypto++ exception: \"%s\"", ex.what());
-		}
+	if (!env) {
+		LOG_ERROR("NextInts: environment is NULL");
+		return 0;
+	}
 
-		LOG_DEBUG("SensorData: added %d events, %d bytes", n,
-				static_cast<int>(n * sizeof(ASensorEvent)));
-
-		// Book keeping
-		totalSensors += n;
-		time_now = TimeInMilliSeconds();
-
-		if (totalSensors >= SENSOR_SAMPLE_COUNT) {
-			LOG_DEBUG("SensorData: reached event count of %d",
-					SENSOR_SAMPLE_COUNT);
-			context.m_signaled = 1;
-		} else if (context.m_stop < time_now) {
-			LOG_DEBUG("SensorData: reached time limit of %.2f ms",
-					TIME_LIMIT_IN_MILLISECONDS);
-			context.m_signaled = 1;
-		}
+	if (!values) {
+		LOG_WARN("NextInts: int array is NULL");
+		return 0;
+	}
 
-		/* Give the sensors some time to latch another measurement */
-		if (context.m_signaled == 0)
-			usleep(SENSOR_DELAY);
+	if (bound <= 0) {
+		LOG_ERROR("NextInts: bound %d is not positive", (int )bound);
+		return 0;
 	}
 
-	///////////////////////////////////////////////////////////
+	const jsize len = env->GetArrayLength(values);
+
+	if (len <= 0) {
+		LOG_ERROR("NextInts: array is not valid");
+		return 0;
+	}
 
-	for (size_t i = 0; i < sensorArray.size(); i++) {
+	return (jint) FillCriticalArray<jint>(env, values, (size_t) len,
+			FillIntsTo(bound));
+}
 
-		const ASensor* sensor = sensorArray[i].m_sensor;
-		if (sensor == NULL)
-			continue;
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_NextLongs
+ * Signature: ([JJJ)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1NextLongs(
+		JNIEnv* env, jclass, jlongArray values, jlong lo, jlong hi) {
+
+	LOG_DEBUG("Entered NextLongs");
+
+	if (!env) {
+		LOG_ERROR("NextLongs: environment is NULL");
+		return 0;
+	}
+
+	if (!values) {
+		LOG_WARN("NextLongs: long array is NULL");
+		return 0;
+	}
 
-		ASensorEventQueue_disableSensor(queue, sensor);
+	if (lo >= hi) {
+		LOG_ERROR("NextLongs: range is empty");
+		return 0;
 	}
 
-	LOG_DEBUG("SensorData: disabled sensors");
+	const jsize len = env->GetArrayLength(values);
 
-	const double elapsed = time_now - time_start;
-	LOG_INFO("SensorData: added %d total events, %d total bytes, in %.2f ms",
-			totalSensors, int(totalSensors * sizeof(ASensorEvent)), elapsed);
+	if (len <= 0) {
+		LOG_ERROR("NextLongs: array is not valid");
+		return 0;
+	}
 
-	return totalSensors * sizeof(ASensorEvent);
+	return (jint) FillCriticalArray<jlong>(env, values, (size_t) len,
+			FillLongsTo(lo, hi));
 }
 
-static int AddRandomDevice() {
-	LOG_DEBUG("Entered AddRandomDevice");
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_NextDoubles
+ * Signature: ([D)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1NextDoubles(
+		JNIEnv* env, jclass, jdoubleArray values) {
 
-	ifstream ifs;
-	byte buff[RANDOM_DEVICE_BYTES];
+	LOG_DEBUG("Entered NextDoubles");
 
-	try {
-		ifs.open("/dev/urandom");
-		ifs.read(reinterpret_cast<char*>(buff), sizeof(buff));
-	} catch (const std::exception&) {
-		LOG_ERROR("RandomDevice: failed to read random device");
+	if (!env) {
+		LOG_ERROR("NextDoubles: environment is NULL");
 		return 0;
 	}
 
-	try {
-		AutoSeededRandomPool& prng = GetPRNG();
-		prng.IncorporateEntropy(buff, sizeof(buff));
+	if (!values) {
+		LOG_WARN("NextDoubles: double array is NULL");
+		return 0;
+	}
 
-		LOG_INFO("RandomDevice: added %d total bytes", (int)sizeof(buff));
-	} catch (const Exception& ex) {
-		LOG_ERROR("RandomDevice: Crypto++ exception: \"%s\"", ex.what());
+	const jsize len = env->GetArrayLength(values);
+
+	if (len <= 0) {
+		LOG_ERROR("NextDoubles: array is not valid");
+		return 0;
+	}
+
+	return (jint) FillCriticalArray<jdouble>(env, values, (size_t) len,
+			FillDoublesTo());
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_NextFloats
+ * Signature: ([F)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1NextFloats(
+		JNIEnv* env, jclass, jfloatArray values) {
+
+	LOG_DEBUG("Entered NextFloats");
+
+	if (!env) {
+		LOG_ERROR("NextFloats: environment is NULL");
+		return 0;
+	}
+
+	if (!values) {
+		LOG_WARN("NextFloats: float array is NULL");
+		return 0;
+	}
+
+	const jsize len = env->GetArrayLength(values);
+
+	if (len <= 0) {
+		LOG_ERROR("NextFloats: array is not valid");
 		return 0;
 	}
 
-	return sizeof(buff);
+	return (jint) FillCriticalArray<jfloat>(env, values, (size_t) len,
+			FillFloatsTo());
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StartHarvester
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StartHarvester(
+		JNIEnv*, jclass) {
+
+	LOG_DEBUG("Entered StartHarvester");
+
+	return StartHarvester();
 }
 
-static int AddProcessInfo() {
-	LOG_DEBUG("Entered AddProcessInfo");
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StopHarvester
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StopHarvester(
+		JNIEnv*, jclass) {
 
-	/* Bytes added across all calls */
-	static unsigned long accum = 0;
+	LOG_DEBUG("Entered StopHarvester");
 
-	pid_t pid1, pid2;
-	timespec tspec[4];
+	return StopHarvester();
+}
 
-	pid1 = getpid();
-	pid2 = getppid();
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_PauseHarvester
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1PauseHarvester(
+		JNIEnv*, jclass) {
 
-	/* We don't care about return values here */
-	(void) clock_gettime(CLOCK_REALTIME, &tspec[0]);
-	(void) clock_gettime(CLOCK_MONOTONIC, &tspec[1]);
-	(void) clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tspec[2]);
-	(void) clock_gettime(CLOCK_THREAD_CPUTIME_ID, &tspec[3]);
+	LOG_DEBUG("Entered PauseHarvester");
 
-	/* Send data into the prng in one shot. Its faster than 6 different calls. */
-	byte buff[128];
-	size_t idx = 0;
+	return PauseHarvester(true);
+}
 
-	memcpy(&buff[idx], &pid1, sizeof(pid1));
-	idx += sizeof(pid1);
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ResumeHarvester
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ResumeHarvester(
+		JNIEnv*, jclass) {
 
-	memcpy(&buff[idx], &pid2, sizeof(pid2));
-	idx += sizeof(pid2);
+	LOG_DEBUG("Entered ResumeHarvester");
 
-	memcpy(&buff[idx], tspec, sizeof(tspec));
-	idx += sizeof(tspec);
+	return PauseHarvester(false);
+}
 
-	memcpy(&buff[idx], &accum, sizeof(accum));
-	idx += sizeof(accum);
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ConfigureRing
+ * Signature: (III)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ConfigureRing(
+		JNIEnv*, jclass, jint size, jint lowWater, jint maxRequest) {
 
-	accum += idx;
+	LOG_DEBUG("Entered ConfigureRing");
 
-	try {
-		AutoSeededRandomPool& prng = GetPRNG();
-		prng.IncorporateEntropy(buff, sizeof(buff));
+	if (size < 0 || lowWater < 0 || maxRequest < 0) {
+		LOG_ERROR("ConfigureRing: negative setting");
+		return 0;
+	}
 
-		LOG_INFO("ProcessInfo: added %d total bytes", (int)idx);
-	} catch (const Exception& ex) {
-		LOG_ERROR("ProcessInfo: Crypto++ exception: \"%s\"", ex.what());
-		return 0;
-	}
-
-	return (int) idx;
-}
-
-#ifndef NDEBUG
-static const char* SensorTypeToName(int sensorType) {
-	switch (sensorType) {
-
-	/* <ndk root>/.../sensor.h */
-	case ASENSOR_TYPE_ACCELEROMETER: /* 1 */
-		return "Accelerometer";
-	case ASENSOR_TYPE_MAGNETIC_FIELD: /* 2 */
-		return "Magnetic field";
-	case ASENSOR_TYPE_GYROSCOPE: /* 4 */
-		return "Gyroscope";
-	case ASENSOR_TYPE_LIGHT: /* 5 */
-		return "Light";
-	case ASENSOR_TYPE_PROXIMITY: /* 8 */
-		return "Proximity";
-
-		/* http://developer.android.com/reference/android/hardware/Sensor.html */
-	case 0:
-		return "type 0";
-	case 3:
-		return "Orientation";
-	case 6:
-		return "Pressure";
-	case 7:
-		return "Temperature";
-	case 9:
-		return "Gravity";
-	case 10:
-		return "Linear acceleration";
-	case 11:
-		return "Rotation vector";
-	case 12:
-		return "Relative humidity";
-	case 13:
-		return "Ambient temperature";
-	case 14:
-		return "Uncalibrated magnetic field";
-	case 15:
-		return "Rotation vector";
-	case 16:
-		return "Uncalibrated gyroscope";
-	case 17:
-		return "Significant motion";
-	case 18:
-		return "type 18";
-	case 19:
-		return "Step counter";
-	case 20:
-		return "Geo-magnetic rotation vector.";
-	case 21:
-		return "Heart rate";
-	default:
-		;
-	}
-	return "Unknown";
-}
-#endif
+	return ConfigureRing((size_t) size, (size_t) lowWater, (size_t) maxRequest);
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_RequestReseed
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1RequestReseed(
+		JNIEnv*, jclass) {
+
+	LOG_DEBUG("Entered RequestReseed");
+
+	try {
+		return RequestReseed();
+	} catch (const Exception& ex) {
+		LOG_ERROR("RequestReseed: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	}
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ConfigureReseed
+ * Signature: (JI)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ConfigureReseed(
+		JNIEnv*, jclass, jlong bytes, jint milliseconds) {
+
+	LOG_DEBUG("Entered ConfigureReseed");
+
+	if (bytes < 0 || milliseconds < 0) {
+		LOG_ERROR("ConfigureReseed: negative budget");
+		return 0;
+	}
+
+	return ConfigureReseed((unsigned long long) bytes, (double) milliseconds);
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_IsReady
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1IsReady(JNIEnv*,
+		jclass) {
+
+	LOG_DEBUG("Entered IsReady");
+
+	return IsReady();
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_AwaitReady
+ * Signature: (I)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1AwaitReady(
+		JNIEnv*, jclass, jint milliseconds) {
+
+	LOG_DEBUG("Entered AwaitReady");
+
+	return prng_await_ready(milliseconds);
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ConfigureParallel
+ * Signature: (JI)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ConfigureParallel(
+		JNIEnv*, jclass, jlong threshold, jint workers) {
+
+	LOG_DEBUG("Entered ConfigureParallel");
+
+	if (threshold < 0 || workers < 0) {
+		LOG_ERROR("ConfigureParallel: negative setting");
+		return 0;
+	}
+
+	return ConfigureParallel((size_t) threshold, (size_t) workers);
+}
+
+/* Streams are handed to Java as the RandomStream pointer. */
+static RandomStream* StreamFromHandle(jlong handle) {
+	return reinterpret_cast<RandomStream*>((intptr_t) handle);
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_OpenStream
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1OpenStream(
+		JNIEnv*, jclass) {
+
+	LOG_DEBUG("Entered OpenStream");
+
+	RandomStream* stream = new (std::nothrow) RandomStream;
+	if (stream == NULL) {
+		LOG_ERROR("OpenStream: failed to allocate stream");
+		return 0;
+	}
+
+	if (!stream->Start()) {
+		delete stream;
+		return 0;
+	}
+
+	return (jlong) (intptr_t) stream;
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_WriteStream
+ * Signature: (JIJ)J
+ */
+JNIEXPORT jlong JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1WriteStream(
+		JNIEnv*, jclass, jlong handle, jint fd, jlong count) {
+
+	LOG_DEBUG("Entered WriteStream");
+
+	RandomStream* stream = StreamFromHandle(handle);
+	if (stream == NULL) {
+		LOG_ERROR("WriteStream: stream is not valid");
+		return 0;
+	}
+
+	if (fd < 0 || count < 0) {
+		LOG_ERROR("WriteStream: descriptor or count is not valid");
+		return 0;
+	}
+
+	return (jlong) stream->WriteTo(fd, (unsigned long long) count);
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ReadStream
+ * Signature: (J[BII)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ReadStream(
+		JNIEnv* env, jclass, jlong handle, jbyteArray bytes, jint offset,
+		jint length) {
+
+	LOG_DEBUG("Entered ReadStream");
+
+	RandomStream* stream = StreamFromHandle(handle);
+	if (!env || stream == NULL) {
+		LOG_ERROR("ReadStream: stream is not valid");
+		return 0;
+	}
+
+	if (!bytes) {
+		LOG_WARN("ReadStream: byte array is NULL");
+		return 0;
+	}
+
+	if (!IsValidRange(offset, length,
+			(size_t) std::max<jsize>(env->GetArrayLength(bytes), 0))) {
+		LOG_ERROR("ReadStream: range is not valid");
+		return 0;
+	}
+
+	/* Copied straight out of the stream's buffer. Acquire may wait */
+	/*   on the producer, so the array is not pinned               */
+	MutexLock lock(stream->ConsumerLock());
+
+	size_t copied = 0;
+	while (copied < (size_t) length) {
+		size_t available;
+		const uint8_t* data = stream->Acquire(available);
+		if (data == NULL)
+			break;
+
+		const size_t n = std::min(available, (size_t) length - copied);
+		env->SetByteArrayRegion(bytes, offset + (jsize) copied, (jsize) n,
+				reinterpret_cast<const jbyte*>(data));
+
+		stream->Consume(n);
+		copied += n;
+	}
+
+	return (jint) copied;
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_CancelStream
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1CancelStream(
+		JNIEnv*, jclass, jlong handle) {
+
+	LOG_DEBUG("Entered CancelStream");
+
+	RandomStream* stream = StreamFromHandle(handle);
+	if (stream == NULL) {
+		LOG_ERROR("CancelStream: stream is not valid");
+		return 0;
+	}
+
+	stream->Cancel();
+	return 1;
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_CloseStream
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1CloseStream(
+		JNIEnv*, jclass, jlong handle) {
+
+	LOG_DEBUG("Entered CloseStream");
+
+	RandomStream* stream = StreamFromHandle(handle);
+	if (stream == NULL) {
+		LOG_ERROR("CloseStream: stream is not valid");
+		return 0;
+	}
+
+	delete stream;
+	return 1;
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StartDaemon
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StartDaemon(
+		JNIEnv* env, jclass, jstring path) {
+
+	LOG_DEBUG("Entered StartDaemon");
+
+	if (!env) {
+		LOG_ERROR("StartDaemon: environment is NULL");
+		return 0;
+	}
+
+	if (!path) {
+		LOG_ERROR("StartDaemon: path is NULL");
+		return 0;
+	}
+
+	ReadStringChars chars(env, path);
+	if (!chars.GetChars()) {
+		LOG_ERROR("StartDaemon: GetStringUTFChars failed");
+		return 0;
+	}
+
+	return StartDaemon(chars.GetChars());
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StopDaemon
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StopDaemon(
+		JNIEnv*, jclass) {
+
+	LOG_DEBUG("Entered StopDaemon");
+
+	return StopDaemon();
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_UseDaemon
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1UseDaemon(
+		JNIEnv* env, jclass, jstring path) {
+
+	LOG_DEBUG("Entered UseDaemon");
+
+	if (!env) {
+		LOG_ERROR("UseDaemon: environment is NULL");
+		return 0;
+	}
+
+	if (!path) {
+		return UseDaemon(NULL);
+	}
+
+	ReadStringChars chars(env, path);
+	if (!chars.GetChars()) {
+		LOG_ERROR("UseDaemon: GetStringUTFChars failed");
+		return 0;
+	}
+
+	return UseDaemon(chars.GetChars());
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_SelectBackend
+ * Signature: (I)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1SelectBackend(
+		JNIEnv*, jclass, jint type) {
+
+	LOG_DEBUG("Entered SelectBackend");
+
+	return SelectBackend(type);
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBackend
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBackend(
+		JNIEnv*, jclass) {
+
+	LOG_DEBUG("Entered GetBackend");
+
+	return GetBackend();
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StartRecording
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StartRecording(
+		JNIEnv* env, jclass, jstring path) {
+
+	LOG_DEBUG("Entered StartRecording");
+
+	if (!env) {
+		LOG_ERROR("StartRecording: environment is NULL");
+		return 0;
+	}
+
+	if (!path) {
+		LOG_WARN("StartRecording: path is NULL");
+		return 0;
+	}
+
+	ReadStringChars chars(env, path);
+	if (!chars.GetChars()) {
+		LOG_ERROR("StartRecording: GetStringUTFChars failed");
+		return 0;
+	}
+
+	return StartSensorRecording(chars.GetChars());
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StopRecording
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StopRecording(
+		JNIEnv*, jclass) {
+
+	LOG_DEBUG("Entered StopRecording");
+
+	return StopSensorRecording();
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_SetProfilePath
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1SetProfilePath(
+		JNIEnv* env, jclass, jstring path) {
+
+	LOG_DEBUG("Entered SetProfilePath");
+
+	if (!env) {
+		LOG_ERROR("SetProfilePath: environment is NULL");
+		return 0;
+	}
+
+	if (!path) {
+		return SetSensorProfilePath(NULL);
+	}
+
+	ReadStringChars chars(env, path);
+	if (!chars.GetChars()) {
+		LOG_ERROR("SetProfilePath: GetStringUTFChars failed");
+		return 0;
+	}
+
+	return SetSensorProfilePath(chars.GetChars());
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_SetSeedFile
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1SetSeedFile(
+		JNIEnv* env, jclass, jstring path) {
+
+	LOG_DEBUG("Entered SetSeedFile");
+
+	if (!env) {
+		LOG_ERROR("SetSeedFile: environment is NULL");
+		return 0;
+	}
+
+	if (!path) {
+		return SetSeedFilePath(NULL);
+	}
+
+	ReadStringChars chars(env, path);
+	if (!chars.GetChars()) {
+		LOG_ERROR("SetSeedFile: GetStringUTFChars failed");
+		return 0;
+	}
+
+	return SetSeedFilePath(chars.GetChars());
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetEntropyEstimates
+ * Signature: ([D)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetEntropyEstimates(
+		JNIEnv* env, jclass, jdoubleArray estimates) {
+
+	LOG_DEBUG("Entered GetEntropyEstimates");
+
+	if (!env) {
+		LOG_ERROR("GetEntropyEstimates: environment is NULL");
+		return 0;
+	}
+
+	if (!estimates) {
+		LOG_WARN("GetEntropyEstimates: double array is NULL");
+		return 0;
+	}
+
+	const size_t room = (size_t) env->GetArrayLength(estimates)
+			/ ESTIMATE_FIELDS;
+
+	std::vector<ChannelEstimate> channels(room);
+	const size_t n = std::min(room,
+			ReadEntropyEstimates(room ? &channels[0] : NULL, room));
+
+	std::vector<jdouble> values(n * ESTIMATE_FIELDS);
+	for (size_t i = 0; i < n; i++) {
+		jdouble* v = &values[i * ESTIMATE_FIELDS];
+		v[0] = channels[i].m_type;
+		v[1] = channels[i].m_channel;
+		v[2] = (jdouble) channels[i].m_samples;
+		v[3] = channels[i].m_minEntropy;
+		v[4] = (jdouble) channels[i].m_rctFailures;
+		v[5] = (jdouble) channels[i].m_aptFailures;
+	}
+
+	if (n)
+		env->SetDoubleArrayRegion(estimates, 0, (jsize) values.size(),
+				&values[0]);
+
+	return (jint) n;
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetStats
+ * Signature: ([J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetStats(
+		JNIEnv* env, jclass, jlongArray stats) {
+
+	LOG_DEBUG("Entered GetStats");
+
+	if (!env) {
+		LOG_ERROR("GetStats: environment is NULL");
+		return 0;
+	}
+
+	if (!stats) {
+		LOG_WARN("GetStats: long array is NULL");
+		return 0;
+	}
+
+	uint64_t counters[PRNG_STAT_COUNT];
+	const size_t n = prng_get_stats(counters, COUNTOF(counters));
+
+	jlong values[PRNG_STAT_COUNT];
+	for (size_t i = 0; i < n; i++) {
+		values[i] = (jlong) counters[i];
+	}
+
+	/* Copy as many as the caller has room for */
+	jsize count = env->GetArrayLength(stats);
+	count = std::min<jsize>(count, (jsize) n);
+
+	env->SetLongArrayRegion(stats, 0, count, values);
+
+	return count;
+}
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetLatencyStats
+ * Signature: ([J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetLatencyStats(
+		JNIEnv* env, jclass, jlongArray stats) {
+
+	LOG_DEBUG("Entered GetLatencyStats");
+
+	if (!env) {
+		LOG_ERROR("GetLatencyStats: environment is NULL");
+		return 0;
+	}
+
+	if (!stats) {
+		LOG_WARN("GetLatencyStats: long array is NULL");
+		return 0;
+	}
+
+	/* Whole stages only, as many as the caller has room for */
+	const jsize length = env->GetArrayLength(stats);
+
+	unsigned long long latency[STAGE_COUNT * LATENCY_FIELDS];
+	const size_t stages = ReadLatency(latency,
+			std::min<size_t>((size_t) length, COUNTOF(latency)));
+
+	jlong values[STAGE_COUNT * LATENCY_FIELDS];
+	for (size_t i = 0; i < stages * LATENCY_FIELDS; i++) {
+		values[i] = (jlong) latency[i];
+	}
+
+	env->SetLongArrayRegion(stats, 0, (jsize) (stages * LATENCY_FIELDS),
+			values);
+
+	return (jint) stages;
+}
+
+/* Generators are handed to Java as the FastRandom pointer. */
+static FastRandom* FastRandomFromHandle(jlong handle) {
+	return reinterpret_cast<FastRandom*>((intptr_t) handle);
+}
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_Create
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Create(
+		JNIEnv*, jclass, jlong seed) {
+
+	LOG_DEBUG("Entered NonCrypto_Create");
+
+	FastRandom* generator = new (std::nothrow) FastRandom((uint64_t) seed);
+	if (generator == NULL) {
+		LOG_ERROR("NonCrypto_Create: failed to allocate generator");
+		return 0;
+	}
+
+	return (jlong) (intptr_t) generator;
+}
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_Split
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Split(
+		JNIEnv*, jclass, jlong handle) {
+
+	LOG_DEBUG("Entered NonCrypto_Split");
+
+	FastRandom* generator = FastRandomFromHandle(handle);
+	if (generator == NULL) {
+		LOG_ERROR("NonCrypto_Split: generator is not valid");
+		return 0;
+	}
+
+	return (jlong) (intptr_t) generator->Split();
+}
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_Jump
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Jump(
+		JNIEnv*, jclass, jlong handle) {
+
+	LOG_DEBUG("Entered NonCrypto_Jump");
+
+	FastRandom* generator = FastRandomFromHandle(handle);
+	if (generator == NULL) {
+		LOG_ERROR("NonCrypto_Jump: generator is not valid");
+		return 0;
+	}
+
+	generator->Jump();
+	return 1;
+}
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_Destroy
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1Destroy(
+		JNIEnv*, jclass, jlong handle) {
+
+	LOG_DEBUG("Entered NonCrypto_Destroy");
+
+	FastRandom* generator = FastRandomFromHandle(handle);
+	if (generator == NULL) {
+		LOG_ERROR("NonCrypto_Destroy: generator is not valid");
+		return 0;
+	}
+
+	delete generator;
+	return 1;
+}
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_NextBytes
+ * Signature: (J[BII)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextBytes(
+		JNIEnv* env, jclass, jlong handle, jbyteArray bytes, jint offset,
+		jint length) {
+
+	LOG_DEBUG("Entered NonCrypto_NextBytes");
+
+	FastRandom* generator = FastRandomFromHandle(handle);
+	if (!env || generator == NULL) {
+		LOG_ERROR("NonCrypto_NextBytes: generator is not valid");
+		return 0;
+	}
+
+	if (!bytes) {
+		LOG_WARN("NonCrypto_NextBytes: byte array is NULL");
+		return 0;
+	}
+
+	WriteCriticalBuffer buffer(env, bytes);
+
+	if (buffer.GetByteArray() == NULL) {
+		LOG_ERROR("NonCrypto_NextBytes: array pointer is not valid");
+		return 0;
+	}
+
+	if (!IsValidRange(offset, length, buffer.GetArrayLen())) {
+		LOG_ERROR("NonCrypto_NextBytes: range is not valid");
+		return 0;
+	}
+
+	generator->FillBytes(buffer.GetByteArray() + offset, (size_t) length);
+	return length;
+}
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_NextInts
+ * Signature: (J[II)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextInts(
+		JNIEnv* env, jclass, jlong handle, jintArray values, jint bound) {
+
+	LOG_DEBUG("Entered NonCrypto_NextInts");
+
+	FastRandom* generator = FastRandomFromHandle(handle);
+	if (!env || generator == NULL) {
+		LOG_ERROR("NonCrypto_NextInts: generator is not valid");
+		return 0;
+	}
+
+	if (!values) {
+		LOG_WARN("NonCrypto_NextInts: int array is NULL");
+		return 0;
+	}
+
+	if (bound <= 0) {
+		LOG_ERROR("NonCrypto_NextInts: bound %d is not positive", (int )bound);
+		return 0;
+	}
+
+	WriteCriticalArray<jint> array(env, values);
+
+	jint* arr = array.GetArray();
+	size_t len = array.GetArrayLen();
+
+	if (arr == NULL || len == 0) {
+		LOG_ERROR("NonCrypto_NextInts: array is not valid");
+		return 0;
+	}
+
+	generator->FillInts(arr, len, (uint32_t) bound);
+	return (jint) len;
+}
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_NextLongs
+ * Signature: (J[JJJ)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextLongs(
+		JNIEnv* env, jclass, jlong handle, jlongArray values, jlong lo,
+		jlong hi) {
+
+	LOG_DEBUG("Entered NonCrypto_NextLongs");
+
+	FastRandom* generator = FastRandomFromHandle(handle);
+	if (!env || generator == NULL) {
+		LOG_ERROR("NonCrypto_NextLongs: generator is not valid");
+		return 0;
+	}
+
+	if (!values) {
+		LOG_WARN("NonCrypto_NextLongs: long array is NULL");
+		return 0;
+	}
+
+	if (lo >= hi) {
+		LOG_ERROR("NonCrypto_NextLongs: range is empty");
+		return 0;
+	}
+
+	WriteCriticalArray<jlong> array(env, values);
+
+	jlong* arr = array.GetArray();
+	size_t len = array.GetArrayLen();
+
+	if (arr == NULL || len == 0) {
+		LOG_ERROR("NonCrypto_NextLongs: array is not valid");
+		return 0;
+	}
+
+	generator->FillLongs(reinterpret_cast<int64_t*>(arr), len, lo, hi);
+	return (jint) len;
+}
+
+/*
+ * Class:     com_cryptopp_prng_NonCryptoRandom
+ * Method:    NonCrypto_NextDoubles
+ * Signature: (J[D)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_NonCryptoRandom_NonCrypto_1NextDoubles(
+		JNIEnv* env, jclass, jlong handle, jdoubleArray values) {
+
+	LOG_DEBUG("Entered NonCrypto_NextDoubles");
+
+	FastRandom* generator = FastRandomFromHandle(handle);
+	if (!env || generator == NULL) {
+		LOG_ERROR("NonCrypto_NextDoubles: generator is not valid");
+		return 0;
+	}
+
+	if (!values) {
+		LOG_WARN("NonCrypto_NextDoubles: double array is NULL");
+		return 0;
+	}
+
+	WriteCriticalArray<jdouble> array(env, values);
+
+	jdouble* arr = array.GetArray();
+	size_t len = array.GetArrayLen();
+
+	if (arr == NULL || len == 0) {
+		LOG_ERROR("NonCrypto_NextDoubles: array is not valid");
+		return 0;
+	}
+
+	generator->FillDoubles(arr, len);
+	return (jint) len;
+}
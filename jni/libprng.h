@@ -23,6 +23,294 @@ JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1Reseed
 JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytes
   (JNIEnv *, jclass, jbyteArray);
 
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StartHarvester
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StartHarvester
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StopHarvester
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StopHarvester
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_PauseHarvester
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1PauseHarvester
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ResumeHarvester
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ResumeHarvester
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ConfigureRing
+ * Signature: (III)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ConfigureRing
+  (JNIEnv *, jclass, jint, jint, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetStats
+ * Signature: ([J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetStats
+  (JNIEnv *, jclass, jlongArray);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ReseedRange
+ * Signature: ([BII)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ReseedRange
+  (JNIEnv *, jclass, jbyteArray, jint, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBytesRange
+ * Signature: ([BII)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesRange
+  (JNIEnv *, jclass, jbyteArray, jint, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBytesDirect
+ * Signature: (Ljava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesDirect
+  (JNIEnv *, jclass, jobject, jint, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBytesBatch
+ * Signature: ([[B)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesBatch
+  (JNIEnv *, jclass, jobjectArray);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_NextInts
+ * Signature: ([II)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1NextInts
+  (JNIEnv *, jclass, jintArray, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_NextLongs
+ * Signature: ([JJJ)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1NextLongs
+  (JNIEnv *, jclass, jlongArray, jlong, jlong);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_NextDoubles
+ * Signature: ([D)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1NextDoubles
+  (JNIEnv *, jclass, jdoubleArray);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_NextFloats
+ * Signature: ([F)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1NextFloats
+  (JNIEnv *, jclass, jfloatArray);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_SelectBackend
+ * Signature: (I)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1SelectBackend
+  (JNIEnv *, jclass, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBackend
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBackend
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StartRecording
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StartRecording
+  (JNIEnv *, jclass, jstring);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StopRecording
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StopRecording
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_SetProfilePath
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1SetProfilePath
+  (JNIEnv *, jclass, jstring);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetEntropyEstimates
+ * Signature: ([D)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetEntropyEstimates
+  (JNIEnv *, jclass, jdoubleArray);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_RequestReseed
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1RequestReseed
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ConfigureReseed
+ * Signature: (JI)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ConfigureReseed
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetLatencyStats
+ * Signature: ([J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetLatencyStats
+  (JNIEnv *, jclass, jlongArray);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_SetSeedFile
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1SetSeedFile
+  (JNIEnv *, jclass, jstring);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_IsReady
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1IsReady
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_AwaitReady
+ * Signature: (I)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1AwaitReady
+  (JNIEnv *, jclass, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ConfigureParallel
+ * Signature: (JI)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ConfigureParallel
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_OpenStream
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1OpenStream
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_WriteStream
+ * Signature: (JIJ)J
+ */
+JNIEXPORT jlong JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1WriteStream
+  (JNIEnv *, jclass, jlong, jint, jlong);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_ReadStream
+ * Signature: (J[BII)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1ReadStream
+  (JNIEnv *, jclass, jlong, jbyteArray, jint, jint);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_CancelStream
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1CancelStream
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_CloseStream
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1CloseStream
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StartDaemon
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StartDaemon
+  (JNIEnv *, jclass, jstring);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_StopDaemon
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1StopDaemon
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_UseDaemon
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1UseDaemon
+  (JNIEnv *, jclass, jstring);
+
+/*
+ * Class:     com_cryptopp_prng_PRNG
+ * Method:    CryptoPP_GetBytesWithin
+ * Signature: ([BJ)I
+ */
+JNIEXPORT jint JNICALL Java_com_cryptopp_prng_PRNG_CryptoPP_1GetBytesWithin
+  (JNIEnv *, jclass, jbyteArray, jlong);
+
 #ifdef __cplusplus
 }
 #endif
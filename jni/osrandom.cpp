@@ -0,0 +1,258 @@
+#include "prng.h"
+#include "osrandom.h"
+
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#if defined(__aarch64__)
+# include <sys/auxv.h>
+#endif
+
+#include <algorithm>
+
+#include <cryptopp/cpu.h>
+
+#ifndef GRND_NONBLOCK
+# define GRND_NONBLOCK 0x0001
+#endif
+
+#if defined(__aarch64__) && !defined(HWCAP2_RNG)
+# define HWCAP2_RNG (1 << 16)
+#endif
+
+/* RDRAND and RNDR can fail transiently when the hardware has not */
+/*   refilled; Intel recommends ten retries before giving up.     */
+static const int CPU_RANDOM_RETRIES = 10;
+
+/* Set once by DetectSources. */
+static KernelSource s_kernelSource = KERNEL_SOURCE_NONE;
+static CpuSource s_cpuSource = CPU_SOURCE_NONE;
+static pthread_once_t s_detectOnce = PTHREAD_ONCE_INIT;
+
+/* Opened on first use and never closed. O_CLOEXEC so it does not */
+/*   leak into exec'd children.                                   */
+static int s_urandomFd = -1;
+static pthread_once_t s_urandomOnce = PTHREAD_ONCE_INIT;
+
+static void OpenRandomDevice() {
+	do {
+		s_urandomFd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+	} while (s_urandomFd < 0 && errno == EINTR);
+
+	if (s_urandomFd < 0) {
+		LOG_ERROR("RandomDevice: failed to open /dev/urandom, error %d", errno);
+	}
+}
+
+/* Returns the bytes read, or -1 with errno set. */
+static ssize_t GetRandom(uint8_t* output, size_t size, unsigned int flags) {
+#if defined(__NR_getrandom)
+	return syscall(__NR_getrandom, output, size, flags);
+#else
+	(void) output, (void) size, (void) flags;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+#if (CRYPTOPP_BOOL_X86 || CRYPTOPP_BOOL_X32 || CRYPTOPP_BOOL_X64)
+
+/* Returns true if word was filled. The carry flag reports success. */
+static bool CpuRandomWord(unsigned long& word) {
+	for (int i = 0; i < CPU_RANDOM_RETRIES; i++) {
+		unsigned char ok;
+		if (s_cpuSource == CPU_SOURCE_RDSEED) {
+			__asm__ __volatile__ ("rdseed %0; setc %1"
+					: "=r" (word), "=qm" (ok) : : "cc");
+		} else {
+			__asm__ __volatile__ ("rdrand %0; setc %1"
+					: "=r" (word), "=qm" (ok) : : "cc");
+		}
+
+		if (ok)
+			return true;
+	}
+
+	return false;
+}
+
+static CpuSource DetectCpuSource() {
+	if (CryptoPP::HasRDSEED())
+		return CPU_SOURCE_RDSEED;
+	if (CryptoPP::HasRDRAND())
+		return CPU_SOURCE_RDRAND;
+	return CPU_SOURCE_NONE;
+}
+
+#elif defined(__aarch64__)
+
+/* RNDR is s3_3_c2_c4_0; it sets Z on failure. Spelled as a system */
+/*   register so older assemblers without ARMv8.5 accept it.       */
+static bool CpuRandomWord(unsigned long& word) {
+	for (int i = 0; i < CPU_RANDOM_RETRIES; i++) {
+		unsigned long ok;
+		__asm__ __volatile__ ("mrs %0, s3_3_c2_c4_0\n\tcset %1, ne"
+				: "=r" (word), "=r" (ok) : : "cc");
+
+		if (ok)
+			return true;
+	}
+
+	return false;
+}
+
+static CpuSource DetectCpuSource() {
+	if (getauxval(AT_HWCAP2) & HWCAP2_RNG)
+		return CPU_SOURCE_RNDR;
+	return CPU_SOURCE_NONE;
+}
+
+#else
+
+static bool CpuRandomWord(unsigned long&) {
+	return false;
+}
+
+static CpuSource DetectCpuSource() {
+	return CPU_SOURCE_NONE;
+}
+
+#endif
+
+/* A zero length getrandom call tells whether the kernel has it */
+/*   without consuming anything. Kernels before 3.17 return      */
+/*   ENOSYS; a seccomp filter may return EPERM.                  */
+static void DetectSources() {
+	uint8_t unused;
+	if (GetRandom(&unused, 0, GRND_NONBLOCK) == 0) {
+		s_kernelSource = KERNEL_SOURCE_GETRANDOM;
+	} else {
+		pthread_once(&s_urandomOnce, OpenRandomDevice);
+		s_kernelSource =
+				s_urandomFd >= 0 ? KERNEL_SOURCE_URANDOM : KERNEL_SOURCE_NONE;
+	}
+
+	s_cpuSource = DetectCpuSource();
+
+	LOG_INFO("RandomDevice: kernel source %s, CPU source %s",
+			KernelSourceName(s_kernelSource), CpuSourceName(s_cpuSource));
+}
+
+void DetectRandomSources() {
+	pthread_once(&s_detectOnce, DetectSources);
+}
+
+KernelSource GetKernelSource() {
+	DetectRandomSources();
+	return s_kernelSource;
+}
+
+CpuSource GetCpuSource() {
+	DetectRandomSources();
+	return s_cpuSource;
+}
+
+const char* KernelSourceName(KernelSource source) {
+	switch (source) {
+	case KERNEL_SOURCE_GETRANDOM:
+		return "getrandom";
+	case KERNEL_SOURCE_URANDOM:
+		return "/dev/urandom";
+	default:
+		return "none";
+	}
+}
+
+const char* CpuSourceName(CpuSource source) {
+	switch (source) {
+	case CPU_SOURCE_RDSEED:
+		return "RDSEED";
+	case CPU_SOURCE_RDRAND:
+		return "RDRAND";
+	case CPU_SOURCE_RNDR:
+		return "RNDR";
+	default:
+		return "none";
+	}
+}
+
+/* Loops over short reads and EINTR. */
+static bool ReadRandomDevice(uint8_t* output, size_t size) {
+	pthread_once(&s_urandomOnce, OpenRandomDevice);
+	if (s_urandomFd < 0)
+		return false;
+
+	TraceSection section(STAGE_URANDOM);
+
+	while (size > 0) {
+		const ssize_t n = read(s_urandomFd, output, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			LOG_ERROR("RandomDevice: failed to read /dev/urandom, error %d",
+					errno);
+			return false;
+		}
+
+		output += n;
+		size -= (size_t) n;
+	}
+
+	return true;
+}
+
+bool ReadKernelRandom(uint8_t* output, size_t size) {
+	DetectRandomSources();
+
+	if (s_kernelSource != KERNEL_SOURCE_GETRANDOM)
+		return ReadRandomDevice(output, size);
+
+	int error = 0;
+	{
+		TraceSection section(STAGE_GETRANDOM);
+
+		while (size > 0) {
+			const ssize_t n = GetRandom(output, size, GRND_NONBLOCK);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0) {
+				error = errno;
+				break;
+			}
+
+			output += n;
+			size -= (size_t) n;
+		}
+	}
+
+	if (size == 0)
+		return true;
+
+	/* EAGAIN early in boot, before the kernel pool is initialized */
+	LOG_WARN("RandomDevice: getrandom failed, error %d", error);
+	return ReadRandomDevice(output, size);
+}
+
+size_t ReadCpuRandom(uint8_t* output, size_t size) {
+	DetectRandomSources();
+
+	if (s_cpuSource == CPU_SOURCE_NONE)
+		return 0;
+
+	TraceSection section(STAGE_CPU_RANDOM);
+
+	for (size_t i = 0; i < size; i += sizeof(unsigned long)) {
+		unsigned long word;
+		if (!CpuRandomWord(word)) {
+			LOG_WARN("RandomDevice: %s failed", CpuSourceName(s_cpuSource));
+			return 0;
+		}
+
+		memcpy(output + i, &word, std::min(sizeof(word), size - i));
+	}
+
+	return size;
+}
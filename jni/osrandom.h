@@ -0,0 +1,41 @@
+/* Kernel and CPU random sources, picked at runtime. The kernel     */
+/* source is getrandom(2) where the kernel has it (3.17 and up),    */
+/* and otherwise a /dev/urandom descriptor opened once and kept for */
+/* the life of the process. The CPU source is RDSEED or RDRAND on   */
+/* x86, or RNDR on ARMv8.5, when the CPU advertises it. CPU output  */
+/* is only ever mixed in alongside kernel output, never credited.   */
+
+#ifndef _Included_com_cryptopp_prng_osrandom
+#define _Included_com_cryptopp_prng_osrandom
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum KernelSource {
+	KERNEL_SOURCE_NONE = 0, KERNEL_SOURCE_GETRANDOM, KERNEL_SOURCE_URANDOM
+};
+
+enum CpuSource {
+	CPU_SOURCE_NONE = 0, CPU_SOURCE_RDSEED, CPU_SOURCE_RDRAND, CPU_SOURCE_RNDR
+};
+
+/* Probes the sources. Runs once; the readers below call it too, so */
+/*   calling it early only moves the cost off the first read.       */
+void DetectRandomSources();
+
+KernelSource GetKernelSource();
+CpuSource GetCpuSource();
+
+const char* KernelSourceName(KernelSource source);
+const char* CpuSourceName(CpuSource source);
+
+/* Fills output from the kernel. Never blocks: if getrandom reports */
+/*   the kernel pool is not yet initialized, the read goes to the   */
+/*   urandom descriptor. Returns false on failure.                  */
+bool ReadKernelRandom(uint8_t* output, size_t size);
+
+/* Fills output from the CPU's generator. Returns size, or 0 if */
+/*   there is no CPU source or it kept failing.                 */
+size_t ReadCpuRandom(uint8_t* output, size_t size);
+
+#endif
@@ -0,0 +1,2726 @@
+#include "prng.h"
+
+#include <time.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <stdexcept>
+using std::runtime_error;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include <new>
+using std::nothrow;
+
+#include <cryptopp/osrng.h>
+using CryptoPP::AutoSeededRandomPool;
+
+#include <cryptopp/cryptlib.h>
+using CryptoPP::Exception;
+
+#include <cryptopp/misc.h>
+using CryptoPP::SecureWipeBuffer;
+
+#include <cryptopp/secblock.h>
+using CryptoPP::SecByteBlock;
+
+#include "backend.h"
+#include "sensorlog.h"
+#include "sensorprofile.h"
+#include "entropy.h"
+#include "seedfile.h"
+#include "accumulator.h"
+#include "osrandom.h"
+#include "workerpool.h"
+#include "daemon.h"
+
+static double TimeInMilliSeconds(double offset /*milliseconds*/);
+static int SamplesPerSecondToMicroSecond(int samples);
+static timespec DeadlineFromNow(double offset /*milliseconds*/);
+
+#ifndef NDEBUG
+static const char* SensorTypeToName(int sensorType);
+#endif
+
+/* The event rate requested from each sensor. Sensors report  */
+/* no faster than this, which gives them time to latch a new  */
+/* reading between events.                                    */
+static const int PREFERRED_INTERVAL_MICROSECONDS =
+		SamplesPerSecondToMicroSecond(30 /*samples per second*/);
+
+/* App_glue.h defines this. If its not defined, then define it. */
+#ifndef LOOPER_ID_USER
+# define LOOPER_ID_USER 3
+#endif
+
+static const int LOOPER_ID_PRNG = LOOPER_ID_USER + 1;
+
+/* Sampling time limit, in milliseconds. 200 to 400 ms is    */
+/* the sweet spot. Its the same time for the blink of an     */
+/* eye. Keep in mind that Java may add from 30 to 80 ms. A   */
+/* sensor rich device will be done in 125 ms because there   */
+/* are so many readings.                                     */
+static const double TIME_LIMIT_IN_MILLISECONDS = 0.250f * 1000;
+
+/* How many bytes to read from the kernel (getrandom or        */
+/* /dev/urandom, see osrandom.h). We read from the random      */
+/* device as a fallback to ensure something is read before     */
+/* providing bytes in GetBytes(). CPU output, when the CPU has */
+/* a generator, is mixed in alongside but not relied on.       */
+static const int RANDOM_DEVICE_BYTES = 16;
+static const int CPU_RANDOM_BYTES = 16;
+
+/* Seed requested from an entropy daemon (see daemon.h) each round. */
+/*   One daemon seed stands in for the sensor round and the random  */
+/*   device, since the daemon ran both.                             */
+static const int DAEMON_SEED_BYTES = 64;
+
+/* Deadline-aware requests (GenerateWithin) report the fresh entropy */
+/* mixed in for them. Sensor events are credited by the estimator;  */
+/* the kernel and the daemon are credited a full 8 bits a byte. CPU */
+/* output is not credited.                                          */
+static const double RANDOM_DEVICE_BITS = 8.0 * RANDOM_DEVICE_BYTES;
+static const double DAEMON_SEED_BITS = 8.0 * DAEMON_SEED_BYTES;
+
+/* A request with this little budget left after the round overhead */
+/* does not wait on the harvester; its thread mixes in the random  */
+/* device and generates at once. The overhead covers waking the    */
+/* harvester, disabling the sensors and the commit.                */
+static const double MIN_DEADLINE_ROUND_IN_MILLISECONDS = 5.0;
+static const double DEADLINE_ROUND_OVERHEAD_IN_MILLISECONDS = 2.0;
+
+/* Reseed policy. The harvester keeps the pool topped up in the */
+/* background, so GetBytes() never waits on the sensors, but it  */
+/* only runs a round when one of the triggers fires: this much   */
+/* time since the last round, or this much output. Both can be   */
+/* changed with CryptoPP_ConfigureReseed, and 0 turns a trigger  */
+/* off. A fork and CryptoPP_RequestReseed also trigger a reseed. */
+/* Each round costs at most TIME_LIMIT_IN_MILLISECONDS.          */
+static const double DEFAULT_RESEED_INTERVAL_IN_MILLISECONDS = 30.0f * 1000;
+static const unsigned long long DEFAULT_RESEED_BYTES = 16ULL * 1024 * 1024;
+
+/* Rounds triggered by output are at least this far apart, so a   */
+/* caller streaming output cannot keep the sensors on. It is also */
+/* the shortest time budget CryptoPP_ConfigureReseed accepts.     */
+static const double MIN_RESEED_INTERVAL_IN_MILLISECONDS = 1.0f * 1000;
+
+/* Each thread generates from its own backend so callers do not  */
+/* serialize on the central pool. A thread's generator is         */
+/* rekeyed from the central pool after it produces this many      */
+/* bytes, or sooner if new entropy arrives in the central pool.   */
+static const size_t THREAD_REKEY_BYTES = 1024 * 1024;
+
+/* Bytes drawn from the central pool to key a thread generator. */
+static const size_t THREAD_SEED_BYTES = 32;
+
+/* Small requests (tokens, nonces, IVs) are served from a ring of  */
+/* pre-generated output kept by each thread. When the ring drops   */
+/* below the low water mark it is refilled in one bulk call.       */
+/* Requests larger than the maximum bypass the ring. All three are */
+/* tunable at runtime with CryptoPP_ConfigureRing.                 */
+static const size_t DEFAULT_RING_SIZE = 4096;
+static const size_t DEFAULT_RING_LOW_WATER = 1024;
+static const size_t DEFAULT_RING_MAX_REQUEST = 256;
+
+/* Bounds for CryptoPP_ConfigureRing. A ring size of 0 disables it. */
+static const size_t MAX_RING_SIZE = 1024 * 1024;
+
+/* Requests this large are split across a pool of worker threads. */
+/* Each task fills its own chunk of the caller's buffer from a     */
+/* fresh generator keyed from the calling thread's. Both settings  */
+/* are tunable with CryptoPP_ConfigureParallel; 0 workers turns    */
+/* splitting off. By default there is a worker for each core       */
+/* besides the caller's, up to DEFAULT_MAX_PARALLEL_WORKERS.       */
+static const size_t DEFAULT_PARALLEL_THRESHOLD = 1024 * 1024;
+static const size_t MIN_PARALLEL_THRESHOLD = 64 * 1024;
+static const size_t DEFAULT_MAX_PARALLEL_WORKERS = 8;
+static const size_t MAX_PARALLEL_WORKERS = 16;
+
+/* A request is cut into about this many tasks per thread, so a */
+/*   thread that is descheduled does not hold up the rest, but   */
+/*   never into chunks smaller than MIN_PARALLEL_CHUNK.          */
+static const size_t PARALLEL_TASKS_PER_THREAD = 4;
+static const size_t MIN_PARALLEL_CHUNK = 64 * 1024;
+
+/* How many of ASensorEvent::data[] carry a reading for a sensor type. */
+struct SensorLayout {
+	int m_type;
+	int m_channels;
+};
+
+/* http://developer.android.com/reference/android/hardware/SensorEvent.html */
+static const SensorLayout s_sensorLayouts[] = {
+	{ ASENSOR_TYPE_ACCELEROMETER, 3 },
+	{ ASENSOR_TYPE_MAGNETIC_FIELD, 3 },
+	{ 3 /*Orientation*/, 3 },
+	{ ASENSOR_TYPE_GYROSCOPE, 3 },
+	{ ASENSOR_TYPE_LIGHT, 1 },
+	{ 6 /*Pressure*/, 1 },
+	{ 7 /*Temperature*/, 1 },
+	{ ASENSOR_TYPE_PROXIMITY, 1 },
+	{ 9 /*Gravity*/, 3 },
+	{ 10 /*Linear acceleration*/, 3 },
+	{ 11 /*Rotation vector, x y z cos accuracy*/, 5 },
+	{ 12 /*Relative humidity*/, 1 },
+	{ 13 /*Ambient temperature*/, 1 },
+	{ 14 /*Uncalibrated magnetic field, xyz and bias*/, 6 },
+	{ 15 /*Game rotation vector, x y z cos*/, 4 },
+	{ 16 /*Uncalibrated gyroscope, xyz and drift*/, 6 },
+	{ 17 /*Significant motion*/, 1 },
+	{ 18 /*Step detector*/, 1 },
+	{ 19 /*Step counter, uint64_t*/, 2 },
+	{ 20 /*Geo-magnetic rotation vector, x y z cos accuracy*/, 5 },
+	{ 21 /*Heart rate, bpm and status*/, 2 },
+};
+
+/* Unknown sensor types are treated as a three value vector */
+static const int DEFAULT_SENSOR_CHANNELS = 3;
+
+/* Every so often a collection round becomes a profiling round: it */
+/* runs for PROFILE_WINDOW_IN_MILLISECONDS with one sensor of each */
+/* type enabled, and measures how much each type delivers. Other   */
+/* rounds enable only the fewest, best types expected to deliver   */
+/* ENTROPY_TARGET_BITS and SENSOR_SAMPLE_COUNT events within       */
+/* TIME_LIMIT_IN_MILLISECONDS. Slow and event driven sensors (step */
+/* counter, significant motion, heart rate) drop out, and so do    */
+/* their enable and disable calls.                                 */
+static const double PROFILE_WINDOW_IN_MILLISECONDS = 1.0f * 1000;
+static const double PROFILE_REFRESH_IN_MILLISECONDS = 30.0f * 60 * 1000;
+
+/* A collection round ends as soon as its events are credited with */
+/* this much min-entropy, 32 bytes' worth for the pool. A round    */
+/* that ends at the time limit short of it is topped up from the   */
+/* random device by the harvester.                                 */
+static const double ENTROPY_TARGET_BITS = 256.0;
+
+/* Bytes drawn from the central pool for the seed file, and how   */
+/* often the harvester rewrites it. It is also rewritten when the */
+/* harvester is paused or stopped, since the app may be killed    */
+/* without warning once it is in the background.                  */
+static const size_t SEED_FILE_BYTES = 64;
+static const double SEED_SAVE_INTERVAL_IN_MILLISECONDS = 10.0f * 60 * 1000;
+
+struct Sensor {
+	Sensor() :
+			m_type(0), m_sensor(NULL) {
+	}
+
+	explicit Sensor(int type, string name, const ASensor* sensor) :
+			m_type(type), m_name(name), m_sensor(sensor) {
+	}
+
+	int m_type;
+	string m_name;
+	const ASensor* m_sensor;
+};
+
+typedef vector<Sensor> SensorArray;
+
+/* The current sensor ranking, guarded by s_rankingLock. */
+struct SensorRanking {
+	SensorRanking() :
+			m_selected(0), m_profiled(0.0), m_loaded(false) {
+	}
+
+	// One profile per sensor type, best first
+	SensorProfiles m_profiles;
+
+	// How many of m_profiles steady-state rounds enable
+	size_t m_selected;
+
+	// TimeInMilliSeconds() of the profiling round, 0 if never profiled
+	double m_profiled;
+
+	// Optional cache file, and whether it has been read
+	string m_path;
+	bool m_loaded;
+};
+
+static SensorRanking s_ranking;
+static pthread_mutex_t s_rankingLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The seed file, guarded by s_seedLock. An empty path turns it off. */
+struct SeedFile {
+	SeedFile() :
+			m_saved(0.0) {
+	}
+
+	string m_path;
+
+	// TimeInMilliSeconds() of the last save
+	double m_saved;
+};
+
+static SeedFile s_seedFile;
+static pthread_mutex_t s_seedLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Per-channel health tests and estimates. Shared by every collector, */
+/*   since they describe the sensors; guarded by s_entropyLock.       */
+static EntropyEstimator s_entropy;
+static pthread_mutex_t s_entropyLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* State shared between the harvester thread and the JNI entry    */
+/* points. Everything is guarded by s_harvestLock. The sensor     */
+/* session (looper and queue) lives on the harvester's stack, so  */
+/* it is only ever touched by the harvester thread.               */
+struct Harvester {
+	Harvester() :
+			m_thread(), m_running(0), m_paused(0), m_stop(0), m_restart(0), m_rounds(
+					0), m_limit(
+					0.0), m_waited(0), m_collecting(0), m_roundEnd(0.0), m_credited(
+					0.0) {
+	}
+
+	pthread_t m_thread;
+
+	// Set while the thread exists (between start and join)
+	int m_running;
+
+	// Set by PauseHarvester(true); the thread idles until cleared
+	int m_paused;
+
+	// Set by StopHarvester(); the thread exits at the next check
+	int m_stop;
+
+	// Set in a forked child whose parent had the harvester running;
+	//   ReseedAfterFork starts a new one
+	int m_restart;
+
+	// Completed collection rounds. Deadline waiters watch it too
+	unsigned long m_rounds;
+
+	// Sampling window asked for by deadline waiters, 0 for the default
+	double m_limit;
+
+	// Set when a deadline waiter asked for the next round, which then
+	//   never profiles, since profiling outlasts any deadline
+	int m_waited;
+
+	// Set while a round runs, with the time its sampling window ends,
+	//   the profiling window if it profiles
+	int m_collecting;
+	double m_roundEnd;
+
+	// Bits credited to the last completed round (see GenerateWithin)
+	double m_credited;
+};
+
+static Harvester s_harvester;
+
+/* What caused a harvester round. Each trigger but the first round */
+/*   has a STAT_RESEED_* counter. A fork is not a harvester trigger; */
+/*   ReseedAfterFork counts STAT_RESEED_FORK itself.                 */
+enum ReseedTrigger {
+	RESEED_NONE = 0, RESEED_START, RESEED_BYTES, RESEED_TIME, RESEED_EXPLICIT
+};
+
+/* Reseed budgets and the usage counted against them. */
+struct ReseedPolicy {
+	ReseedPolicy() :
+			m_bytes(DEFAULT_RESEED_BYTES), m_interval(
+					DEFAULT_RESEED_INTERVAL_IN_MILLISECONDS), m_output(0), m_pending(
+					0), m_requested(0), m_last(0.0) {
+	}
+
+	// Budgets, 0 for off. m_bytes is read with __atomic on the hot
+	// path; both are written under s_harvestLock
+	unsigned long long m_bytes;
+	double m_interval;
+
+	// Output since the last round. Relaxed __atomic adds
+	unsigned long long m_output;
+
+	// Set by the caller whose output crossed m_bytes, so only one
+	// caller takes s_harvestLock to wake the harvester. __atomic
+	int m_pending;
+
+	// Set by RequestReseed. Guarded by s_harvestLock
+	int m_requested;
+
+	// TimeInMilliSeconds() at the end of the last round. Guarded by
+	// s_harvestLock
+	double m_last;
+};
+
+static ReseedPolicy s_reseed;
+
+/* Open while a recording is running. Every collector appends to it. */
+static SensorRecorder s_recorder;
+static pthread_mutex_t s_harvestLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_harvestCond = PTHREAD_COND_INITIALIZER;
+
+/* Broadcast under s_harvestLock at the end of every round, for */
+/*   deadline waiters. The harvester never waits on it.        */
+static pthread_cond_t s_roundCond = PTHREAD_COND_INITIALIZER;
+
+/* AutoSeededRandomPool is not thread safe, and the harvester   */
+/* thread mixes into it while JNI callers generate from it.     */
+static pthread_mutex_t s_poolLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The central pool. Constructing it reads the OS generator, so */
+/* the warm-up thread builds it at load; see GetPRNG.           */
+static AutoSeededRandomPool* s_pool = NULL;
+static pthread_once_t s_poolOnce = PTHREAD_ONCE_INIT;
+
+/* The device's sensors, listed once; see GetSensorArray. */
+static SensorArray s_sensorArray;
+static pthread_once_t s_sensorOnce = PTHREAD_ONCE_INIT;
+
+/* Warm-up progress. JNI_OnLoad starts a thread that builds the */
+/* pool and the sensor list, and readiness waits for the first  */
+/* entropy round as well. Callers that arrive early only wait   */
+/* on what they use: GenerateBlock on the pool's pthread_once,  */
+/* the collector on the sensor list's. Guarded by s_warmLock.   */
+enum WarmStage {
+	WARM_GENERATOR = 1, WARM_SENSORS = 2, WARM_ENTROPY = 4, WARM_ALL = 7
+};
+
+static int s_warmState = 0;
+static pthread_mutex_t s_warmLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_warmCond = PTHREAD_COND_INITIALIZER;
+
+/* Sources stage raw input here without locking. CommitLocked    */
+/* conditions it into the pool in one call, under s_poolLock,    */
+/* which also guards the drain buffer. s_commitPending asks the  */
+/* next GenerateBlock to commit; it is accessed with __atomic.   */
+static EntropyAccumulator s_accumulator;
+static SecByteBlock s_drained(ACCUMULATOR_CAPACITY);
+static int s_commitPending = 0;
+
+/* Bumped each time entropy is mixed into the central pool. A   */
+/* thread generator keyed under an older generation is rekeyed  */
+/* on its next use. Accessed with the __atomic builtins.        */
+static unsigned long s_poolGeneration = 0;
+
+/* Set in a child process by the pthread_atfork handler, and cleared */
+/*   once the child has reseeded. Accessed with the __atomic builtins. */
+static int s_forked = 0;
+static pthread_mutex_t s_forkLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t s_forkOnce = PTHREAD_ONCE_INIT;
+
+/* The PID AddProcessInfo last saw, to notice a fork that skipped */
+/*   the atfork handlers, such as a raw clone. __atomic.            */
+static pid_t s_processId = 0;
+
+/* Ring settings. Written under s_ringLock; threads notice a change */
+/*   through m_version and copy the settings into their own state.  */
+struct RingConfig {
+	RingConfig() :
+			m_size(DEFAULT_RING_SIZE), m_lowWater(DEFAULT_RING_LOW_WATER), m_maxRequest(
+					DEFAULT_RING_MAX_REQUEST), m_version(1) {
+	}
+
+	size_t m_size;
+	size_t m_lowWater;
+	size_t m_maxRequest;
+	unsigned long m_version;
+};
+
+static RingConfig s_ringConfig;
+static pthread_mutex_t s_ringLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The backend thread generators are built with. Set with       */
+/*   CryptoPP_SelectBackend; threads notice the change through    */
+/*   s_backendVersion and switch on their next request.           */
+static int s_backendType = BACKEND_AUTO;
+static unsigned long s_backendVersion = 1;
+static pthread_mutex_t s_backendLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Settings for splitting large requests, read with __atomic loads */
+/*   on each large request and written by ConfigureParallel.       */
+static size_t DefaultParallelWorkers() {
+	const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cores <= 1)
+		return 0;
+
+	return std::min((size_t) cores - 1, DEFAULT_MAX_PARALLEL_WORKERS);
+}
+
+struct ParallelConfig {
+	ParallelConfig() :
+			m_threshold(DEFAULT_PARALLEL_THRESHOLD), m_workers(
+					DefaultParallelWorkers()) {
+	}
+
+	size_t m_threshold;
+	size_t m_workers;
+};
+
+static ParallelConfig s_parallel;
+static WorkerPool s_workers;
+
+/* Per-thread generator state, owned by the s_threadKey slot. */
+struct ThreadState {
+	ThreadState() :
+			m_prng(NULL), m_backendVersion(0), m_generation(0), m_produced(0), m_keyed(
+					false), m_ringHead(0), m_ringCount(0), m_ringLowWater(0), m_ringMaxRequest(
+					0), m_ringVersion(0) {
+	}
+
+	~ThreadState() {
+		// Backends wipe their key material in their destructors
+		delete m_prng;
+	}
+
+	// The thread's generator, NULL until the first request
+	Backend* m_prng;
+
+	// s_backendVersion the generator was built under
+	unsigned long m_backendVersion;
+
+	// Central pool generation this generator was keyed under
+	unsigned long m_generation;
+
+	// Bytes produced since the last rekey
+	size_t m_produced;
+
+	// Set once the generator has been keyed from the central pool
+	bool m_keyed;
+
+	// Pre-generated output. Consumed bytes are wiped immediately.
+	SecByteBlock m_ring;
+
+	// Offset of the first unread byte, and the number of unread bytes
+	size_t m_ringHead;
+	size_t m_ringCount;
+
+	// Copies of the RingConfig settings this ring was built with
+	size_t m_ringLowWater;
+	size_t m_ringMaxRequest;
+	unsigned long m_ringVersion;
+
+private:
+	// Not copyable
+	ThreadState(const ThreadState&);
+	ThreadState& operator=(const ThreadState&);
+};
+
+static pthread_key_t s_threadKey;
+static pthread_once_t s_threadOnce = PTHREAD_ONCE_INIT;
+static bool s_threadKeyValid = false;
+
+#ifndef NDEBUG
+struct RawFloat {
+	union {
+		byte b[sizeof(float)];
+		uint32_t n;
+		float f;
+	};
+};
+#endif
+
+/* Return the time in milliseconds. If offset = 0.0f, then it returns  */
+/*  now. Positive offsets are milliseconds into the future. Negative   */
+/*  offsets are milliseconds in the past.                              */
+static double TimeInMilliSeconds(double offset /*seconds*/= 0.0f) {
+	struct timespec res;
+	clock_gettime(CLOCK_REALTIME, &res);
+
+	double t = 1000.0 * (double) res.tv_sec + (double) res.tv_nsec / 1e6;
+	return t + offset;
+}
+
+/* Return an absolute CLOCK_REALTIME deadline offset milliseconds */
+/*  into the future. Suitable for pthread_cond_timedwait.          */
+static timespec DeadlineFromNow(double offset /*milliseconds*/) {
+	struct timespec res;
+	clock_gettime(CLOCK_REALTIME, &res);
+
+	long long nsec = (long long) res.tv_nsec + (long long) (offset * 1e6);
+	res.tv_sec += (time_t) (nsec / 1000000000LL);
+	res.tv_nsec = (long) (nsec % 1000000000LL);
+
+	return res;
+}
+
+/* Given a sample rate, returns the microseconds in an interval */
+static int SamplesPerSecondToMicroSecond(int samples) {
+	return (int) ((1 / (double) samples) * 1000 * 1000);
+}
+
+static void CreatePool() {
+	try {
+		s_pool = new AutoSeededRandomPool;
+	} catch (const Exception& ex) {
+		LOG_ERROR("Pool: Crypto++ exception: \"%s\"", ex.what());
+	} catch (const std::bad_alloc&) {
+		LOG_ERROR("Pool: failed to allocate pool");
+	}
+}
+
+/* Builds the pool on first use; a caller that races the warm-up */
+/*   thread waits for its construction to finish. Throws if the  */
+/*   pool could not be built.                                    */
+static AutoSeededRandomPool& GetPRNG() {
+	pthread_once(&s_poolOnce, CreatePool);
+
+	if (s_pool == NULL)
+		throw Exception(Exception::OTHER_ERROR, "Pool: not available");
+
+	return *s_pool;
+}
+
+/* Conditions everything staged into the pool in one call. The */
+/*   caller holds s_poolLock. Returns the bytes committed.       */
+static size_t CommitLocked() {
+	const size_t drained = s_accumulator.Drain(s_drained.data());
+	if (drained == 0)
+		return 0;
+
+	{
+		TraceSection section(STAGE_MIX);
+		GetPRNG().IncorporateEntropy(s_drained.data(), drained);
+	}
+
+	SecureWipeBuffer(s_drained.data(), drained);
+	__atomic_add_fetch(&s_poolGeneration, 1, __ATOMIC_RELEASE);
+
+	AddStat(STAT_ENTROPY_COMMITS);
+	AddStat(STAT_ENTROPY_COMMIT_BYTES, drained);
+
+	return drained;
+}
+
+/* All access to the central pool goes through these. They     */
+/*   throw Crypto++ exceptions; the lock is released by         */
+/*   MutexLock. Output for callers comes from GenerateBlock      */
+/*   below, which uses the calling thread's generator.          */
+
+/* Stages input for the next commit. Lock free unless the calling */
+/*   thread's shard is full or the input is larger than a shard;  */
+/*   then the shard is committed along with the input.            */
+void IncorporateEntropy(const byte* input, size_t length) {
+	{
+		TraceSection section(STAGE_ACCUMULATE);
+		if (s_accumulator.Append(input, length))
+			return;
+	}
+
+	AddStat(STAT_ACCUMULATOR_OVERFLOWS);
+
+	MutexLock lock(s_poolLock);
+	(void) CommitLocked();
+
+	TraceSection section(STAGE_MIX);
+	GetPRNG().IncorporateEntropy(input, length);
+
+	__atomic_add_fetch(&s_poolGeneration, 1, __ATOMIC_RELEASE);
+}
+
+/* Returns the bytes committed. Thread generators rekey on their */
+/*   next use if any were.                                      */
+size_t CommitEntropy() {
+	__atomic_store_n(&s_commitPending, 0, __ATOMIC_RELAXED);
+
+	MutexLock lock(s_poolLock);
+	return CommitLocked();
+}
+
+void ScheduleCommit() {
+	__atomic_store_n(&s_commitPending, 1, __ATOMIC_RELEASE);
+}
+
+static void GeneratePoolBlock(byte* output, size_t size) {
+	MutexLock lock(s_poolLock);
+	GetPRNG().GenerateBlock(output, size);
+}
+
+/* Counts output against the byte budget. This is on the hot path, */
+/*   so it only touches counters; the one caller whose output       */
+/*   crosses the budget wakes the harvester.                        */
+static void CountOutput(size_t size) {
+	const unsigned long long output = __atomic_add_fetch(&s_reseed.m_output,
+			(unsigned long long) size, __ATOMIC_RELAXED);
+	const unsigned long long budget = __atomic_load_n(&s_reseed.m_bytes,
+			__ATOMIC_RELAXED);
+
+	if (budget == 0 || output < budget)
+		return;
+
+	if (__atomic_exchange_n(&s_reseed.m_pending, 1, __ATOMIC_RELAXED))
+		return;
+
+	MutexLock lock(s_harvestLock);
+	pthread_cond_broadcast(&s_harvestCond);
+}
+
+/* A forked child starts with a copy of the parent's pool and thread */
+/*   generators, so without a reseed it would repeat the parent's    */
+/*   output. The handlers hold the pool and harvest locks across the */
+/*   fork so the child does not inherit them locked by a thread that */
+/*   no longer exists.                                               */
+static void PrepareFork() {
+	pthread_mutex_lock(&s_harvestLock);
+	pthread_mutex_lock(&s_poolLock);
+}
+
+static void ParentAfterFork() {
+	pthread_mutex_unlock(&s_poolLock);
+	pthread_mutex_unlock(&s_harvestLock);
+}
+
+static void ChildAfterFork() {
+	/* The harvester thread did not survive the fork */
+	s_harvester.m_restart = s_harvester.m_running && !s_harvester.m_stop;
+	s_harvester.m_running = 0;
+	s_harvester.m_stop = 0;
+	s_harvester.m_collecting = 0;
+	s_harvester.m_limit = 0.0;
+
+	/* Appends in flight on other threads will never finish */
+	s_accumulator.ResetAfterFork();
+	s_workers.ResetAfterFork();
+
+	__atomic_store_n(&s_forked, 1, __ATOMIC_RELEASE);
+
+	pthread_mutex_unlock(&s_poolLock);
+	pthread_mutex_unlock(&s_harvestLock);
+}
+
+static void InstallForkHandlers() {
+	__atomic_store_n(&s_processId, getpid(), __ATOMIC_RELAXED);
+
+	int rc = pthread_atfork(PrepareFork, ParentAfterFork, ChildAfterFork);
+	if (rc != 0) {
+		LOG_ERROR("Reseed: pthread_atfork failed, error %d", rc);
+	}
+}
+
+static int LaunchHarvesterLocked();
+
+/* Runs before the first output in a forked child, and counts the */
+/*   reseed once. The random device makes the child's pool        */
+/*   independent of the parent's. If the parent had a harvester,  */
+/*   the child gets its own, so the byte and time triggers keep   */
+/*   firing.                                                      */
+static void ReseedAfterFork() {
+	{
+		MutexLock lock(s_forkLock);
+
+		if (!__atomic_load_n(&s_forked, __ATOMIC_ACQUIRE))
+			return;
+
+		(void) AddProcessInfo();
+		if (AddRandomDevice() <= 0) {
+			LOG_ERROR("Reseed: failed to reseed after fork");
+		}
+
+		(void) CommitEntropy();
+		AddStat(STAT_RESEED_FORK);
+
+		__atomic_store_n(&s_reseed.m_output, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&s_reseed.m_pending, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&s_forked, 0, __ATOMIC_RELEASE);
+	}
+
+	MutexLock lock(s_harvestLock);
+
+	if (s_harvester.m_restart && !s_harvester.m_running) {
+		s_harvester.m_restart = 0;
+		(void) LaunchHarvesterLocked();
+	}
+}
+
+/* Runs when a thread with a generator exits. JNI attached      */
+/*   threads exit after DetachCurrentThread, so this also cleans */
+/*   up after threads in long lived Java thread pools.          */
+static void DestroyThreadState(void* data) {
+	ThreadState* state = reinterpret_cast<ThreadState*>(data);
+	delete state;
+}
+
+static void CreateThreadKey() {
+	pthread_once(&s_forkOnce, InstallForkHandlers);
+
+	int rc = pthread_key_create(&s_threadKey, DestroyThreadState);
+	if (rc != 0) {
+		LOG_ERROR("ThreadState: pthread_key_create failed, error %d", rc);
+		return;
+	}
+
+	s_threadKeyValid = true;
+}
+
+/* Returns the calling thread's state, creating it on first use. */
+/*   Returns NULL if the state could not be created, in which    */
+/*   case callers fall back to the central pool.                 */
+static ThreadState* GetThreadState() {
+	pthread_once(&s_threadOnce, CreateThreadKey);
+	if (!s_threadKeyValid)
+		return NULL;
+
+	ThreadState* state = reinterpret_cast<ThreadState*>(pthread_getspecific(
+			s_threadKey));
+	if (state != NULL)
+		return state;
+
+	state = new (nothrow) ThreadState;
+	if (state == NULL) {
+		LOG_ERROR("ThreadState: failed to allocate state");
+		return NULL;
+	}
+
+	if (pthread_setspecific(s_threadKey, state) != 0) {
+		LOG_ERROR("ThreadState: pthread_setspecific failed");
+		delete state;
+		return NULL;
+	}
+
+	LOG_DEBUG("ThreadState: created state for thread %lu",
+			(unsigned long )pthread_self());
+
+	return state;
+}
+
+/* Key the thread generator from the central pool. IncorporateEntropy */
+/*   keeps the existing state, so a rekey never loses what the        */
+/*   thread already had.                                              */
+static void RekeyThreadState(ThreadState& state, unsigned long generation) {
+	byte seed[THREAD_SEED_BYTES];
+
+	GeneratePoolBlock(seed, sizeof(seed));
+	state.m_prng->IncorporateEntropy(seed, sizeof(seed));
+	SecureWipeBuffer(seed, sizeof(seed));
+
+	state.m_generation = generation;
+	state.m_produced = 0;
+	state.m_keyed = true;
+}
+
+/* Build the thread generator with the selected backend. The new */
+/*   generator starts unkeyed, so it is keyed from the central    */
+/*   pool before first use. On failure the old one is kept.       */
+static void ReplaceBackend(ThreadState& state, unsigned long version) {
+	const BackendType type = (BackendType) __atomic_load_n(&s_backendType,
+			__ATOMIC_RELAXED);
+
+	Backend* backend = NewBackend(type);
+	if (backend == NULL) {
+		LOG_ERROR("ThreadState: failed to create %s backend",
+				BackendName(ResolveBackend(type)));
+		return;
+	}
+
+	delete state.m_prng;
+	state.m_prng = backend;
+	state.m_backendVersion = version;
+	state.m_keyed = false;
+
+	LOG_DEBUG("ThreadState: using %s backend",
+			BackendName(backend->GetType()));
+}
+
+/* Generate straight from the thread generator, no ring. */
+static void GenerateThreadBlock(ThreadState& state, byte* output, size_t size) {
+	state.m_prng->GenerateBlock(output, size);
+	state.m_produced += size;
+
+	CountOutput(size);
+}
+
+/* Discard the unread ring contents. Called when the thread generator */
+/*   is rekeyed, so output buffered under an old key is never served  */
+/*   after new entropy arrives.                                       */
+static void WipeRing(ThreadState& state) {
+	if (state.m_ring.size())
+		SecureWipeBuffer(state.m_ring.data(), state.m_ring.size());
+
+	state.m_ringHead = 0;
+	state.m_ringCount = 0;
+}
+
+/* Pick up new ring settings from CryptoPP_ConfigureRing. */
+static void ReconfigureRing(ThreadState& state) {
+	MutexLock lock(s_ringLock);
+
+	state.m_ring.New(s_ringConfig.m_size);
+	state.m_ringHead = 0;
+	state.m_ringCount = 0;
+	state.m_ringLowWater = s_ringConfig.m_lowWater;
+	state.m_ringMaxRequest = s_ringConfig.m_maxRequest;
+	state.m_ringVersion = s_ringConfig.m_version;
+}
+
+/* Top the ring up to full with one bulk generate per free segment. */
+static void RefillRing(ThreadState& state) {
+	const size_t size = state.m_ring.size();
+	const size_t tail = (state.m_ringHead + state.m_ringCount) % size;
+	const size_t space = size - state.m_ringCount;
+
+	if (space == 0)
+		return;
+
+	const size_t first = std::min(space, size - tail);
+	GenerateThreadBlock(state, state.m_ring.data() + tail, first);
+
+	if (space > first)
+		GenerateThreadBlock(state, state.m_ring.data(), space - first);
+
+	state.m_ringCount = size;
+
+	AddStat(STAT_RING_REFILLS);
+	AddStat(STAT_RING_REFILL_BYTES, space);
+}
+
+/* Copy size bytes out of the ring and wipe them. The caller ensures */
+/*   the ring holds at least size bytes.                             */
+static void ReadRing(ThreadState& state, byte* output, size_t size) {
+	byte* ring = state.m_ring.data();
+	const size_t ringSize = state.m_ring.size();
+
+	const size_t first = std::min(size, ringSize - state.m_ringHead);
+	memcpy(output, ring + state.m_ringHead, first);
+	SecureWipeBuffer(ring + state.m_ringHead, first);
+
+	if (size > first) {
+		memcpy(output + first, ring, size - first);
+		SecureWipeBuffer(ring, size - first);
+	}
+
+	state.m_ringHead = (state.m_ringHead + size) % ringSize;
+	state.m_ringCount -= size;
+}
+
+/* One large request, split into chunks. Task i fills chunk i, keyed */
+/*   with the i-th THREAD_SEED_BYTES of m_keys.                      */
+struct ParallelJob {
+	BackendType m_type;
+	byte* m_output;
+	size_t m_size;
+	size_t m_chunk;
+	const byte* m_keys;
+
+	// Set by a task that failed. Accessed with __atomic
+	int m_failed;
+};
+
+static void GenerateChunk(void* context, size_t index) {
+	TraceSection section(STAGE_PARALLEL_CHUNK);
+
+	ParallelJob* job = reinterpret_cast<ParallelJob*>(context);
+
+	const size_t offset = index * job->m_chunk;
+	const size_t size = std::min(job->m_chunk, job->m_size - offset);
+
+	/* A fresh generator per chunk; the destructor wipes its key */
+	Backend* backend = NewBackend(job->m_type);
+	if (backend == NULL) {
+		__atomic_store_n(&job->m_failed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	try {
+		backend->IncorporateEntropy(job->m_keys + index * THREAD_SEED_BYTES,
+				THREAD_SEED_BYTES);
+		backend->GenerateBlock(job->m_output + offset, size);
+	} catch (const Exception& ex) {
+		LOG_ERROR("Parallel: Crypto++ exception: \"%s\"", ex.what());
+		__atomic_store_n(&job->m_failed, 1, __ATOMIC_RELAXED);
+	}
+
+	delete backend;
+}
+
+/* Fills output on the worker pool and the calling thread, writing */
+/*   straight into the caller's buffer. Chunk keys are drawn from  */
+/*   the calling thread's generator, so chunks are independent     */
+/*   streams. Returns false, leaving the request to the caller's   */
+/*   generator, for small requests, when another request holds the */
+/*   pool, or if a chunk failed.                                   */
+static bool GenerateParallel(ThreadState& state, byte* output, size_t size) {
+	const size_t threshold = __atomic_load_n(&s_parallel.m_threshold,
+			__ATOMIC_RELAXED);
+	const size_t workers = __atomic_load_n(&s_parallel.m_workers,
+			__ATOMIC_RELAXED);
+
+	if (workers == 0 || size < threshold)
+		return false;
+
+	const size_t threads = workers + 1;
+	size_t chunk = std::max(MIN_PARALLEL_CHUNK,
+			size / (threads * PARALLEL_TASKS_PER_THREAD));
+	chunk = (chunk + 63) & ~(size_t) 63;
+	const size_t count = (size + chunk - 1) / chunk;
+
+	SecByteBlock keys(count * THREAD_SEED_BYTES);
+	state.m_prng->GenerateBlock(keys.data(), keys.size());
+	state.m_produced += keys.size();
+
+	ParallelJob job;
+	job.m_type = state.m_prng->GetType();
+	job.m_output = output;
+	job.m_size = size;
+	job.m_chunk = chunk;
+	job.m_keys = keys.data();
+	job.m_failed = 0;
+
+	if (!s_workers.TryRun(workers, GenerateChunk, &job, count)
+			|| __atomic_load_n(&job.m_failed, __ATOMIC_RELAXED)) {
+		AddStat(STAT_PARALLEL_FALLBACKS);
+		return false;
+	}
+
+	AddStat(STAT_PARALLEL_REQUESTS);
+	CountOutput(size);
+
+	return true;
+}
+
+/* Generate output for a caller. Uses the calling thread's generator, */
+/*   rekeying it first if the central pool changed or the byte budget */
+/*   ran out. Only the rekey touches the central pool lock. Small     */
+/*   requests are served from the thread's ring.                      */
+void GenerateBlock(byte* output, size_t size) {
+	TraceSection section(STAGE_GENERATE);
+
+	if (__atomic_load_n(&s_forked, __ATOMIC_ACQUIRE)) {
+		ReseedAfterFork();
+	}
+
+	if (__atomic_load_n(&s_commitPending, __ATOMIC_ACQUIRE)) {
+		(void) CommitEntropy();
+	}
+
+	ThreadState* state = GetThreadState();
+	if (state == NULL) {
+		GeneratePoolBlock(output, size);
+		CountOutput(size);
+		return;
+	}
+
+	const unsigned long backendVersion = __atomic_load_n(&s_backendVersion,
+			__ATOMIC_ACQUIRE);
+	if (state->m_backendVersion != backendVersion) {
+		ReplaceBackend(*state, backendVersion);
+	}
+
+	if (state->m_prng == NULL) {
+		GeneratePoolBlock(output, size);
+		CountOutput(size);
+		return;
+	}
+
+	const unsigned long version = __atomic_load_n(&s_ringConfig.m_version,
+			__ATOMIC_ACQUIRE);
+	if (state->m_ringVersion != version) {
+		ReconfigureRing(*state);
+	}
+
+	const unsigned long generation = __atomic_load_n(&s_poolGeneration,
+			__ATOMIC_ACQUIRE);
+
+	if (!state->m_keyed || state->m_generation != generation
+			|| state->m_produced >= THREAD_REKEY_BYTES) {
+		RekeyThreadState(*state, generation);
+		WipeRing(*state);
+	}
+
+	if (size == 0 || size > state->m_ringMaxRequest
+			|| state->m_ring.size() == 0) {
+		AddStat(STAT_RING_BYPASSES);
+		if (!GenerateParallel(*state, output, size))
+			GenerateThreadBlock(*state, output, size);
+		return;
+	}
+
+	if (state->m_ringCount < size) {
+		AddStat(STAT_RING_MISSES);
+		RefillRing(*state);
+	} else {
+		AddStat(STAT_RING_HITS);
+	}
+
+	ReadRing(*state, output, size);
+
+	/* Refill at the low water mark so the next request is a hit */
+	if (state->m_ringCount < state->m_ringLowWater) {
+		RefillRing(*state);
+	}
+}
+
+/* Returns the resolved backend type, or 0 if type is not known. */
+int SelectBackend(int type) {
+	const BackendType resolved = ResolveBackend((BackendType) type);
+	if (resolved == BACKEND_AUTO) {
+		LOG_ERROR("Backend: type %d is not valid", type);
+		return 0;
+	}
+
+	MutexLock lock(s_backendLock);
+
+	__atomic_store_n(&s_backendType, type, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&s_backendVersion, 1, __ATOMIC_RELEASE);
+
+	LOG_INFO("Backend: selected %s", BackendName(resolved));
+
+	return resolved;
+}
+
+/* Returns the backend in use, with BACKEND_AUTO resolved. */
+int GetBackend() {
+	const int type = __atomic_load_n(&s_backendType, __ATOMIC_RELAXED);
+	return ResolveBackend((BackendType) type);
+}
+
+/* Returns 1 if the settings were accepted, 0 if they are invalid.  */
+/*   A size of 0 disables the ring. Otherwise the low water mark    */
+/*   must be below the size and a maximal request must fit in ring. */
+int ConfigureRing(size_t size, size_t lowWater, size_t maxRequest) {
+	if (size > MAX_RING_SIZE) {
+		LOG_ERROR("Ring: size %d is too large", (int )size);
+		return 0;
+	}
+
+	if (size != 0 && (lowWater >= size || maxRequest > size)) {
+		LOG_ERROR("Ring: watermarks %d and %d do not fit size %d",
+				(int )lowWater, (int )maxRequest, (int )size);
+		return 0;
+	}
+
+	MutexLock lock(s_ringLock);
+
+	s_ringConfig.m_size = size;
+	s_ringConfig.m_lowWater = lowWater;
+	s_ringConfig.m_maxRequest = (size == 0) ? 0 : maxRequest;
+	__atomic_add_fetch(&s_ringConfig.m_version, 1, __ATOMIC_RELEASE);
+
+	LOG_INFO("Ring: size %d, low water %d, max request %d", (int )size,
+			(int )lowWater, (int )maxRequest);
+
+	return 1;
+}
+
+/* Returns 1 if the settings were accepted, 0 if they are invalid. */
+int ConfigureParallel(size_t threshold, size_t workers) {
+	if (threshold < MIN_PARALLEL_THRESHOLD) {
+		LOG_ERROR("Parallel: threshold %d is too small", (int )threshold);
+		return 0;
+	}
+
+	if (workers > MAX_PARALLEL_WORKERS) {
+		LOG_ERROR("Parallel: %d workers is too many", (int )workers);
+		return 0;
+	}
+
+	/* The pool resizes itself on the next large request */
+	__atomic_store_n(&s_parallel.m_threshold, threshold, __ATOMIC_RELAXED);
+	__atomic_store_n(&s_parallel.m_workers, workers, __ATOMIC_RELAXED);
+
+	LOG_INFO("Parallel: threshold %d, %d workers", (int )threshold,
+			(int )workers);
+
+	return 1;
+}
+
+/* Draws words from the thread generator in small blocks. The typed */
+/*   fills below take their bulk output straight from GenerateBlock; */
+/*   this only serves the rare extra draws made by rejection.        */
+class WordSource {
+public:
+	WordSource() :
+			m_pos(sizeof(m_buf)) {
+	}
+
+	~WordSource() {
+		SecureWipeBuffer(m_buf, sizeof(m_buf));
+	}
+
+	uint32_t Next32() {
+		uint32_t w;
+		Next(&w, sizeof(w));
+		return w;
+	}
+
+	uint64_t Next64() {
+		uint64_t w;
+		Next(&w, sizeof(w));
+		return w;
+	}
+
+private:
+	void Next(void* output, size_t size) {
+		if (m_pos + size > sizeof(m_buf)) {
+			GenerateBlock(m_buf, sizeof(m_buf));
+			m_pos = 0;
+		}
+
+		memcpy(output, m_buf + m_pos, size);
+		m_pos += size;
+	}
+
+	byte m_buf[64];
+	size_t m_pos;
+};
+
+/* Fill out with unbiased values in [0, bound). The array is filled   */
+/*   with keystream in one call and reduced in place with Lemire's    */
+/*   multiply-shift. A product whose low half falls below 2^32 mod    */
+/*   bound is rejected and redrawn, which removes the modulo bias.    */
+void FillInts(int32_t* output, size_t count, uint32_t bound) {
+	GenerateBlock((byte*) output, count * sizeof(uint32_t));
+
+	const uint32_t threshold = (0u - bound) % bound;
+	WordSource extra;
+
+	for (size_t i = 0; i < count; i++) {
+		uint32_t x;
+		memcpy(&x, &output[i], sizeof(x));
+
+		uint64_t m = (uint64_t) x * bound;
+		while ((uint32_t) m < threshold) {
+			x = extra.Next32();
+			m = (uint64_t) x * bound;
+		}
+
+		output[i] = (int32_t) (m >> 32);
+	}
+}
+
+/* Fill out with unbiased values in [lo, hi). Same approach as FillInts */
+/*   with a 64x64 multiply. The caller ensures lo < hi.                 */
+void FillLongs(int64_t* output, size_t count, int64_t lo, int64_t hi) {
+	GenerateBlock((byte*) output, count * sizeof(uint64_t));
+
+	const uint64_t range = (uint64_t) hi - (uint64_t) lo;
+	const uint64_t threshold = (0ull - range) % range;
+	WordSource extra;
+
+	for (size_t i = 0; i < count; i++) {
+		uint64_t x, low, high;
+		memcpy(&x, &output[i], sizeof(x));
+
+		high = MultiplyHigh64(x, range, low);
+		while (low < threshold) {
+			x = extra.Next64();
+			high = MultiplyHigh64(x, range, low);
+		}
+
+		output[i] = (int64_t) ((uint64_t) lo + high);
+	}
+}
+
+/* Fill out with doubles in [0, 1) from the top 53 bits of each word. */
+/*   No rejection, so the conversion loop is branch free.             */
+void FillDoubles(double* output, size_t count) {
+	GenerateBlock((byte*) output, count * sizeof(uint64_t));
+
+	for (size_t i = 0; i < count; i++) {
+		uint64_t x;
+		memcpy(&x, &output[i], sizeof(x));
+		output[i] = (double) (x >> 11) * (1.0 / 9007199254740992.0);
+	}
+}
+
+/* Fill out with floats in [0, 1) from the top 24 bits of each word. */
+void FillFloats(float* output, size_t count) {
+	GenerateBlock((byte*) output, count * sizeof(uint32_t));
+
+	for (size_t i = 0; i < count; i++) {
+		uint32_t x;
+		memcpy(&x, &output[i], sizeof(x));
+		output[i] = (float) (x >> 8) * (1.0f / 16777216.0f);
+	}
+}
+
+static void BuildSensorArray() {
+	LOG_DEBUG("SensorArray: initializing list");
+
+	ASensorList sensorArray;
+	ASensorManager* sensorManager = ASensorManager_getInstance();
+	int n = ASensorManager_getSensorList(sensorManager, &sensorArray);
+
+	if (n < 0) {
+		LOG_ERROR("SensorArray: failed to retrieve list");
+	} else if (n == 0) {
+		LOG_WARN("SensorArray: no sensors available");
+	} else {
+		s_sensorArray.reserve(static_cast<size_t>(n));
+
+		for (int i = 0; i < n; i++) {
+			const ASensor* sensor = sensorArray[i];
+			if (sensor == NULL)
+				continue;
+
+			const char* name = ASensor_getName(sensor);
+			int type = ASensor_getType(sensor);
+
+#ifndef NDEBUG
+			const char* vendor = ASensor_getVendor(sensor);
+			int min_delay = ASensor_getMinDelay(sensor);
+			float resolution = ASensor_getResolution(sensor);
+
+			LOG_DEBUG("SensorArray: %s (%s) %d %d %f", name, vendor, type,
+					min_delay, resolution);
+#endif
+
+			s_sensorArray.push_back(Sensor(type, name, sensor));
+		}
+
+		LOG_DEBUG("SensorArray: added %d sensors", (int )s_sensorArray.size());
+	}
+}
+
+/* Lists the sensors on first use; a caller that races the warm-up */
+/*   thread waits for the list to be complete.                     */
+static const SensorArray& GetSensorArray() {
+	pthread_once(&s_sensorOnce, BuildSensorArray);
+	return s_sensorArray;
+}
+
+static int SensorChannels(int type) {
+	for (size_t i = 0; i < COUNTOF(s_sensorLayouts); i++) {
+		if (s_sensorLayouts[i].m_type == type)
+			return s_sensorLayouts[i].m_channels;
+	}
+
+	return DEFAULT_SENSOR_CHANNELS;
+}
+
+/* Copy the variable parts of n events into staging and return the  */
+/*   number of bytes staged. Timestamps go first as one array, then */
+/*   the value channels, so the whole drain hashes in one call.     */
+static size_t StageSensorEvents(const ASensorEvent* events, int n,
+		byte* staging) {
+	byte* stamps = staging;
+	byte* values = staging + n * STAGED_STAMP_BYTES;
+
+	for (int i = 0; i < n; i++) {
+		const uint32_t stamp = (uint32_t) events[i].timestamp;
+		memcpy(stamps, &stamp, STAGED_STAMP_BYTES);
+		stamps += STAGED_STAMP_BYTES;
+
+		const int channels = SensorChannels(events[i].type);
+		for (int c = 0; c < channels; c++) {
+			uint32_t bits;
+			memcpy(&bits, &events[i].data[c], sizeof(bits));
+
+			/* Low order mantissa bits. Step counter words are integers */
+			/*   and are handled the same way.                          */
+			const uint16_t low = (uint16_t) bits;
+			memcpy(values, &low, STAGED_VALUE_BYTES);
+			values += STAGED_VALUE_BYTES;
+		}
+	}
+
+	return (size_t) (values - staging);
+}
+
+static void ProfileSensorEvents(SensorProfiles& profiles,
+		const ASensorEvent* events, int n) {
+	for (int i = 0; i < n; i++) {
+		for (size_t j = 0; j < profiles.size(); j++) {
+			if (profiles[j].m_type == events[i].type) {
+				ObserveSensorEvent(profiles[j], events[i],
+						SensorChannels(events[i].type));
+				break;
+			}
+		}
+	}
+}
+
+static const ASensor* FirstSensorOfType(const SensorArray& sensorArray,
+		int type) {
+	for (size_t i = 0; i < sensorArray.size(); i++) {
+		if (sensorArray[i].m_type == type && sensorArray[i].m_sensor)
+			return sensorArray[i].m_sensor;
+	}
+	return NULL;
+}
+
+/* True if every sensor type on the device has a profile */
+static bool ProfilesCover(const SensorProfiles& profiles,
+		const SensorArray& sensorArray) {
+	for (size_t i = 0; i < sensorArray.size(); i++) {
+		bool found = false;
+		for (size_t j = 0; j < profiles.size() && !found; j++)
+			found = (profiles[j].m_type == sensorArray[i].m_type);
+		if (!found)
+			return false;
+	}
+	return true;
+}
+
+/* Caller holds s_rankingLock */
+static void RankSensors(SensorProfiles& profiles, double profiled) {
+	RankSensorProfiles(profiles);
+
+	s_ranking.m_profiles = profiles;
+	s_ranking.m_selected = SelectSensorProfiles(profiles,
+			TIME_LIMIT_IN_MILLISECONDS, ENTROPY_TARGET_BITS, SENSOR_SAMPLE_COUNT);
+	s_ranking.m_profiled = profiled;
+
+	for (size_t i = 0; i < profiles.size(); i++) {
+		const SensorProfile& p = profiles[i];
+		LOG_INFO("SensorProfile: %s%s, %.3f events/ms, %.1f bits/event, "
+				"%.2f bits/ms", i < s_ranking.m_selected ? "* " : "",
+				p.m_name.c_str(), p.EventsPerMilliSecond(), p.BitsPerEvent(),
+				p.BitsPerMilliSecond());
+	}
+}
+
+/* True if there is no ranking yet, or it misses one of the sensors */
+/*   present. Loads the cache file on first use. Called with          */
+/*   s_rankingLock held.                                              */
+static bool RankingStaleLocked(const SensorArray& sensorArray) {
+	if (!s_ranking.m_loaded && !s_ranking.m_path.empty()) {
+		SensorProfiles loaded;
+		double profiled = 0.0;
+
+		if (LoadSensorProfiles(s_ranking.m_path.c_str(), loaded, profiled)) {
+			LOG_DEBUG("SensorProfile: loaded %s", s_ranking.m_path.c_str());
+			RankSensors(loaded, profiled);
+		}
+		s_ranking.m_loaded = true;
+	}
+
+	return s_ranking.m_profiled == 0.0
+			|| !ProfilesCover(s_ranking.m_profiles, sensorArray);
+}
+
+/* True if the next full-length round should profile. The harvester */
+/*   asks before it publishes the round's end, since a profiling     */
+/*   round runs for PROFILE_WINDOW_IN_MILLISECONDS instead.          */
+static bool ProfileDue(const SensorArray& sensorArray) {
+	MutexLock lock(s_rankingLock);
+
+	const double age = TimeInMilliSeconds() - s_ranking.m_profiled;
+
+	/* A clock set backwards also makes the profile stale */
+	return RankingStaleLocked(sensorArray) || age < 0.0
+			|| age > PROFILE_REFRESH_IN_MILLISECONDS;
+}
+
+/* Picks the sensors for a round of limit milliseconds. A profiling  */
+/*   round, decided by the caller with ProfileDue, gets one sensor   */
+/*   and one entry in profiles per sensor type. A round shorter than */
+/*   the default plans only with the sensors expected to report      */
+/*   within it, so it may choose none.                               */
+static void ChooseSensors(const SensorArray& sensorArray, double limit,
+		bool profile, vector<const ASensor*>& chosen,
+		SensorProfiles& profiles) {
+	MutexLock lock(s_rankingLock);
+
+	/* Also loads the cache file, which the steady state ranks from */
+	const bool stale = RankingStaleLocked(sensorArray);
+
+	if (profile) {
+		for (size_t i = 0; i < sensorArray.size(); i++) {
+			const Sensor& sensor = sensorArray[i];
+			if (sensor.m_sensor == NULL
+					|| FirstSensorOfType(sensorArray, sensor.m_type)
+							!= sensor.m_sensor)
+				continue;
+
+			chosen.push_back(sensor.m_sensor);
+			profiles.push_back(SensorProfile(sensor.m_type, sensor.m_name));
+		}
+
+		return;
+	}
+
+	if (limit < TIME_LIMIT_IN_MILLISECONDS) {
+		if (stale) {
+			for (size_t i = 0; i < sensorArray.size(); i++) {
+				if (sensorArray[i].m_sensor)
+					chosen.push_back(sensorArray[i].m_sensor);
+			}
+			return;
+		}
+
+		/* The event target shrinks with the window */
+		const size_t selected = SelectSensorProfiles(s_ranking.m_profiles,
+				limit, ENTROPY_TARGET_BITS,
+				SENSOR_SAMPLE_COUNT * limit / TIME_LIMIT_IN_MILLISECONDS);
+
+		for (size_t i = 0; i < selected; i++) {
+			const ASensor* sensor = FirstSensorOfType(sensorArray,
+					s_ranking.m_profiles[i].m_type);
+			if (sensor)
+				chosen.push_back(sensor);
+		}
+
+		return;
+	}
+
+	for (size_t i = 0; i < s_ranking.m_selected; i++) {
+		const ASensor* sensor = FirstSensorOfType(sensorArray,
+				s_ranking.m_profiles[i].m_type);
+		if (sensor)
+			chosen.push_back(sensor);
+	}
+
+	/* Nothing measured well; enable everything as before profiling */
+	if (chosen.empty()) {
+		for (size_t i = 0; i < sensorArray.size(); i++) {
+			if (sensorArray[i].m_sensor)
+				chosen.push_back(sensorArray[i].m_sensor);
+		}
+	}
+}
+
+static void StoreSensorProfiles(SensorProfiles& profiles, double window) {
+	for (size_t i = 0; i < profiles.size(); i++)
+		profiles[i].m_window = window;
+
+	MutexLock lock(s_rankingLock);
+
+	const double now = TimeInMilliSeconds();
+	RankSensors(profiles, now);
+
+	if (!s_ranking.m_path.empty())
+		SaveSensorProfiles(s_ranking.m_path.c_str(), s_ranking.m_profiles,
+				now);
+}
+
+int SetSensorProfilePath(const char* path) {
+	MutexLock lock(s_rankingLock);
+
+	s_ranking.m_path = path ? path : "";
+	s_ranking.m_loaded = false;
+
+	return 1;
+}
+
+/* Replaces the seed file with a fresh seed from the central pool. */
+/*   Called with s_seedLock held. If the file cannot be replaced   */
+/*   it is removed, so an old seed is never read twice.            */
+static bool SaveSeedLocked() {
+	if (s_seedFile.m_path.empty())
+		return false;
+
+	TraceSection section(STAGE_SEED_SAVE);
+
+	const char* path = s_seedFile.m_path.c_str();
+	byte seed[SEED_FILE_BYTES];
+	bool saved = false;
+
+	try {
+		GeneratePoolBlock(seed, sizeof(seed));
+		saved = SaveSeedFile(path, seed, sizeof(seed));
+	} catch (const Exception& ex) {
+		LOG_ERROR("SeedFile: Crypto++ exception: \"%s\"", ex.what());
+	}
+
+	SecureWipeBuffer(seed, sizeof(seed));
+
+	if (saved) {
+		AddStat(STAT_SEED_SAVES);
+		s_seedFile.m_saved = TimeInMilliSeconds();
+	} else {
+		AddStat(STAT_SEED_FAILURES);
+		RemoveSeedFile(path);
+	}
+
+	return saved;
+}
+
+/* Saves the seed if force is set or the save interval has passed. */
+static void SaveSeed(bool force) {
+	MutexLock lock(s_seedLock);
+
+	if (!force && TimeInMilliSeconds() - s_seedFile.m_saved
+			< SEED_SAVE_INTERVAL_IN_MILLISECONDS)
+		return;
+
+	(void) SaveSeedLocked();
+}
+
+/* Mixes in the seed saved by an earlier process, if there is one, */
+/*   and replaces it straight away. Returns 1 if a seed was mixed  */
+/*   in, 0 if not. A NULL path turns the seed file off.            */
+int SetSeedFilePath(const char* path) {
+	MutexLock lock(s_seedLock);
+
+	s_seedFile.m_path = path ? path : "";
+	s_seedFile.m_saved = 0.0;
+
+	if (s_seedFile.m_path.empty())
+		return 0;
+
+	int loaded = 0;
+	byte seed[SEED_FILE_BYTES];
+
+	{
+		TraceSection section(STAGE_SEED_LOAD);
+
+		if (LoadSeedFile(path, seed, sizeof(seed))) {
+			try {
+				IncorporateEntropy(seed, sizeof(seed));
+				(void) CommitEntropy();
+				AddStat(STAT_SEED_LOADS);
+				loaded = 1;
+
+				LOG_DEBUG("SeedFile: mixed in seed from %s", path);
+			} catch (const Exception& ex) {
+				LOG_ERROR("SeedFile: Crypto++ exception: \"%s\"", ex.what());
+			}
+		}
+	}
+
+	SecureWipeBuffer(seed, sizeof(seed));
+
+	/* Never leave a used seed behind */
+	(void) SaveSeedLocked();
+
+	return loaded;
+}
+
+/* Runs the health tests and returns the min-entropy credited to n */
+/*   events. Channels failing a test are credited nothing for the   */
+/*   rest of the round; their bytes are still mixed in.             */
+static double CreditSensorEvents(const ASensorEvent* events, int n) {
+	MutexLock lock(s_entropyLock);
+
+	const unsigned long rct = s_entropy.RctFailures();
+	const unsigned long apt = s_entropy.AptFailures();
+
+	double credited = 0.0;
+	for (int i = 0; i < n; i++)
+		credited += s_entropy.Observe(events[i], SensorChannels(events[i].type));
+
+	if (s_entropy.RctFailures() != rct) {
+		LOG_WARN("SensorData: repetition count test failed");
+		AddStat(STAT_HEALTH_RCT_FAILURES, s_entropy.RctFailures() - rct);
+	}
+	if (s_entropy.AptFailures() != apt) {
+		LOG_WARN("SensorData: adaptive proportion test failed");
+		AddStat(STAT_HEALTH_APT_FAILURES, s_entropy.AptFailures() - apt);
+	}
+
+	return credited;
+}
+
+/* Resets the per-round state before a collection round. */
+static void BeginSensorRound(SensorContext& context) {
+	context.m_signaled = 0;
+	context.m_total = 0;
+	context.m_bytes = 0;
+	context.m_credited = 0.0;
+
+	MutexLock lock(s_entropyLock);
+	s_entropy.BeginRound();
+}
+
+static void EndSensorRound(SensorContext& context) {
+	AddStat(STAT_SENSOR_ROUNDS);
+	AddStat(STAT_SENSOR_CREDITED_BITS, (unsigned long long) context.m_credited);
+
+	if (context.m_credited >= ENTROPY_TARGET_BITS)
+		AddStat(STAT_SENSOR_TARGET_MET);
+}
+
+size_t ReadEntropyEstimates(ChannelEstimate* estimates, size_t count) {
+	MutexLock lock(s_entropyLock);
+	return s_entropy.Snapshot(estimates, count);
+}
+
+/* Read everything waiting in the queue and mix it into the pool. */
+/*   Returns the number of events drained.                        */
+static int DrainSensorEvents(SensorContext& context) {
+	int drained = 0;
+
+	for (;;) {
+		ssize_t n;
+		if (context.m_replay) {
+			n = (ssize_t) context.m_replay->ReadEvents(context.m_events,
+					COUNTOF(context.m_events));
+		} else {
+			n = ASensorEventQueue_getEvents(context.m_queue, context.m_events,
+					COUNTOF(context.m_events));
+		}
+
+		if (n <= 0)
+			break;
+
+		/* Recorded events are on disk in the clear, so they are */
+		/*   mixed in but not credited; the round then tops up   */
+		/*   from the random device.                             */
+		const bool recorded = context.m_replay == NULL && s_recorder.IsOpen();
+		if (recorded)
+			s_recorder.Record(context.m_events, (size_t) n);
+
+		if (context.m_profiles)
+			ProfileSensorEvents(*context.m_profiles, context.m_events, (int) n);
+
+		/* The health tests still see every event */
+		const double credited = CreditSensorEvents(context.m_events, (int) n);
+		if (!recorded)
+			context.m_credited += credited;
+
+#ifndef NDEBUG
+		for (ssize_t i = 0; i < n; i++) {
+			const ASensorEvent ee = context.m_events[i];
+			const ASensorVector vv = ee.vector;
+			LOG_DEBUG("SensorData: %s, v[0]: %.9f, v[1]: %.9f, v[2]: %.9f ",
+					SensorTypeToName(ee.type), vv.v[0], vv.v[1], vv.v[2]);
+
+			RawFloat x, y, z;
+			x.f = vv.x, y.f = vv.y, z.f = vv.z;
+			LOG_DEBUG("                x: %08x, y: %08x, z: %08x",
+					(unsigned int) x.n, (unsigned int) y.n, (unsigned int) z.n);
+		}
+#endif
+
+		const size_t staged = StageSensorEvents(context.m_events, (int) n,
+				context.m_staging);
+
+		try {
+			IncorporateEntropy(context.m_staging, staged);
+		} catch (Exception& ex) {
+			LOG_ERROR("SensorData: Crypto++ exception: \"%s\"", ex.what());
+		}
+
+		SecureWipeBuffer(context.m_staging, staged);
+
+		LOG_DEBUG("SensorData: added %d events, %d bytes", (int )n,
+				(int )staged);
+
+		drained += (int) n;
+		context.m_bytes += (int) staged;
+	}
+
+	context.m_total += drained;
+	return drained;
+}
+
+/* Looper callback for the sensor queue. ALooper_pollOnce in */
+/*   AddSensorData calls it as soon as events are readable.  */
+static int SensorEvent(int fd, int events, void* data) {
+
+	LOG_DEBUG("Entered SensorEvent");
+
+	SensorContext* context = reinterpret_cast<SensorContext*>(data);
+	if (!context) {
+		LOG_ERROR("SensorEvent: context is not valid");
+		return 0;
+	}
+
+	/**************** Return Values ****************/
+	/* 1: keep the callback; 0: unregister it.     */
+	/***********************************************/
+
+	/* Events that arrive between rounds, after the sensors */
+	/*   are disabled, are drained by the next round.       */
+	if (context->m_signaled) {
+		LOG_DEBUG("SensorEvent: signaled, leaving events queued");
+		return 1;
+	}
+
+	DrainSensorEvents(*context);
+
+	/* A profiling round runs for its whole window */
+	if (context->m_credited >= ENTROPY_TARGET_BITS
+			&& context->m_profiles == NULL) {
+		LOG_DEBUG("SensorData: reached entropy target of %.0f bits",
+				ENTROPY_TARGET_BITS);
+		context->m_signaled = 1;
+	}
+
+	/* The session outlives the round, so always stay registered */
+	return 1;
+}
+
+/* Records a finished warm-up stage and wakes AwaitReady. */
+static void MarkWarm(int stage) {
+	MutexLock lock(s_warmLock);
+
+	if ((s_warmState & stage) == stage)
+		return;
+
+	s_warmState |= stage;
+	pthread_cond_broadcast(&s_warmCond);
+}
+
+/* Mixes in process info and the random device if no round has */
+/*   yet, so readiness does not wait on a harvester that is not */
+/*   going to run one.                                          */
+static void EnsureInitialEntropy() {
+	{
+		MutexLock lock(s_warmLock);
+		if (s_warmState & WARM_ENTROPY)
+			return;
+	}
+
+	(void) AddProcessInfo();
+	int added = AddDaemonSeed();
+	if (added <= 0)
+		added = AddRandomDevice();
+
+	try {
+		(void) CommitEntropy();
+	} catch (const Exception& ex) {
+		LOG_ERROR("Warmup: Crypto++ exception: \"%s\"", ex.what());
+		return;
+	}
+
+	if (added > 0)
+		MarkWarm(WARM_ENTROPY);
+}
+
+/* Maps a trigger to its STAT_RESEED_* counter and counts it. */
+static void CountReseed(ReseedTrigger trigger) {
+	switch (trigger) {
+	case RESEED_BYTES:
+		AddStat(STAT_RESEED_BYTES);
+		break;
+	case RESEED_TIME:
+		AddStat(STAT_RESEED_TIME);
+		break;
+	case RESEED_EXPLICIT:
+		AddStat(STAT_RESEED_EXPLICIT);
+		break;
+	default:
+		break;
+	}
+}
+
+#ifndef NDEBUG
+static const char* ReseedTriggerName(ReseedTrigger trigger) {
+	switch (trigger) {
+	case RESEED_START:
+		return "start";
+	case RESEED_BYTES:
+		return "byte budget";
+	case RESEED_TIME:
+		return "time budget";
+	case RESEED_EXPLICIT:
+		return "request";
+	default:
+		return "none";
+	}
+}
+#endif
+
+/* Checks the reseed policy. Called with s_harvestLock held. If no */
+/*   trigger has fired, wait is set to the milliseconds until one  */
+/*   can, or to a negative value if only a wake up can fire one.   */
+static ReseedTrigger NextReseed(double now, double& wait) {
+	if (s_reseed.m_requested)
+		return RESEED_EXPLICIT;
+
+	double due = -1.0;
+
+	if (s_reseed.m_interval > 0.0) {
+		due = s_reseed.m_last + s_reseed.m_interval;
+		if (now >= due)
+			return RESEED_TIME;
+	}
+
+	const unsigned long long budget = __atomic_load_n(&s_reseed.m_bytes,
+			__ATOMIC_RELAXED);
+	const unsigned long long output = __atomic_load_n(&s_reseed.m_output,
+			__ATOMIC_RELAXED);
+
+	if (budget != 0 && output >= budget) {
+		const double earliest = s_reseed.m_last
+				+ MIN_RESEED_INTERVAL_IN_MILLISECONDS;
+		if (now >= earliest)
+			return RESEED_BYTES;
+		if (due < 0.0 || earliest < due)
+			due = earliest;
+	}
+
+	wait = (due < 0.0) ? -1.0 : due - now;
+	return RESEED_NONE;
+}
+
+/* The harvester thread. It owns a sensor session for its whole  */
+/*   life, runs one collection round to seed the pool, and then  */
+/*   sleeps until the reseed policy fires. It idles while paused */
+/*   and exits when StopHarvester() sets m_stop.                 */
+static void* HarvesterThread(void*) {
+	LOG_DEBUG("Entered HarvesterThread");
+
+	SensorContext context;
+	const bool session = OpenSensorSession(context);
+
+	if (!session) {
+		LOG_WARN("Harvester: no sensor session, using random device");
+	}
+
+	pthread_mutex_lock(&s_harvestLock);
+
+	ReseedTrigger trigger = RESEED_START;
+
+	while (s_harvester.m_stop == 0) {
+
+		if (s_harvester.m_paused) {
+			LOG_DEBUG("Harvester: paused");
+			pthread_cond_wait(&s_harvestCond, &s_harvestLock);
+			continue;
+		}
+
+		if (trigger == RESEED_NONE) {
+			double wait = 0.0;
+			trigger = NextReseed(TimeInMilliSeconds(), wait);
+
+			if (trigger == RESEED_NONE) {
+				/* Sleep until a budget runs out, or until woken by */
+				/*   output, a request, a new policy, stop or pause */
+				if (wait < 0.0) {
+					pthread_cond_wait(&s_harvestCond, &s_harvestLock);
+				} else {
+					const timespec deadline = DeadlineFromNow(wait);
+					pthread_cond_timedwait(&s_harvestCond, &s_harvestLock,
+							&deadline);
+				}
+				continue;
+			}
+		}
+
+		/* Output from here on counts toward the next round */
+		s_reseed.m_requested = 0;
+		__atomic_store_n(&s_reseed.m_output, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&s_reseed.m_pending, 0, __ATOMIC_RELAXED);
+
+		/* A deadline waiter may have asked for a shorter window */
+		const double limit =
+				s_harvester.m_limit > 0.0 ?
+						s_harvester.m_limit : TIME_LIMIT_IN_MILLISECONDS;
+
+		/* Decided before the round's end is published, so waiters */
+		/*   see the real window                                   */
+		const bool profile = session && !context.m_replay
+				&& !s_harvester.m_waited && limit >= TIME_LIMIT_IN_MILLISECONDS
+				&& ProfileDue(GetSensorArray());
+
+		s_harvester.m_limit = 0.0;
+		s_harvester.m_waited = 0;
+		s_harvester.m_collecting = 1;
+		s_harvester.m_roundEnd = TimeInMilliSeconds(
+				profile ? PROFILE_WINDOW_IN_MILLISECONDS : limit);
+
+		pthread_mutex_unlock(&s_harvestLock);
+
+		CountReseed(trigger);
+
+		int rc1, rc2, rc3;
+		double credited = 0.0;
+
+		rc1 = AddProcessInfo();
+
+		/* A daemon, when one is in use and answers, already */
+		/*   sampled its sensors; otherwise collect locally. */
+		/*   A shortened round skips it, since the client's  */
+		/*   timeout is not planned against the deadline.    */
+		if (limit < TIME_LIMIT_IN_MILLISECONDS
+				|| AddDaemonSeed() <= 0) {
+			rc2 = session ? AddSensorData(context, limit, profile) : 0;
+			if (rc2 > 0)
+				credited = context.m_credited;
+
+			/* Fallback to a random device on failure, or when the  */
+			/*   sensors fell short of the entropy target. This is  */
+			/*   not catastrophic since the Crypto++ generator is OK */
+			if (rc1 <= 0 || rc2 <= 0
+					|| context.m_credited < ENTROPY_TARGET_BITS) {
+				rc3 = AddRandomDevice();
+				assert(rc3 > 0);
+				if (rc3 > 0)
+					credited += RANDOM_DEVICE_BITS;
+			}
+		} else {
+			credited = DAEMON_SEED_BITS;
+		}
+
+		/* The round's input reaches the pool here, in one step */
+		try {
+			(void) CommitEntropy();
+		} catch (const Exception& ex) {
+			LOG_ERROR("Harvester: Crypto++ exception: \"%s\"", ex.what());
+		}
+
+		SaveSeed(false);
+		MarkWarm(WARM_ENTROPY);
+
+		pthread_mutex_lock(&s_harvestLock);
+
+		s_reseed.m_last = TimeInMilliSeconds();
+		s_harvester.m_rounds++;
+
+		s_harvester.m_collecting = 0;
+		s_harvester.m_credited = credited;
+		pthread_cond_broadcast(&s_roundCond);
+
+		LOG_DEBUG("Harvester: completed round %lu, reseed on %s",
+				s_harvester.m_rounds, ReseedTriggerName(trigger));
+
+		trigger = RESEED_NONE;
+	}
+
+	pthread_mutex_unlock(&s_harvestLock);
+
+	CloseSensorSession(context);
+
+	LOG_DEBUG("Harvester: exiting after %lu rounds", s_harvester.m_rounds);
+
+	return NULL;
+}
+
+/* Returns 1 if the harvester is running, 0 on failure. */
+int StartHarvester() {
+	pthread_once(&s_forkOnce, InstallForkHandlers);
+
+	MutexLock lock(s_harvestLock);
+
+	if (s_harvester.m_running) {
+		LOG_DEBUG("Harvester: already running");
+		return 1;
+	}
+
+	s_harvester.m_stop = 0;
+	s_harvester.m_paused = 0;
+
+	return LaunchHarvesterLocked();
+}
+
+/* Creates the harvester thread. Called with s_harvestLock held.  */
+/*   A paused flag is left alone, so a harvester restarted after   */
+/*   a fork idles if the parent's was paused.                      */
+static int LaunchHarvesterLocked() {
+	s_harvester.m_stop = 0;
+
+	int rc = pthread_create(&s_harvester.m_thread, NULL, HarvesterThread,
+			NULL);
+	if (rc != 0) {
+		LOG_ERROR("Harvester: pthread_create failed, error %d", rc);
+		return 0;
+	}
+
+	s_harvester.m_running = 1;
+	LOG_INFO("Harvester: started");
+
+	return 1;
+}
+
+/* Returns 1 if the harvester was stopped, 0 if it was not running. */
+int StopHarvester() {
+	pthread_t thread;
+
+	{
+		MutexLock lock(s_harvestLock);
+
+		/* A forked child that stops first keeps it stopped */
+		s_harvester.m_restart = 0;
+
+		if (!s_harvester.m_running || s_harvester.m_stop) {
+			LOG_DEBUG("Harvester: not running");
+			return 0;
+		}
+
+		s_harvester.m_stop = 1;
+		thread = s_harvester.m_thread;
+		pthread_cond_broadcast(&s_harvestCond);
+		pthread_cond_broadcast(&s_roundCond);
+	}
+
+	/* Join outside the lock; the thread needs it to exit */
+	pthread_join(thread, NULL);
+
+	{
+		MutexLock lock(s_harvestLock);
+		s_harvester.m_running = 0;
+	}
+
+	EnsureInitialEntropy();
+	SaveSeed(true);
+
+	LOG_INFO("Harvester: stopped");
+
+	return 1;
+}
+
+/* Returns 1 if the harvester is running, 0 if it is not. A paused */
+/*   harvester finishes its current round and then idles.          */
+int PauseHarvester(bool pause) {
+	int running;
+
+	{
+		MutexLock lock(s_harvestLock);
+
+		s_harvester.m_paused = pause ? 1 : 0;
+		pthread_cond_broadcast(&s_harvestCond);
+		pthread_cond_broadcast(&s_roundCond);
+
+		running = s_harvester.m_running;
+	}
+
+	/* A paused app may be killed without another chance to save */
+	if (pause) {
+		EnsureInitialEntropy();
+		SaveSeed(true);
+	}
+
+	LOG_INFO("Harvester: %s", pause ? "paused" : "resumed");
+
+	return running;
+}
+
+/* The warm-up thread. Builds the pool and the sensor list so the */
+/*   first caller does not pay for them. The harvester's first     */
+/*   round is the initial entropy round; without a harvester, the  */
+/*   random device stands in for it.                               */
+static void* WarmupThread(void*) {
+	LOG_DEBUG("Entered WarmupThread");
+
+#ifndef NDEBUG
+	const double start = TimeInMilliSeconds();
+#endif
+
+	pthread_once(&s_poolOnce, CreatePool);
+	if (s_pool != NULL)
+		MarkWarm(WARM_GENERATOR);
+
+	pthread_once(&s_sensorOnce, BuildSensorArray);
+	MarkWarm(WARM_SENSORS);
+
+	DetectRandomSources();
+
+	bool harvesting;
+	{
+		MutexLock lock(s_harvestLock);
+		harvesting = s_harvester.m_running && !s_harvester.m_stop
+				&& !s_harvester.m_paused;
+	}
+
+	if (!harvesting)
+		EnsureInitialEntropy();
+
+#ifndef NDEBUG
+	LOG_DEBUG("Warmup: finished in %.2f ms", TimeInMilliSeconds() - start);
+#endif
+
+	return NULL;
+}
+
+/* Returns 1 if the warm-up thread was started. Starting it twice */
+/*   is harmless; the work is done once.                          */
+int StartWarmup() {
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	pthread_t thread;
+	int rc = pthread_create(&thread, &attr, WarmupThread, NULL);
+	pthread_attr_destroy(&attr);
+
+	if (rc != 0) {
+		LOG_ERROR("Warmup: pthread_create failed, error %d", rc);
+		return 0;
+	}
+
+	return 1;
+}
+
+/* Returns 1 once the pool and sensor list are built and the first */
+/*   entropy round has been mixed in.                              */
+int IsReady() {
+	MutexLock lock(s_warmLock);
+	return (s_warmState & WARM_ALL) == WARM_ALL ? 1 : 0;
+}
+
+/* Waits up to milliseconds for IsReady. Returns 1 if ready. */
+int AwaitReady(double milliseconds) {
+	const timespec deadline = DeadlineFromNow(std::max(milliseconds, 0.0));
+
+	MutexLock lock(s_warmLock);
+
+	while ((s_warmState & WARM_ALL) != WARM_ALL) {
+		int rc = pthread_cond_timedwait(&s_warmCond, &s_warmLock, &deadline);
+		if (rc == ETIMEDOUT)
+			break;
+	}
+
+	return (s_warmState & WARM_ALL) == WARM_ALL ? 1 : 0;
+}
+
+/* Returns 1 if a reseed was scheduled or done, 0 on failure. The */
+/*   harvester runs a full round if it can; otherwise the caller's */
+/*   thread mixes in process info and the random device.           */
+int RequestReseed() {
+	{
+		MutexLock lock(s_harvestLock);
+
+		if (s_harvester.m_running && !s_harvester.m_stop
+				&& !s_harvester.m_paused) {
+			s_reseed.m_requested = 1;
+			pthread_cond_broadcast(&s_harvestCond);
+
+			LOG_DEBUG("Reseed: requested a harvester round");
+			return 1;
+		}
+	}
+
+	AddStat(STAT_RESEED_EXPLICIT);
+
+	(void) AddProcessInfo();
+	const int added = AddRandomDevice();
+
+	try {
+		(void) CommitEntropy();
+	} catch (const Exception& ex) {
+		LOG_ERROR("Reseed: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	}
+
+	return added > 0 ? 1 : 0;
+}
+
+/* Asks the harvester for a round that ends by deadline, a       */
+/*   TimeInMilliSeconds() value, and waits for it. A round already */
+/*   in flight is used if it ends in time. Returns the bits the    */
+/*   round credited, or a negative value if the harvester cannot   */
+/*   deliver one before the deadline.                              */
+static double AwaitHarvesterRound(double deadline) {
+	MutexLock lock(s_harvestLock);
+
+	if (!s_harvester.m_running || s_harvester.m_stop || s_harvester.m_paused)
+		return -1.0;
+
+	const double now = TimeInMilliSeconds();
+	const unsigned long target = s_harvester.m_rounds + 1;
+
+	if (s_harvester.m_collecting) {
+		if (s_harvester.m_roundEnd + DEADLINE_ROUND_OVERHEAD_IN_MILLISECONDS
+				> deadline)
+			return -1.0;
+	} else {
+		const double limit = std::min(
+				deadline - now - DEADLINE_ROUND_OVERHEAD_IN_MILLISECONDS,
+				TIME_LIMIT_IN_MILLISECONDS);
+
+		if (limit < MIN_DEADLINE_ROUND_IN_MILLISECONDS)
+			return -1.0;
+
+		/* Several waiters share one round, planned for the tightest */
+		if (limit < TIME_LIMIT_IN_MILLISECONDS
+				&& (s_harvester.m_limit == 0.0 || limit < s_harvester.m_limit))
+			s_harvester.m_limit = limit;
+
+		s_harvester.m_waited = 1;
+		s_reseed.m_requested = 1;
+		pthread_cond_broadcast(&s_harvestCond);
+	}
+
+	const timespec wake = DeadlineFromNow(deadline - now);
+
+	while (s_harvester.m_rounds < target) {
+		if (!s_harvester.m_running || s_harvester.m_stop
+				|| s_harvester.m_paused)
+			return -1.0;
+
+		int rc = pthread_cond_timedwait(&s_roundCond, &s_harvestLock, &wake);
+		if (rc == ETIMEDOUT)
+			break;
+	}
+
+	return s_harvester.m_rounds >= target ? s_harvester.m_credited : -1.0;
+}
+
+double GenerateWithin(byte* output, size_t size, double milliseconds) {
+	const double deadline = TimeInMilliSeconds(milliseconds);
+	double credited = 0.0;
+
+	AddStat(STAT_DEADLINE_REQUESTS);
+
+	if (milliseconds > 0.0) {
+		credited = AwaitHarvesterRound(deadline);
+
+		if (credited >= 0.0) {
+			AddStat(STAT_DEADLINE_ROUNDS);
+		} else {
+			/* The random device costs microseconds, so even a */
+			/*   budget that is nearly spent can afford it     */
+			AddStat(STAT_DEADLINE_FALLBACKS);
+
+			(void) AddProcessInfo();
+			credited = AddRandomDevice() > 0 ? RANDOM_DEVICE_BITS : 0.0;
+			(void) CommitEntropy();
+		}
+
+		LOG_DEBUG("Deadline: credited %.1f bits with %.2f ms left", credited,
+				deadline - TimeInMilliSeconds());
+	}
+
+	GenerateBlock(output, size);
+
+	return credited;
+}
+
+/* Returns 1 if the policy was accepted, 0 if it is invalid. A     */
+/*   budget of 0 turns its trigger off; otherwise the time budget  */
+/*   must be at least MIN_RESEED_INTERVAL_IN_MILLISECONDS.         */
+int ConfigureReseed(unsigned long long bytes, double milliseconds) {
+	if (milliseconds < 0.0
+			|| (milliseconds > 0.0
+					&& milliseconds < MIN_RESEED_INTERVAL_IN_MILLISECONDS)) {
+		LOG_ERROR("Reseed: interval %.0f ms is not valid", milliseconds);
+		return 0;
+	}
+
+	MutexLock lock(s_harvestLock);
+
+	__atomic_store_n(&s_reseed.m_bytes, bytes, __ATOMIC_RELAXED);
+	s_reseed.m_interval = milliseconds;
+
+	/* Output already past a smaller budget wakes the harvester below */
+	__atomic_store_n(&s_reseed.m_pending, 0, __ATOMIC_RELAXED);
+
+	/* Let the harvester recompute its deadline */
+	pthread_cond_broadcast(&s_harvestCond);
+
+	LOG_INFO("Reseed: every %llu bytes, every %.0f ms", bytes, milliseconds);
+
+	return 1;
+}
+
+/* Create the looper and event queue used by AddSensorData. The  */
+/*   session lives as long as the harvester thread, so the queue  */
+/*   is not rebuilt on every round. Must be called on the thread  */
+/*   that will call AddSensorData.                                */
+bool OpenSensorSession(SensorContext& context) {
+	LOG_DEBUG("Entered OpenSensorSession");
+
+	ALooper* looper = ALooper_forThread();
+	if (looper == NULL)
+		looper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
+
+	if (looper == NULL) {
+		LOG_ERROR("SensorSession: looper is not valid");
+		return false;
+	}
+
+	LOG_DEBUG("SensorSession: created looper");
+
+	ASensorManager* sensorManager = ASensorManager_getInstance();
+
+	if (sensorManager == NULL) {
+		LOG_ERROR("SensorSession: sensor manager is not valid");
+		return false;
+	}
+
+	LOG_DEBUG("SensorSession: created sensor manager");
+
+	ASensorEventQueue* queue = ASensorManager_createEventQueue(sensorManager,
+			looper, LOOPER_ID_PRNG, SensorEvent,
+			reinterpret_cast<void*>(&context));
+
+	if (queue == NULL) {
+		LOG_ERROR("SensorSession: queue is not valid");
+		return false;
+	}
+
+	LOG_DEBUG("SensorSession: created event queue");
+
+	context.m_manager = sensorManager;
+	context.m_looper = looper;
+	context.m_queue = queue;
+
+	return true;
+}
+
+void CloseSensorSession(SensorContext& context) {
+	LOG_DEBUG("Entered CloseSensorSession");
+
+	if (context.m_manager && context.m_queue) {
+		ASensorManager_destroyEventQueue(context.m_manager, context.m_queue);
+	}
+
+	delete context.m_replay;
+	context.m_replay = NULL;
+
+	context.m_queue = NULL;
+	context.m_manager = NULL;
+	context.m_looper = NULL;
+}
+
+bool OpenReplaySession(SensorContext& context, const char* path,
+		double speed) {
+	LOG_DEBUG("Entered OpenReplaySession");
+
+	SensorReplay* replay = new (nothrow) SensorReplay;
+	if (replay == NULL) {
+		LOG_ERROR("SensorSession: failed to allocate replay");
+		return false;
+	}
+
+	if (!replay->Open(path, speed)) {
+		delete replay;
+		return false;
+	}
+
+	delete context.m_replay;
+	context.m_replay = replay;
+
+	return true;
+}
+
+int StartSensorRecording(const char* path) {
+#ifdef NDEBUG
+	/* A recording is the raw input behind the keys this library */
+	/*   hands out, so release builds never write one            */
+	(void) path;
+	LOG_ERROR("SensorRecorder: recording is only available in debug builds");
+	return 0;
+#else
+	if (path == NULL) {
+		LOG_ERROR("SensorRecorder: path is not valid");
+		return 0;
+	}
+
+	return s_recorder.Open(path) ? 1 : 0;
+#endif
+}
+
+int StopSensorRecording() {
+	if (!s_recorder.IsOpen())
+		return 0;
+
+	s_recorder.Close();
+	return 1;
+}
+
+/* One collection round from a recording. The events go through the */
+/*   same DrainSensorEvents as live ones, and the round ends the    */
+/*   same way: at the entropy target or the time limit,             */
+/*   measured on the replay clock.                                  */
+static int ReplaySensorData(SensorContext& context, double limit) {
+	SensorReplay& replay = *context.m_replay;
+
+	if (!replay.BeginRound()) {
+		LOG_WARN("SensorData: recording has no events");
+		return 0;
+	}
+
+	BeginSensorRound(context);
+	DrainSensorEvents(context);
+
+	while (context.m_signaled == 0 && context.m_credited < ENTROPY_TARGET_BITS) {
+
+		const double next = replay.NextArrival();
+
+		if (next < 0.0 || next > limit) {
+			replay.WaitUntil(limit);
+			LOG_DEBUG("SensorData: reached time limit of %.2f ms", limit);
+			break;
+		}
+
+		replay.WaitUntil(next);
+		DrainSensorEvents(context);
+	}
+
+	context.m_signaled = 1;
+	EndSensorRound(context);
+
+	LOG_DEBUG("SensorData: replayed %d total events, %d total bytes, "
+			"%.1f bits credited, in %.2f ms", context.m_total, context.m_bytes,
+			context.m_credited, replay.Elapsed());
+
+	return context.m_bytes;
+}
+
+int AddSensorData(SensorContext& context) {
+	const bool profile = !context.m_replay && ProfileDue(GetSensorArray());
+	return AddSensorData(context, TIME_LIMIT_IN_MILLISECONDS, profile);
+}
+
+int AddSensorData(SensorContext& context, double milliseconds, bool profile) {
+	LOG_DEBUG("Entered AddSensorData");
+
+	TraceSection section(STAGE_SENSOR_DATA);
+
+	if (context.m_replay)
+		return ReplaySensorData(context, milliseconds);
+
+	const SensorArray& sensorArray = GetSensorArray();
+	if (sensorArray.size() == 0) {
+		LOG_WARN("SensorData: no sensors available");
+		return 0;
+	}
+
+	ASensorEventQueue* queue = context.m_queue;
+	if (queue == NULL) {
+		LOG_ERROR("SensorData: queue is not valid");
+		return 0;
+	}
+
+	vector<const ASensor*> sensors;
+	SensorProfiles profiles;
+
+	ChooseSensors(sensorArray, milliseconds, profile, sensors, profiles);
+
+	const double limit = profile ? PROFILE_WINDOW_IN_MILLISECONDS : milliseconds;
+
+	if (sensors.empty()) {
+		LOG_DEBUG("SensorData: no sensor reports within %.2f ms", limit);
+		return 0;
+	}
+
+	BeginSensorRound(context);
+	context.m_stop = TimeInMilliSeconds(limit);
+
+	for (size_t i = 0; i < sensors.size(); i++) {
+
+		const ASensor* sensor = sensors[i];
+
+		// Take the larger of our preferred versus the sensor's rate
+		//   Even if a sensor advertises 'min_delay = 0', we still
+		//   try and extract data from it. Often we can get a reading.
+		int rate = ASensor_getMinDelay(sensor);
+		int pref = PREFERRED_INTERVAL_MICROSECONDS;
+		int adj = std::max<int>(rate, pref);
+
+		ASensorEventQueue_enableSensor(queue, sensor);
+		ASensorEventQueue_setEventRate(queue, sensor, adj);
+	}
+
+	LOG_DEBUG("SensorData: enabled %d of %d sensors%s", (int )sensors.size(),
+			(int )sensorArray.size(), profile ? " for profiling" : "");
+
+	///////////////////////////////////////////////////////////
+
+	const double time_start = TimeInMilliSeconds();
+	double time_now = time_start;
+
+	s_recorder.MarkRound();
+
+	/* Pick up anything left over from the previous round. It is */
+	/*   not profiled; its timing belongs to the last round.      */
+	DrainSensorEvents(context);
+
+	context.m_profiles = profile ? &profiles : NULL;
+
+	/* Block in the looper until the queue's fd is readable or the   */
+	/*   deadline passes. SensorEvent drains the queue as soon as    */
+	/*   events land, so there is no polling interval to oversleep.  */
+	while (context.m_signaled == 0
+			&& (profile || context.m_credited < ENTROPY_TARGET_BITS)) {
+
+		time_now = TimeInMilliSeconds();
+		const double remaining = context.m_stop - time_now;
+
+		if (remaining <= 0) {
+			LOG_DEBUG("SensorData: reached time limit of %.2f ms", limit);
+			break;
+		}
+
+		/* Round up so we do not spin on a sub-millisecond timeout */
+		const int timeout = (int) remaining + 1;
+		const int rc = ALooper_pollOnce(timeout, NULL, NULL, NULL);
+
+		if (rc == ALOOPER_POLL_TIMEOUT) {
+			LOG_DEBUG("SensorData: reached time limit of %.2f ms", limit);
+			break;
+		} else if (rc == ALOOPER_POLL_ERROR) {
+			LOG_ERROR("SensorData: looper poll failed");
+			break;
+		} else if (rc == LOOPER_ID_PRNG) {
+			/* Only seen if the queue was created without a callback */
+			DrainSensorEvents(context);
+		}
+	}
+
+	context.m_signaled = 1;
+	context.m_profiles = NULL;
+	time_now = TimeInMilliSeconds();
+
+	EndSensorRound(context);
+
+	///////////////////////////////////////////////////////////
+
+	for (size_t i = 0; i < sensors.size(); i++) {
+		ASensorEventQueue_disableSensor(queue, sensors[i]);
+	}
+
+	LOG_DEBUG("SensorData: disabled sensors");
+
+	const double elapsed = time_now - time_start;
+
+	if (profile)
+		StoreSensorProfiles(profiles, elapsed);
+
+	LOG_DEBUG("SensorData: added %d total events, %d total bytes, "
+			"%.1f bits credited, in %.2f ms", context.m_total, context.m_bytes,
+			context.m_credited, elapsed);
+
+	return context.m_bytes;
+}
+
+int AddRandomDevice() {
+	LOG_DEBUG("Entered AddRandomDevice");
+
+	TraceSection section(STAGE_RANDOM_DEVICE);
+
+	byte buff[RANDOM_DEVICE_BYTES + CPU_RANDOM_BYTES];
+
+	if (!ReadKernelRandom(buff, RANDOM_DEVICE_BYTES)) {
+		LOG_ERROR("RandomDevice: failed to read random device");
+		return 0;
+	}
+
+	const size_t size = RANDOM_DEVICE_BYTES
+			+ ReadCpuRandom(buff + RANDOM_DEVICE_BYTES, CPU_RANDOM_BYTES);
+
+	try {
+		IncorporateEntropy(buff, size);
+
+		LOG_DEBUG("RandomDevice: added %d total bytes", (int )size);
+	} catch (const Exception& ex) {
+		LOG_ERROR("RandomDevice: Crypto++ exception: \"%s\"", ex.what());
+		SecureWipeBuffer(buff, sizeof(buff));
+		return 0;
+	}
+
+	SecureWipeBuffer(buff, sizeof(buff));
+	return (int) size;
+}
+
+int AddDaemonSeed() {
+	byte buff[DAEMON_SEED_BYTES];
+
+	if (!DaemonSeed(buff, sizeof(buff)))
+		return 0;
+
+	try {
+		IncorporateEntropy(buff, sizeof(buff));
+
+		LOG_DEBUG("DaemonSeed: added %d total bytes", (int )sizeof(buff));
+	} catch (const Exception& ex) {
+		LOG_ERROR("DaemonSeed: Crypto++ exception: \"%s\"", ex.what());
+		SecureWipeBuffer(buff, sizeof(buff));
+		return 0;
+	}
+
+	SecureWipeBuffer(buff, sizeof(buff));
+	AddStat(STAT_DAEMON_SEEDS);
+
+	return (int) sizeof(buff);
+}
+
+int AddProcessInfo() {
+	LOG_DEBUG("Entered AddProcessInfo");
+
+	TraceSection section(STAGE_PROCESS_INFO);
+
+	/* Bytes added across all calls. The harvester, the warm-up   */
+	/*   thread and callers all get here, so it is only touched    */
+	/*   with __atomic.                                            */
+	static unsigned long accum = 0;
+
+	pid_t pid1, pid2;
+	timespec tspec[4];
+
+	pid1 = getpid();
+	pid2 = getppid();
+
+	/* The next GenerateBlock reseeds, as after any other fork */
+	const pid_t last = __atomic_exchange_n(&s_processId, pid1,
+			__ATOMIC_RELAXED);
+	if (last != 0 && last != pid1) {
+		LOG_INFO("ProcessInfo: process %d forked from %d", (int )pid1,
+				(int )last);
+		__atomic_store_n(&s_forked, 1, __ATOMIC_RELEASE);
+	}
+
+	/* We don't care about return values here */
+	(void) clock_gettime(CLOCK_REALTIME, &tspec[0]);
+	(void) clock_gettime(CLOCK_MONOTONIC, &tspec[1]);
+	(void) clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tspec[2]);
+	(void) clock_gettime(CLOCK_THREAD_CPUTIME_ID, &tspec[3]);
+
+	/* Send data into the prng in one shot. Its faster than 6 different calls. */
+	byte buff[128];
+	size_t idx = 0;
+
+	memcpy(&buff[idx], &pid1, sizeof(pid1));
+	idx += sizeof(pid1);
+
+	memcpy(&buff[idx], &pid2, sizeof(pid2));
+	idx += sizeof(pid2);
+
+	memcpy(&buff[idx], tspec, sizeof(tspec));
+	idx += sizeof(tspec);
+
+	/* Claim this call's count before copying it in */
+	const unsigned long total = __atomic_fetch_add(&accum,
+			(unsigned long) (idx + sizeof(accum)), __ATOMIC_RELAXED);
+
+	memcpy(&buff[idx], &total, sizeof(total));
+	idx += sizeof(total);
+
+	try {
+		IncorporateEntropy(buff, sizeof(buff));
+
+		LOG_DEBUG("ProcessInfo: added %d total bytes", (int)idx);
+	} catch (const Exception& ex) {
+		LOG_ERROR("ProcessInfo: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	}
+
+	return (int) idx;
+}
+
+#ifndef NDEBUG
+static const char* SensorTypeToName(int sensorType) {
+	switch (sensorType) {
+
+	/* <ndk root>/.../sensor.h */
+	case ASENSOR_TYPE_ACCELEROMETER: /* 1 */
+		return "Accelerometer";
+	case ASENSOR_TYPE_MAGNETIC_FIELD: /* 2 */
+		return "Magnetic field";
+	case ASENSOR_TYPE_GYROSCOPE: /* 4 */
+		return "Gyroscope";
+	case ASENSOR_TYPE_LIGHT: /* 5 */
+		return "Light";
+	case ASENSOR_TYPE_PROXIMITY: /* 8 */
+		return "Proximity";
+
+		/* http://developer.android.com/reference/android/hardware/Sensor.html */
+	case 0:
+		return "type 0";
+	case 3:
+		return "Orientation";
+	case 6:
+		return "Pressure";
+	case 7:
+		return "Temperature";
+	case 9:
+		return "Gravity";
+	case 10:
+		return "Linear acceleration";
+	case 11:
+		return "Rotation vector";
+	case 12:
+		return "Relative humidity";
+	case 13:
+		return "Ambient temperature";
+	case 14:
+		return "Uncalibrated magnetic field";
+	case 15:
+		return "Rotation vector";
+	case 16:
+		return "Uncalibrated gyroscope";
+	case 17:
+		return "Significant motion";
+	case 18:
+		return "type 18";
+	case 19:
+		return "Step counter";
+	case 20:
+		return "Geo-magnetic rotation vector.";
+	case 21:
+		return "Heart rate";
+	default:
+		;
+	}
+	return "Unknown";
+}
+#endif
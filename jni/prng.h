@@ -0,0 +1,250 @@
+/* Internal interface between the JNI layer (libprng.cpp) and the */
+/* generator core (prng.cpp). Nothing here is exported from the    */
+/* shared object. The core has no JNI dependency, so it also       */
+/* builds on a host against the stand-in headers in host/.         */
+
+#ifndef _Included_com_cryptopp_prng_prng
+#define _Included_com_cryptopp_prng_prng
+
+// The build decides: Android.mk passes -DNDEBUG unless NDK_DEBUG=1,
+// and a release build compiles LOG_DEBUG out below. The host build
+// leaves NDEBUG unset, so it keeps the debug logging.
+#if defined(NDEBUG)
+# undef DEBUG
+# undef NDK_DEBUG
+#endif
+
+#include <android/sensor.h>
+#include <android/looper.h>
+#include <android/log.h>
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <vector>
+
+#define LOG_TAG "PRNG"
+#define LOG_DEBUG(...) ((void)__android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__))
+#define LOG_INFO(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
+#define LOG_WARN(...) ((void)__android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__))
+#define LOG_ERROR(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+#if defined(NDEBUG)
+# undef LOG_VERBOSE
+# define LOG_VERBOSE(...)
+# undef LOG_DEBUG
+# define LOG_DEBUG(...)
+#endif
+
+#define COUNTOF(x) (sizeof(x) / sizeof(x[0]))
+
+#include <cryptopp/cryptlib.h>
+
+#include "instrument.h"
+
+/* A collection round stops once the entropy credited by the     */
+/* online estimator (entropy.h) reaches the target, or at the     */
+/* time limit. The event count below no longer ends a round; it  */
+/* sizes the drain buffers and is the event count sensor          */
+/* selection plans for, so one round sees a few readings from     */
+/* each enabled sensor.                                           */
+static const int SENSOR_SAMPLE_COUNT = 12;
+
+/* Sensor events are over 100 bytes, but most of an event is      */
+/* constant (version, sensor id, type, reserved fields, padding).  */
+/* Only the low bits of the timestamp and the low mantissa bits of */
+/* each value channel are staged and hashed.                       */
+static const int STAGED_STAMP_BYTES = 4;
+static const int STAGED_VALUE_BYTES = 2;
+
+/* Widest layout in the sensor layout table (uncalibrated sensors). */
+static const int MAX_SENSOR_CHANNELS = 6;
+
+class SensorReplay;
+struct SensorProfile;
+
+struct SensorContext {
+
+	SensorContext() :
+			m_looper(NULL), m_manager(NULL), m_queue(NULL), m_replay(NULL), m_profiles(
+					NULL), m_signaled(0), m_stop(0.0f), m_total(0), m_bytes(0), m_credited(
+					0.0) {
+	}
+
+	~SensorContext() {
+		m_looper = NULL;
+		m_manager = NULL;
+		m_queue = NULL;
+		m_replay = NULL;
+		m_profiles = NULL;
+		m_signaled = 1;
+		m_stop = 0.0f;
+	}
+
+	// Looper
+	ALooper* m_looper;
+
+	// Sensor Manager
+	ASensorManager* m_manager;
+
+	// And the queue
+	ASensorEventQueue* m_queue;
+
+	// Set by OpenReplaySession; events come from a recording instead
+	SensorReplay* m_replay;
+
+	// Set during a profiling round; drained events are also profiled
+	std::vector<SensorProfile>* m_profiles;
+
+	// If not signaled, then processing should continue.
+	// If signaled, then processing should stop.
+	int m_signaled;
+
+	/* Time when the callback should stop */
+	double m_stop;
+
+	/* Events drained in the current round */
+	int m_total;
+
+	/* Staged bytes hashed in the current round */
+	int m_bytes;
+
+	/* Entropy credited to the current round, in bits */
+	double m_credited;
+
+	/* Scratch space for ASensorEventQueue_getEvents */
+	ASensorEvent m_events[SENSOR_SAMPLE_COUNT * 2];
+
+	/* Structure of arrays: all timestamps, then all value channels */
+	byte m_staging[SENSOR_SAMPLE_COUNT * 2
+			* (STAGED_STAMP_BYTES + MAX_SENSOR_CHANNELS * STAGED_VALUE_BYTES)];
+};
+
+class MutexLock
+{
+public:
+	explicit MutexLock(pthread_mutex_t& mutex)
+	: m_mutex(mutex)
+	{
+		pthread_mutex_lock(&m_mutex);
+	}
+
+	~MutexLock()
+	{
+		pthread_mutex_unlock(&m_mutex);
+	}
+
+private:
+	// Not copyable
+	MutexLock(const MutexLock&);
+	MutexLock& operator=(const MutexLock&);
+
+	pthread_mutex_t& m_mutex;
+};
+
+/* Central pool and thread generators. These throw Crypto++ exceptions. */
+/*   IncorporateEntropy only stages input; it reaches the pool when   */
+/*   the next reseed commits it, or at once with CommitEntropy.        */
+/*   ScheduleCommit asks the next GenerateBlock to commit.             */
+void IncorporateEntropy(const byte* input, size_t length);
+size_t CommitEntropy();
+void ScheduleCommit();
+void GenerateBlock(byte* output, size_t size);
+
+void FillInts(int32_t* output, size_t count, uint32_t bound);
+void FillLongs(int64_t* output, size_t count, int64_t lo, int64_t hi);
+void FillDoubles(double* output, size_t count);
+void FillFloats(float* output, size_t count);
+
+/* 64x64 to 128-bit multiply. Returns the high half, low half in lo. */
+static inline uint64_t MultiplyHigh64(uint64_t a, uint64_t b, uint64_t& lo) {
+#if defined(__SIZEOF_INT128__)
+	const unsigned __int128 m = (unsigned __int128) a * b;
+	lo = (uint64_t) m;
+	return (uint64_t) (m >> 64);
+#else
+	/* 32-bit ARM, x86 and MIPS have no 128-bit type */
+	const uint64_t a0 = a & 0xffffffff, a1 = a >> 32;
+	const uint64_t b0 = b & 0xffffffff, b1 = b >> 32;
+
+	const uint64_t p00 = a0 * b0, p01 = a0 * b1;
+	const uint64_t p10 = a1 * b0, p11 = a1 * b1;
+
+	const uint64_t mid = (p00 >> 32) + (p01 & 0xffffffff)
+			+ (p10 & 0xffffffff);
+
+	lo = a * b;
+	return p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+#endif
+}
+
+/* Settings. These return 0 on invalid input. */
+int SelectBackend(int type);
+int GetBackend();
+int ConfigureRing(size_t size, size_t lowWater, size_t maxRequest);
+int ConfigureReseed(unsigned long long bytes, double milliseconds);
+int ConfigureParallel(size_t threshold, size_t workers);
+
+/* Asks for fresh entropy now, outside the reseed policy. */
+int RequestReseed();
+
+/* Mixes in as much fresh entropy as fits in milliseconds, then    */
+/*   fills output. The harvester runs a shortened sensor round when */
+/*   the budget allows; otherwise the calling thread mixes in the  */
+/*   random device, and a budget of 0 generates from the pool      */
+/*   alone. Returns the bits of fresh entropy credited. Throws     */
+/*   Crypto++ exceptions, like GenerateBlock.                      */
+double GenerateWithin(byte* output, size_t size, double milliseconds);
+
+struct ChannelEstimate;
+
+/* Copies up to count per-channel entropy estimates (see entropy.h). */
+/*   Returns the number of channels, which may be more than count.   */
+size_t ReadEntropyEstimates(ChannelEstimate* estimates, size_t count);
+
+/* Entropy sources. Each returns the number of bytes mixed in. The  */
+/*   sensor round samples for at most milliseconds, 250 by default.  */
+/*   A profiling round runs for the whole profiling window instead;  */
+/*   the default round profiles when the ranking is due for it.      */
+int AddSensorData(SensorContext& context);
+int AddSensorData(SensorContext& context, double milliseconds, bool profile);
+int AddRandomDevice();
+int AddDaemonSeed();
+int AddProcessInfo();
+
+bool OpenSensorSession(SensorContext& context);
+void CloseSensorSession(SensorContext& context);
+
+/* Replays a recording made with StartSensorRecording through the */
+/*   collector instead of the device's sensors. speed scales the  */
+/*   recorded arrival times; 0 replays without waiting. Close it  */
+/*   with CloseSensorSession.                                     */
+bool OpenReplaySession(SensorContext& context, const char* path,
+		double speed);
+
+/* Records the events every collector drains to path, until stopped. */
+/*   Recorded events are mixed in but not credited. Debug builds    */
+/*   only; a release build returns 0. Return 1 on success, 0 on     */
+/*   failure.                                                       */
+int StartSensorRecording(const char* path);
+int StopSensorRecording();
+
+/* Caches sensor profiles in path across processes. Returns 1. */
+int SetSensorProfilePath(const char* path);
+
+/* Mixes in and replaces the seed file at path, and keeps it fresh. */
+/*   Returns 1 if a saved seed was mixed in.                       */
+int SetSeedFilePath(const char* path);
+
+/* Background harvester */
+int StartHarvester();
+int StopHarvester();
+int PauseHarvester(bool pause);
+
+/* Background warm-up, started at load. AwaitReady waits up to */
+/*   milliseconds; both return 1 once the library is ready.    */
+int StartWarmup();
+int IsReady();
+int AwaitReady(double milliseconds);
+
+#endif
@@ -0,0 +1,240 @@
+#include "prng.h"
+#include "prngapi.h"
+#include "daemon.h"
+
+#include <new>
+
+#include <cryptopp/cryptlib.h>
+using CryptoPP::Exception;
+
+/* No exception may reach a C caller. Crypto++ throws Exception, and */
+/*   SecByteBlock allocations can throw bad_alloc.                   */
+
+/* PRNG_STAT_* must track StatIndex (instrument.h) */
+typedef char StatCountMatches[
+		(int) PRNG_STAT_COUNT == (int) STAT_COUNT ? 1 : -1];
+
+/* The pool is built once per process; the harvester starts again */
+/*   after prng_shutdown.                                         */
+static bool s_warmupStarted = false;
+static pthread_mutex_t s_initLock = PTHREAD_MUTEX_INITIALIZER;
+
+int prng_init(void) {
+	LOG_DEBUG("Entered prng_init");
+
+	MutexLock lock(s_initLock);
+
+	/* Start harvesting right away so the pool has sensor data */
+	/*   mixed in by the time the app asks for bytes.          */
+	const int rc = StartHarvester();
+	if (rc <= 0) {
+		LOG_WARN("Init: harvester did not start");
+	}
+
+	/* Build the pool and sensor list off the caller's thread, so */
+	/*   startup overlaps with them (see prng_await_ready)         */
+	if (!s_warmupStarted) {
+		s_warmupStarted = StartWarmup() > 0;
+		if (!s_warmupStarted) {
+			LOG_WARN("Init: warm-up did not start");
+		}
+	}
+
+	return rc > 0 ? 1 : 0;
+}
+
+void prng_shutdown(void) {
+	LOG_DEBUG("Entered prng_shutdown");
+
+	(void) StopDaemon();
+	(void) StopHarvester();
+}
+
+int prng_await_ready(int milliseconds) {
+	if (milliseconds < 0) {
+		LOG_ERROR("AwaitReady: timeout is not valid");
+		return 0;
+	}
+
+	return AwaitReady((double) milliseconds);
+}
+
+size_t prng_reseed(const void* seed, size_t size) {
+	if (seed == NULL) {
+		LOG_ERROR("Reseed: array pointer is not valid");
+		return 0;
+	} else if (size == 0) {
+		LOG_ERROR("Reseed: array size is not valid");
+		return 0;
+	}
+
+	try {
+		/* Staged without waiting on the pool; the caller's next */
+		/*   output is generated after it is committed           */
+		IncorporateEntropy(reinterpret_cast<const byte*>(seed), size);
+		ScheduleCommit();
+
+		LOG_DEBUG("Reseed: seeded with %d bytes", (int )size);
+	} catch (const Exception& ex) {
+		LOG_ERROR("Reseed: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	} catch (const std::bad_alloc&) {
+		LOG_ERROR("Reseed: out of memory");
+		return 0;
+	}
+
+	return size;
+}
+
+/* Entropy is mixed in by the harvester thread, so this never     */
+/*   waits on the sensors and makes no JNI calls. It can still      */
+/*   block: a reseed takes the pool mutex in CommitEntropy, and a   */
+/*   request at or above the parallel threshold waits on the worker */
+/*   pool. libprng.cpp therefore pins the output array only for     */
+/*   requests of at most MAX_CRITICAL_BYTES (see cleanup.h).        */
+size_t prng_get_bytes(void* output, size_t size) {
+	if (output == NULL) {
+		LOG_ERROR("GetBytes: array pointer is not valid");
+		return 0;
+	} else if (size == 0) {
+		LOG_ERROR("GetBytes: array size is not valid");
+		return 0;
+	}
+
+	try {
+		GenerateBlock(reinterpret_cast<byte*>(output), size);
+
+		LOG_DEBUG("GetBytes: generated %lu bytes", (unsigned long )size);
+	} catch (const Exception& ex) {
+		LOG_ERROR("GetBytes: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	} catch (const std::bad_alloc&) {
+		LOG_ERROR("GetBytes: out of memory");
+		return 0;
+	}
+
+	return size;
+}
+
+/* May wait on the harvester for up to budget_us, so callers must */
+/*   not hold a critical array section across it.                 */
+size_t prng_get_bytes_within(void* output, size_t size, uint64_t budget_us,
+		double* credited_bits) {
+	if (output == NULL) {
+		LOG_ERROR("GetBytesWithin: array pointer is not valid");
+		return 0;
+	} else if (size == 0) {
+		LOG_ERROR("GetBytesWithin: array size is not valid");
+		return 0;
+	}
+
+	try {
+		const double credited = GenerateWithin(reinterpret_cast<byte*>(output),
+				size, (double) budget_us / 1000.0);
+
+		if (credited_bits)
+			*credited_bits = credited;
+
+		LOG_DEBUG("GetBytesWithin: generated %lu bytes, %.1f bits credited",
+				(unsigned long )size, credited);
+	} catch (const Exception& ex) {
+		LOG_ERROR("GetBytesWithin: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	} catch (const std::bad_alloc&) {
+		LOG_ERROR("GetBytesWithin: out of memory");
+		return 0;
+	}
+
+	return size;
+}
+
+size_t prng_fill_ints(int32_t* output, size_t count, uint32_t bound) {
+	if (output == NULL || count == 0 || bound == 0) {
+		LOG_ERROR("NextInts: array or bound is not valid");
+		return 0;
+	}
+
+	try {
+		FillInts(output, count, bound);
+	} catch (const Exception& ex) {
+		LOG_ERROR("NextInts: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	} catch (const std::bad_alloc&) {
+		LOG_ERROR("NextInts: out of memory");
+		return 0;
+	}
+
+	return count;
+}
+
+size_t prng_fill_longs(int64_t* output, size_t count, int64_t lo, int64_t hi) {
+	if (output == NULL || count == 0 || lo >= hi) {
+		LOG_ERROR("NextLongs: array or range is not valid");
+		return 0;
+	}
+
+	try {
+		FillLongs(output, count, lo, hi);
+	} catch (const Exception& ex) {
+		LOG_ERROR("NextLongs: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	} catch (const std::bad_alloc&) {
+		LOG_ERROR("NextLongs: out of memory");
+		return 0;
+	}
+
+	return count;
+}
+
+size_t prng_fill_doubles(double* output, size_t count) {
+	if (output == NULL || count == 0) {
+		LOG_ERROR("NextDoubles: array is not valid");
+		return 0;
+	}
+
+	try {
+		FillDoubles(output, count);
+	} catch (const Exception& ex) {
+		LOG_ERROR("NextDoubles: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	} catch (const std::bad_alloc&) {
+		LOG_ERROR("NextDoubles: out of memory");
+		return 0;
+	}
+
+	return count;
+}
+
+size_t prng_fill_floats(float* output, size_t count) {
+	if (output == NULL || count == 0) {
+		LOG_ERROR("NextFloats: array is not valid");
+		return 0;
+	}
+
+	try {
+		FillFloats(output, count);
+	} catch (const Exception& ex) {
+		LOG_ERROR("NextFloats: Crypto++ exception: \"%s\"", ex.what());
+		return 0;
+	} catch (const std::bad_alloc&) {
+		LOG_ERROR("NextFloats: out of memory");
+		return 0;
+	}
+
+	return count;
+}
+
+size_t prng_get_stats(uint64_t* values, size_t count) {
+	if (values == NULL)
+		return 0;
+
+	unsigned long long counters[STAT_COUNT];
+	const size_t n = ReadStats(counters, COUNTOF(counters));
+
+	/* Copy as many as the caller has room for */
+	const size_t copied = n < count ? n : count;
+	for (size_t i = 0; i < copied; i++)
+		values[i] = (uint64_t) counters[i];
+
+	return copied;
+}
@@ -0,0 +1,104 @@
+/* Public C API of libprng.so, for native code that wants random     */
+/* bytes without a JNIEnv. The PRNG class's natives are wrappers     */
+/* over these same functions, so both see one pool, one harvester    */
+/* and one set of counters. Every function is thread safe, and none  */
+/* pins memory or takes a Java lock. Nothing else in the library is  */
+/* exported.                                                         */
+/*                                                                   */
+/* When Java loads the library, JNI_OnLoad calls prng_init itself.   */
+/* Native code that dlopens it calls prng_init before anything else. */
+
+#ifndef _Included_com_cryptopp_prng_prngapi
+#define _Included_com_cryptopp_prng_prngapi
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PRNG_API __attribute__((visibility("default")))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Counters filled by prng_get_stats. Same order and meaning as the */
+/*   STAT_* constants in PRNG.java, and only ever appended to.      */
+enum {
+	PRNG_STAT_RING_HITS = 0,
+	PRNG_STAT_RING_MISSES,
+	PRNG_STAT_RING_BYPASSES,
+	PRNG_STAT_RING_REFILLS,
+	PRNG_STAT_RING_REFILL_BYTES,
+	PRNG_STAT_SENSOR_ROUNDS,
+	PRNG_STAT_SENSOR_TARGET_MET,
+	PRNG_STAT_SENSOR_CREDITED_BITS,
+	PRNG_STAT_HEALTH_RCT_FAILURES,
+	PRNG_STAT_HEALTH_APT_FAILURES,
+	PRNG_STAT_RESEED_BYTES,
+	PRNG_STAT_RESEED_TIME,
+	PRNG_STAT_RESEED_FORK,
+	PRNG_STAT_RESEED_EXPLICIT,
+	PRNG_STAT_SEED_LOADS,
+	PRNG_STAT_SEED_SAVES,
+	PRNG_STAT_SEED_FAILURES,
+	PRNG_STAT_ENTROPY_COMMITS,
+	PRNG_STAT_ENTROPY_COMMIT_BYTES,
+	PRNG_STAT_ACCUMULATOR_OVERFLOWS,
+	PRNG_STAT_PARALLEL_REQUESTS,
+	PRNG_STAT_PARALLEL_FALLBACKS,
+	PRNG_STAT_STREAM_BYTES,
+	PRNG_STAT_DAEMON_REQUESTS,
+	PRNG_STAT_DAEMON_SEEDS,
+	PRNG_STAT_DAEMON_FALLBACKS,
+	PRNG_STAT_DEADLINE_REQUESTS,
+	PRNG_STAT_DEADLINE_ROUNDS,
+	PRNG_STAT_DEADLINE_FALLBACKS,
+	PRNG_STAT_COUNT
+};
+
+/* Starts the harvester, and on the first call builds the pool in */
+/*   the background. Returns 1 if the harvester is running. Safe  */
+/*   to call more than once.                                      */
+PRNG_API int prng_init(void);
+
+/* Stops the daemon, if this process serves one, and the harvester. */
+/*   Output still works afterwards, without fresh sensor entropy.   */
+PRNG_API void prng_shutdown(void);
+
+/* Waits up to milliseconds for the pool and the first entropy round. */
+/*   Returns 1 if ready. 0 milliseconds only checks.                  */
+PRNG_API int prng_await_ready(int milliseconds);
+
+/* Mixes size bytes of seed into the pool before the next output. */
+/*   Returns the bytes consumed, or 0 on failure.                 */
+PRNG_API size_t prng_reseed(const void* seed, size_t size);
+
+/* Fills output with size random bytes. Returns size, or 0 on failure. */
+PRNG_API size_t prng_get_bytes(void* output, size_t size);
+
+/* Like prng_get_bytes, but first mixes in as much fresh entropy as */
+/*   fits in budget_us microseconds: a shortened sensor round when  */
+/*   the harvester can finish one in time, otherwise the kernel's   */
+/*   generator. A budget of 0 generates from the pool alone. Sets   */
+/*   *credited_bits, if not NULL, to the fresh entropy credited.    */
+/*   Returns size, or 0 on failure.                                 */
+PRNG_API size_t prng_get_bytes_within(void* output, size_t size,
+		uint64_t budget_us, double* credited_bits);
+
+/* Typed fills. Each returns count, or 0 on failure. Ints are uniform */
+/*   in [0, bound) with bound > 0, longs in [lo, hi) with lo < hi,    */
+/*   and doubles and floats in [0, 1).                                */
+PRNG_API size_t prng_fill_ints(int32_t* output, size_t count, uint32_t bound);
+PRNG_API size_t prng_fill_longs(int64_t* output, size_t count, int64_t lo,
+		int64_t hi);
+PRNG_API size_t prng_fill_doubles(double* output, size_t count);
+PRNG_API size_t prng_fill_floats(float* output, size_t count);
+
+/* Copies up to count counters, indexed by PRNG_STAT_*, summed over */
+/*   every thread. Returns the number copied.                       */
+PRNG_API size_t prng_get_stats(uint64_t* values, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+#include "prng.h"
+#include "seedfile.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+using std::string;
+
+/* Loops over short reads and EINTR. Returns false unless all */
+/*   size bytes were read.                                     */
+static bool ReadFully(int fd, uint8_t* buffer, size_t size) {
+	while (size > 0) {
+		const ssize_t n = read(fd, buffer, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		buffer += n;
+		size -= (size_t) n;
+	}
+
+	return true;
+}
+
+static bool WriteFully(int fd, const uint8_t* buffer, size_t size) {
+	while (size > 0) {
+		const ssize_t n = write(fd, buffer, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		buffer += n;
+		size -= (size_t) n;
+	}
+
+	return true;
+}
+
+/* A name for path private to this process, for a claimed seed or */
+/*   a seed being written.                                          */
+static string ProcessPath(const char* path, const char* suffix) {
+	char pid[16];
+	snprintf(pid, sizeof(pid), ".%d", (int) getpid());
+	return string(path) + suffix + pid;
+}
+
+bool LoadSeedFile(const char* path, uint8_t* seed, size_t size) {
+	/* Claim the seed first. rename is atomic, so when processes */
+	/*   start together only one of them gets it                 */
+	const string claimed = ProcessPath(path, ".claim");
+	if (rename(path, claimed.c_str()) != 0) {
+		LOG_DEBUG("SeedFile: no seed at %s", path);
+		return false;
+	}
+
+	const int fd = open(claimed.c_str(), O_RDONLY | O_CLOEXEC);
+	unlink(claimed.c_str());
+
+	if (fd < 0) {
+		LOG_WARN("SeedFile: failed to open %s, error %d", claimed.c_str(),
+				errno);
+		return false;
+	}
+
+	SeedFileHeader header;
+	bool ok = ReadFully(fd, (uint8_t*) &header, sizeof(header))
+			&& header.m_magic == SEED_FILE_MAGIC
+			&& header.m_version == SEED_FILE_VERSION
+			&& header.m_length == size && ReadFully(fd, seed, size);
+
+	close(fd);
+
+	if (!ok) {
+		LOG_WARN("SeedFile: ignoring malformed seed %s", path);
+		memset(seed, 0x00, size);
+	}
+
+	return ok;
+}
+
+bool SaveSeedFile(const char* path, const uint8_t* seed, size_t size) {
+	/* Per process, since several may save at once */
+	const string temp = ProcessPath(path, ".tmp");
+
+	const int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+			0600);
+	if (fd < 0) {
+		LOG_WARN("SeedFile: failed to open %s, error %d", temp.c_str(),
+				errno);
+		return false;
+	}
+
+	SeedFileHeader header;
+	memset(&header, 0x00, sizeof(header));
+	header.m_magic = SEED_FILE_MAGIC;
+	header.m_version = SEED_FILE_VERSION;
+	header.m_length = (uint16_t) size;
+
+	/* Sync before the rename, or a crash can leave an empty file */
+	/*   under the real name                                      */
+	bool written = WriteFully(fd, (const uint8_t*) &header, sizeof(header))
+			&& WriteFully(fd, seed, size) && fsync(fd) == 0;
+
+	if (close(fd) != 0)
+		written = false;
+
+	if (!written || rename(temp.c_str(), path) != 0) {
+		LOG_WARN("SeedFile: failed to save %s, error %d", path, errno);
+		unlink(temp.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void RemoveSeedFile(const char* path) {
+	if (unlink(path) != 0 && errno != ENOENT) {
+		LOG_ERROR("SeedFile: failed to remove %s, error %d", path, errno);
+	}
+}
@@ -0,0 +1,39 @@
+/* The seed file. A seed drawn from the central pool is kept in an */
+/* app-private file, so a new process can mix it in before its     */
+/* first sensor round. A process claims the file before reading   */
+/* it and the seed is replaced at once, so a seed is never used    */
+/* twice, even by processes that start together.                   */
+
+#ifndef _Included_com_cryptopp_prng_seedfile
+#define _Included_com_cryptopp_prng_seedfile
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* File layout: SeedFileHeader, then m_length seed bytes. */
+
+static const uint32_t SEED_FILE_MAGIC = 0x44455350; /* "PSED" */
+static const uint16_t SEED_FILE_VERSION = 1;
+
+struct SeedFileHeader {
+	uint32_t m_magic;
+	uint16_t m_version;
+	uint16_t m_length;
+};
+
+/* Claims the file by renaming it to a name private to this      */
+/*   process, then reads exactly size seed bytes into seed and     */
+/*   removes it. Returns false if the file is missing, was claimed */
+/*   by another process, is malformed or holds a different size.   */
+bool LoadSeedFile(const char* path, uint8_t* seed, size_t size);
+
+/* Writes seed to a temporary file, syncs it and renames it over */
+/*   path, so readers see the old seed or the new one. The file  */
+/*   is only readable by the app. Returns false on failure.      */
+bool SaveSeedFile(const char* path, const uint8_t* seed, size_t size);
+
+/* Removes path, so a seed that could not be replaced is not read */
+/*   again.                                                        */
+void RemoveSeedFile(const char* path);
+
+#endif
@@ -0,0 +1,366 @@
+#include "prng.h"
+#include "sensorlog.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+/* ASensorEvent::data has room for 16 words */
+static const uint8_t MAX_LOG_CHANNELS = 16;
+
+/* Trailing zero words are not written. The replayed event has */
+/*   them zeroed, so nothing is lost.                          */
+static uint8_t UsedChannels(const ASensorEvent& event) {
+	uint8_t used = 0;
+	for (uint8_t i = 0; i < MAX_LOG_CHANNELS; i++) {
+		uint32_t word;
+		memcpy(&word, &event.data[i], sizeof(word));
+		if (word != 0)
+			used = i + 1;
+	}
+	return used;
+}
+
+/***************************** Recorder *****************************/
+
+SensorRecorder::SensorRecorder()
+: m_file(NULL), m_last(0), m_records(0)
+{
+	pthread_mutex_init(&m_lock, NULL);
+}
+
+SensorRecorder::~SensorRecorder() {
+	Close();
+	pthread_mutex_destroy(&m_lock);
+}
+
+bool SensorRecorder::Open(const char* path) {
+	MutexLock lock(m_lock);
+
+	if (m_file) {
+		fclose(m_file);
+		m_file = NULL;
+	}
+
+	m_file = fopen(path, "wb");
+	if (m_file == NULL) {
+		LOG_ERROR("SensorRecorder: failed to open %s, error %d", path, errno);
+		return false;
+	}
+
+	SensorLogHeader header;
+	memset(&header, 0x00, sizeof(header));
+	header.m_magic = SENSOR_LOG_MAGIC;
+	header.m_version = SENSOR_LOG_VERSION;
+	header.m_headerSize = sizeof(header);
+	header.m_eventSize = sizeof(ASensorEvent);
+	header.m_created = (uint64_t) time(NULL);
+
+	if (fwrite(&header, sizeof(header), 1, m_file) != 1) {
+		LOG_ERROR("SensorRecorder: failed to write header to %s", path);
+		fclose(m_file);
+		m_file = NULL;
+		return false;
+	}
+
+	m_last = MonotonicNanoSeconds();
+	m_records = 0;
+
+	LOG_INFO("SensorRecorder: recording to %s", path);
+	return true;
+}
+
+void SensorRecorder::Close() {
+	MutexLock lock(m_lock);
+
+	if (m_file) {
+		fclose(m_file);
+		m_file = NULL;
+
+		LOG_INFO("SensorRecorder: wrote %lu records", m_records);
+	}
+}
+
+bool SensorRecorder::IsOpen() {
+	MutexLock lock(m_lock);
+	return m_file != NULL;
+}
+
+unsigned long SensorRecorder::Records() {
+	MutexLock lock(m_lock);
+	return m_records;
+}
+
+/* Caller holds m_lock */
+void SensorRecorder::WriteRecord(const SensorLogRecord& record,
+		const void* data) {
+	const size_t words = record.m_channels * sizeof(uint32_t);
+
+	if (fwrite(&record, sizeof(record), 1, m_file) != 1
+			|| (words && fwrite(data, words, 1, m_file) != 1)) {
+		LOG_ERROR("SensorRecorder: write failed, closing recording");
+		fclose(m_file);
+		m_file = NULL;
+		return;
+	}
+
+	m_records++;
+}
+
+static uint32_t DeltaMicroSeconds(int64_t& last) {
+	const int64_t now = MonotonicNanoSeconds();
+	const int64_t delta = (now - last) / 1000;
+	last = now;
+
+	return (uint32_t) std::min<int64_t>(std::max<int64_t>(delta, 0),
+			UINT32_MAX);
+}
+
+void SensorRecorder::MarkRound() {
+	MutexLock lock(m_lock);
+	if (m_file == NULL)
+		return;
+
+	SensorLogRecord record;
+	memset(&record, 0x00, sizeof(record));
+	record.m_delta = DeltaMicroSeconds(m_last);
+	record.m_type = SENSOR_LOG_ROUND;
+
+	WriteRecord(record, NULL);
+}
+
+void SensorRecorder::Record(const ASensorEvent* events, size_t count) {
+	MutexLock lock(m_lock);
+	if (m_file == NULL)
+		return;
+
+	/* Events drained together arrived together */
+	uint32_t delta = DeltaMicroSeconds(m_last);
+
+	for (size_t i = 0; i < count && m_file; i++) {
+		SensorLogRecord record;
+		memset(&record, 0x00, sizeof(record));
+		record.m_delta = delta;
+		record.m_sensor = events[i].sensor;
+		record.m_type = events[i].type;
+		record.m_channels = UsedChannels(events[i]);
+		record.m_timestamp = events[i].timestamp;
+
+		WriteRecord(record, events[i].data);
+		delta = 0;
+	}
+}
+
+/****************************** Replay ******************************/
+
+SensorReplay::SensorReplay()
+: m_base(NULL), m_mapped(0), m_size(0), m_first(0), m_offset(0), m_speed(1.0),
+  m_arrival(0.0), m_start(0.0), m_now(0.0)
+{
+}
+
+SensorReplay::~SensorReplay() {
+	Close();
+}
+
+bool SensorReplay::Open(const char* path, double speed) {
+	Close();
+
+	if (speed < 0.0) {
+		LOG_ERROR("SensorReplay: speed %f is not valid", speed);
+		return false;
+	}
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		LOG_ERROR("SensorReplay: failed to open %s, error %d", path, errno);
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(SensorLogHeader)) {
+		LOG_ERROR("SensorReplay: %s is too small", path);
+		close(fd);
+		return false;
+	}
+
+	void* base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd,
+			0);
+	close(fd);
+
+	if (base == MAP_FAILED) {
+		LOG_ERROR("SensorReplay: failed to map %s, error %d", path, errno);
+		return false;
+	}
+
+	m_base = reinterpret_cast<const uint8_t*>(base);
+	m_mapped = m_size = (size_t) st.st_size;
+
+	SensorLogHeader header;
+	memcpy(&header, m_base, sizeof(header));
+
+	if (header.m_magic != SENSOR_LOG_MAGIC
+			|| header.m_version != SENSOR_LOG_VERSION
+			|| header.m_headerSize < sizeof(header)
+			|| header.m_headerSize > m_size) {
+		LOG_ERROR("SensorReplay: %s is not a version %d recording", path,
+				(int )SENSOR_LOG_VERSION);
+		Close();
+		return false;
+	}
+
+	m_first = header.m_headerSize;
+	m_speed = speed;
+
+	/* Trim a torn final record from a recording that was cut short */
+	size_t offset = m_first;
+	SensorLogRecord record;
+	while (ReadRecord(offset, record))
+		offset += sizeof(record) + record.m_channels * sizeof(uint32_t);
+
+	if (offset != m_size) {
+		LOG_WARN("SensorReplay: ignoring %d trailing bytes",
+				(int )(m_size - offset));
+	}
+	m_size = offset;
+
+	Rewind();
+
+	LOG_INFO("SensorReplay: replaying %s at speed %.2f", path, speed);
+	return true;
+}
+
+void SensorReplay::Close() {
+	if (m_base) {
+		munmap(const_cast<uint8_t*>(m_base), m_mapped);
+	}
+
+	m_base = NULL;
+	m_mapped = m_size = m_first = m_offset = 0;
+}
+
+bool SensorReplay::ReadRecord(size_t offset, SensorLogRecord& record) const {
+	if (m_base == NULL || offset + sizeof(record) > m_size)
+		return false;
+
+	memcpy(&record, m_base + offset, sizeof(record));
+
+	return record.m_channels <= MAX_LOG_CHANNELS
+			&& offset + sizeof(record) + record.m_channels * sizeof(uint32_t)
+					<= m_size;
+}
+
+void SensorReplay::Rewind() {
+	m_offset = m_first;
+	m_arrival = 0.0;
+}
+
+bool SensorReplay::BeginRound() {
+	SensorLogRecord record;
+
+	/* The start of the file is an implicit round marker. Otherwise */
+	/*   skip whatever the last round left unread.                  */
+	bool atStart = (m_offset == m_first);
+
+	while (!atStart) {
+		if (!ReadRecord(m_offset, record)) {
+			Rewind();
+			atStart = true;
+			break;
+		}
+
+		m_offset += sizeof(record) + record.m_channels * sizeof(uint32_t);
+
+		if (record.m_type == SENSOR_LOG_ROUND)
+			break;
+	}
+
+	/* Unless the recording began with a real marker */
+	if (atStart && ReadRecord(m_offset, record)
+			&& record.m_type == SENSOR_LOG_ROUND)
+		m_offset += sizeof(record);
+
+	m_arrival = 0.0;
+	m_now = 0.0;
+	m_start = MonotonicNanoSeconds() / 1e6;
+
+	/* A recording of empty rounds has nothing to replay */
+	if (NextArrival() < 0.0) {
+		size_t offset = m_first;
+		while (ReadRecord(offset, record)) {
+			if (record.m_type != SENSOR_LOG_ROUND)
+				return true;
+			offset += sizeof(record) + record.m_channels * sizeof(uint32_t);
+		}
+		return false;
+	}
+
+	return true;
+}
+
+double SensorReplay::Elapsed() const {
+	if (m_speed == 0.0)
+		return m_now;
+
+	return (MonotonicNanoSeconds() / 1e6 - m_start) * m_speed;
+}
+
+double SensorReplay::NextArrival() const {
+	SensorLogRecord record;
+	if (!ReadRecord(m_offset, record) || record.m_type == SENSOR_LOG_ROUND)
+		return -1.0;
+
+	return m_arrival + record.m_delta / 1000.0;
+}
+
+void SensorReplay::WaitUntil(double milliseconds) {
+	if (m_speed == 0.0) {
+		m_now = std::max(m_now, milliseconds);
+		return;
+	}
+
+	for (;;) {
+		const double remaining = (milliseconds - Elapsed()) / m_speed;
+		if (remaining <= 0.0)
+			return;
+
+		struct timespec ts;
+		ts.tv_sec = (time_t) (remaining / 1000.0);
+		ts.tv_nsec = (long) ((remaining - ts.tv_sec * 1000.0) * 1e6);
+		nanosleep(&ts, NULL);
+	}
+}
+
+size_t SensorReplay::ReadEvents(ASensorEvent* events, size_t count) {
+	const double now = Elapsed();
+	size_t n = 0;
+
+	while (n < count) {
+		const double arrival = NextArrival();
+		if (arrival < 0.0 || arrival > now)
+			break;
+
+		SensorLogRecord record;
+		ReadRecord(m_offset, record);
+
+		ASensorEvent& event = events[n++];
+		memset(&event, 0x00, sizeof(event));
+		event.version = sizeof(ASensorEvent);
+		event.sensor = record.m_sensor;
+		event.type = record.m_type;
+		event.timestamp = record.m_timestamp;
+		memcpy(event.data, m_base + m_offset + sizeof(record),
+				record.m_channels * sizeof(uint32_t));
+
+		m_offset += sizeof(record) + record.m_channels * sizeof(uint32_t);
+		m_arrival = arrival;
+	}
+
+	return n;
+}
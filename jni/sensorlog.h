@@ -0,0 +1,140 @@
+/* Sensor event recordings. A recording captures the events the  */
+/* collector drained, with their arrival times, so the sensor    */
+/* traffic of one device can be replayed through the collector   */
+/* on another device or on a host.                               */
+
+#ifndef _Included_com_cryptopp_prng_sensorlog
+#define _Included_com_cryptopp_prng_sensorlog
+
+#include <android/sensor.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/* File layout. Fields are in the byte order of the recording   */
+/* device (little endian on every Android ABI).                 */
+/*                                                              */
+/*   SensorLogHeader                                            */
+/*   SensorLogRecord, followed by m_channels 32-bit data words  */
+/*   SensorLogRecord, ...                                       */
+/*                                                              */
+/* A record with type SENSOR_LOG_ROUND and no data marks the    */
+/* start of a collection round. Arrival times within a round    */
+/* are relative to its marker, so rest time between rounds is   */
+/* not replayed. Readers skip m_headerSize bytes to reach the   */
+/* first record, so the header can grow without a new version.  */
+
+static const uint32_t SENSOR_LOG_MAGIC = 0x56455350; /* "PSEV" */
+static const uint16_t SENSOR_LOG_VERSION = 1;
+
+/* Sensor types start at 1, so 0 is free for the round marker. */
+static const int32_t SENSOR_LOG_ROUND = 0;
+
+struct SensorLogHeader {
+	uint32_t m_magic;
+	uint16_t m_version;
+	uint16_t m_headerSize;
+	uint32_t m_eventSize; /* sizeof(ASensorEvent) on the recording device */
+	uint32_t m_reserved;
+	uint64_t m_created; /* seconds since the epoch */
+};
+
+struct SensorLogRecord {
+	uint32_t m_delta; /* microseconds since the previous record */
+	int32_t m_sensor;
+	int32_t m_type;
+	uint8_t m_channels; /* data words that follow, up to 16 */
+	uint8_t m_reserved[3];
+	int64_t m_timestamp;
+};
+
+/* Appends drained events to a recording. Thread safe; events from */
+/*   several collectors interleave in arrival order.               */
+class SensorRecorder
+{
+public:
+	SensorRecorder();
+	~SensorRecorder();
+
+	/* Creates or truncates path. Returns false on failure. */
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen();
+
+	/* Marks the start of a collection round. */
+	void MarkRound();
+
+	void Record(const ASensorEvent* events, size_t count);
+
+	/* Records written since Open, including round markers. */
+	unsigned long Records();
+
+private:
+	// Not copyable
+	SensorRecorder(const SensorRecorder&);
+	SensorRecorder& operator=(const SensorRecorder&);
+
+	void WriteRecord(const SensorLogRecord& record, const void* data);
+
+	pthread_mutex_t m_lock;
+	FILE* m_file;
+	int64_t m_last; /* monotonic nanoseconds of the previous record */
+	unsigned long m_records;
+};
+
+/* Replays a recording from a read-only mapping. A replay runs one */
+/*   round at a time against its own clock. With a speed of 1 the  */
+/*   round's events arrive at their recorded times; 2 is twice as  */
+/*   fast; 0 does not wait at all. The recording wraps around when */
+/*   it runs out. Not thread safe.                                 */
+class SensorReplay
+{
+public:
+	SensorReplay();
+	~SensorReplay();
+
+	/* Maps and validates path. Returns false on failure. */
+	bool Open(const char* path, double speed);
+	void Close();
+
+	/* Moves to the next round marker and starts the round clock.  */
+	/*   Returns false if the recording has no events.             */
+	bool BeginRound();
+
+	/* Milliseconds on the round clock since BeginRound. */
+	double Elapsed() const;
+
+	/* Round clock time of the next event in this round, or a    */
+	/*   negative value if the round has no more events.         */
+	double NextArrival() const;
+
+	/* Blocks until the round clock reaches milliseconds. */
+	void WaitUntil(double milliseconds);
+
+	/* Copies up to count events that have arrived by the round */
+	/*   clock into events. Returns the number copied.          */
+	size_t ReadEvents(ASensorEvent* events, size_t count);
+
+private:
+	// Not copyable
+	SensorReplay(const SensorReplay&);
+	SensorReplay& operator=(const SensorReplay&);
+
+	bool ReadRecord(size_t offset, SensorLogRecord& record) const;
+	void Rewind();
+
+	const uint8_t* m_base;
+	size_t m_mapped;
+	size_t m_size; /* bytes of whole records */
+	size_t m_first; /* offset of the first record */
+	size_t m_offset; /* offset of the next record */
+	double m_speed;
+
+	double m_arrival; /* round clock time of the record at m_offset */
+	double m_start; /* monotonic milliseconds when the round began */
+	double m_now; /* round clock when m_speed is 0 */
+};
+
+#endif
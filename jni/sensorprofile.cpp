@@ -0,0 +1,181 @@
+#include "prng.h"
+#include "sensorprofile.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+using std::string;
+
+static const char PROFILE_FILE_TAG[] = "prng-sensor-profile";
+static const int PROFILE_FILE_VERSION = 1;
+
+/* Caps on the bits credited per staged field. The estimate is the */
+/*   size of the change between consecutive readings, which is an  */
+/*   upper bound on what an observer could not predict; the caps   */
+/*   keep one noisy field from dominating the ranking. Only the    */
+/*   ranking uses these numbers.                                   */
+static const double MAX_STAMP_BITS = 8.0;
+static const double MAX_VALUE_BITS = 12.0;
+
+static double ChangeBits(int64_t change, double cap) {
+	if (change < 0)
+		change = -change;
+	return std::min(cap, log2(1.0 + (double) change));
+}
+
+void ObserveSensorEvent(SensorProfile& profile, const ASensorEvent& event,
+		int channels) {
+	channels = std::min(channels, PROFILE_CHANNELS);
+
+	/* The same fields StageSensorEvents keeps */
+	const int64_t stamp = (uint32_t) event.timestamp;
+	uint16_t values[PROFILE_CHANNELS];
+
+	for (int c = 0; c < channels; c++) {
+		uint32_t bits;
+		memcpy(&bits, &event.data[c], sizeof(bits));
+		values[c] = (uint16_t) bits;
+	}
+
+	double bits = 0.0;
+
+	if (profile.m_events > 0) {
+		/* Arrival jitter: the change in the interval between events */
+		const int64_t delta = stamp - profile.m_lastStamp;
+		if (profile.m_events > 1)
+			bits += ChangeBits(delta - profile.m_lastDelta, MAX_STAMP_BITS);
+		profile.m_lastDelta = delta;
+
+		for (int c = 0; c < channels; c++) {
+			const int16_t change = (int16_t) (values[c]
+					- profile.m_lastValues[c]);
+			bits += ChangeBits(change, MAX_VALUE_BITS);
+		}
+	}
+
+	profile.m_lastStamp = stamp;
+	for (int c = 0; c < channels; c++)
+		profile.m_lastValues[c] = values[c];
+
+	profile.m_events++;
+	profile.m_bits += bits;
+}
+
+static bool BetterProfile(const SensorProfile& a, const SensorProfile& b) {
+	return a.BitsPerMilliSecond() > b.BitsPerMilliSecond();
+}
+
+void RankSensorProfiles(SensorProfiles& profiles) {
+	std::stable_sort(profiles.begin(), profiles.end(), BetterProfile);
+}
+
+size_t SelectSensorProfiles(const SensorProfiles& ranked, double window,
+		double targetBits, double targetEvents) {
+	double expected = 0.0;
+	double events = 0.0;
+	size_t k = 0;
+
+	for (size_t i = 0;
+			i < ranked.size() && (expected < targetBits || events < targetEvents);
+			i++) {
+		/* A type that will not report within the window adds nothing */
+		if (ranked[i].EventsPerMilliSecond() * window < 1.0)
+			break;
+		if (ranked[i].BitsPerMilliSecond() <= 0.0)
+			break;
+
+		expected += ranked[i].BitsPerMilliSecond() * window;
+		events += ranked[i].EventsPerMilliSecond() * window;
+		k++;
+	}
+
+	return k;
+}
+
+/* Format:                                                        */
+/*   prng-sensor-profile 1 <profiled ms>                          */
+/*   <type> <window ms> <events> <bits> <name to end of line>     */
+bool LoadSensorProfiles(const char* path, SensorProfiles& profiles,
+		double& profiled) {
+	FILE* file = fopen(path, "r");
+	if (file == NULL) {
+		LOG_DEBUG("SensorProfile: no profile at %s", path);
+		return false;
+	}
+
+	char line[256];
+	char tag[32];
+	int version = 0;
+	bool ok = false;
+
+	if (fgets(line, sizeof(line), file)
+			&& sscanf(line, "%31s %d %lf", tag, &version, &profiled) == 3
+			&& strcmp(tag, PROFILE_FILE_TAG) == 0
+			&& version == PROFILE_FILE_VERSION) {
+		ok = true;
+		profiles.clear();
+
+		while (fgets(line, sizeof(line), file)) {
+			SensorProfile profile;
+			int consumed = 0;
+
+			if (sscanf(line, "%d %lf %lu %lf %n", &profile.m_type,
+					&profile.m_window, &profile.m_events, &profile.m_bits,
+					&consumed) < 4) {
+				ok = false;
+				break;
+			}
+
+			string name(line + consumed);
+			name.erase(name.find_last_not_of("\r\n") + 1);
+			profile.m_name = name;
+
+			profiles.push_back(profile);
+		}
+	}
+
+	fclose(file);
+
+	if (!ok) {
+		LOG_WARN("SensorProfile: ignoring malformed profile %s", path);
+		profiles.clear();
+	}
+
+	return ok;
+}
+
+bool SaveSensorProfiles(const char* path, const SensorProfiles& profiles,
+		double profiled) {
+	const string temp = string(path) + ".tmp";
+
+	FILE* file = fopen(temp.c_str(), "w");
+	if (file == NULL) {
+		LOG_WARN("SensorProfile: failed to open %s, error %d", temp.c_str(),
+				errno);
+		return false;
+	}
+
+	fprintf(file, "%s %d %.0f\n", PROFILE_FILE_TAG, PROFILE_FILE_VERSION,
+			profiled);
+
+	for (size_t i = 0; i < profiles.size(); i++) {
+		const SensorProfile& p = profiles[i];
+		fprintf(file, "%d %.3f %lu %.3f %s\n", p.m_type, p.m_window,
+				p.m_events, p.m_bits, p.m_name.c_str());
+	}
+
+	const bool written = (fflush(file) == 0 && !ferror(file));
+	fclose(file);
+
+	if (!written || rename(temp.c_str(), path) != 0) {
+		LOG_WARN("SensorProfile: failed to save %s", path);
+		remove(temp.c_str());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,88 @@
+/* Sensor profiles. A profiling round enables one sensor of each  */
+/* type, and the collector records how often each type reported   */
+/* and roughly how much entropy its readings carried. Steady-state */
+/* rounds then enable only the best few types.                    */
+
+#ifndef _Included_com_cryptopp_prng_sensorprofile
+#define _Included_com_cryptopp_prng_sensorprofile
+
+#include <android/sensor.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+/* Widest layout tracked per profile. Matches MAX_SENSOR_CHANNELS. */
+static const int PROFILE_CHANNELS = 6;
+
+struct SensorProfile {
+	SensorProfile() :
+			m_type(0), m_window(0.0), m_events(0), m_bits(0.0), m_lastStamp(0), m_lastDelta(
+					0) {
+		for (int i = 0; i < PROFILE_CHANNELS; i++)
+			m_lastValues[i] = 0;
+	}
+
+	SensorProfile(int type, const std::string& name) :
+			m_type(type), m_name(name), m_window(0.0), m_events(0), m_bits(0.0), m_lastStamp(
+					0), m_lastDelta(0) {
+		for (int i = 0; i < PROFILE_CHANNELS; i++)
+			m_lastValues[i] = 0;
+	}
+
+	double EventsPerMilliSecond() const {
+		return m_window > 0.0 ? m_events / m_window : 0.0;
+	}
+
+	double BitsPerEvent() const {
+		return m_events > 0 ? m_bits / m_events : 0.0;
+	}
+
+	double BitsPerMilliSecond() const {
+		return m_window > 0.0 ? m_bits / m_window : 0.0;
+	}
+
+	int m_type;
+	std::string m_name;
+
+	// Length of the profiling round, in milliseconds
+	double m_window;
+
+	// Events seen, and the estimated bits they carried
+	unsigned long m_events;
+	double m_bits;
+
+	// Estimator state: the previous event's staged fields
+	int64_t m_lastStamp;
+	int64_t m_lastDelta;
+	uint16_t m_lastValues[PROFILE_CHANNELS];
+};
+
+typedef std::vector<SensorProfile> SensorProfiles;
+
+/* Adds one event to its type's profile. channels is the number of */
+/*   value words the collector stages for the type.               */
+void ObserveSensorEvent(SensorProfile& profile, const ASensorEvent& event,
+		int channels);
+
+/* Sorts profiles by bits per millisecond, best first. */
+void RankSensorProfiles(SensorProfiles& profiles);
+
+/* Returns how many of the ranked profiles are needed to expect    */
+/*   both targetBits and targetEvents within window milliseconds.  */
+/*   Types that contribute nothing are never selected, so this can */
+/*   return 0.                                                     */
+size_t SelectSensorProfiles(const SensorProfiles& ranked, double window,
+		double targetBits, double targetEvents);
+
+/* A profile file is text, one line per sensor type. profiled is */
+/*   the wall clock time of the profiling round, in milliseconds. */
+/*   Both return false on failure. Saving is atomic.             */
+bool LoadSensorProfiles(const char* path, SensorProfiles& profiles,
+		double& profiled);
+bool SaveSensorProfiles(const char* path, const SensorProfiles& profiles,
+		double profiled);
+
+#endif
@@ -0,0 +1,259 @@
+#include "prng.h"
+#include "stream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <new>
+#include <algorithm>
+
+#include <cryptopp/cryptlib.h>
+using CryptoPP::Exception;
+
+#include <cryptopp/misc.h>
+using CryptoPP::SecureWipeBuffer;
+
+RandomStream::RandomStream() :
+		m_fill(0), m_drain(0), m_cancelled(false), m_failed(false), m_started(
+				false) {
+	for (size_t i = 0; i < 2; i++) {
+		m_buffers[i].m_head = 0;
+		m_buffers[i].m_count = 0;
+		m_buffers[i].m_full = false;
+	}
+
+	m_wake[0] = m_wake[1] = -1;
+
+	pthread_mutex_init(&m_lock, NULL);
+	pthread_cond_init(&m_cond, NULL);
+	pthread_mutex_init(&m_consumerLock, NULL);
+}
+
+RandomStream::~RandomStream() {
+	Cancel();
+
+	/* Wait out a consumer still returning from Cancel */
+	pthread_mutex_lock(&m_consumerLock);
+	pthread_mutex_unlock(&m_consumerLock);
+
+	if (m_started)
+		pthread_join(m_producer, NULL);
+
+	if (m_wake[0] >= 0) {
+		close(m_wake[0]);
+		close(m_wake[1]);
+	}
+
+	pthread_mutex_destroy(&m_consumerLock);
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_lock);
+
+	// SecByteBlock wipes the buffers
+}
+
+bool RandomStream::Start() {
+	try {
+		m_buffers[0].m_data.New(STREAM_BUFFER_BYTES);
+		m_buffers[1].m_data.New(STREAM_BUFFER_BYTES);
+	} catch (const std::bad_alloc&) {
+		LOG_ERROR("Stream: failed to allocate buffers");
+		return false;
+	}
+
+	if (pipe(m_wake) != 0) {
+		LOG_ERROR("Stream: pipe failed, error %d", errno);
+		m_wake[0] = m_wake[1] = -1;
+		return false;
+	}
+
+	for (size_t i = 0; i < 2; i++) {
+		fcntl(m_wake[i], F_SETFD, FD_CLOEXEC);
+		fcntl(m_wake[i], F_SETFL, O_NONBLOCK);
+	}
+
+	int rc = pthread_create(&m_producer, NULL, ProducerThread, this);
+	if (rc != 0) {
+		LOG_ERROR("Stream: pthread_create failed, error %d", rc);
+		return false;
+	}
+
+	m_started = true;
+	return true;
+}
+
+void* RandomStream::ProducerThread(void* data) {
+	reinterpret_cast<RandomStream*>(data)->Produce();
+	return NULL;
+}
+
+void RandomStream::Produce() {
+	MutexLock lock(m_lock);
+
+	while (!m_cancelled) {
+		Buffer& buffer = m_buffers[m_fill];
+		if (buffer.m_full) {
+			pthread_cond_wait(&m_cond, &m_lock);
+			continue;
+		}
+
+		/* The consumer does not touch an empty buffer */
+		pthread_mutex_unlock(&m_lock);
+
+		bool generated = true;
+		try {
+			GenerateBlock(buffer.m_data.data(), buffer.m_data.size());
+		} catch (const Exception& ex) {
+			LOG_ERROR("Stream: Crypto++ exception: \"%s\"", ex.what());
+			generated = false;
+		}
+
+		pthread_mutex_lock(&m_lock);
+
+		if (!generated) {
+			m_failed = true;
+			pthread_cond_broadcast(&m_cond);
+			break;
+		}
+
+		buffer.m_head = 0;
+		buffer.m_count = buffer.m_data.size();
+		buffer.m_full = true;
+		m_fill ^= 1;
+
+		pthread_cond_broadcast(&m_cond);
+	}
+}
+
+const uint8_t* RandomStream::Acquire(size_t& available) {
+	MutexLock lock(m_lock);
+
+	Buffer& buffer = m_buffers[m_drain];
+	if (!buffer.m_full && !m_cancelled && !m_failed) {
+		/* The producer fell behind the consumer */
+		TraceSection section(STAGE_STREAM_WAIT);
+
+		while (!buffer.m_full && !m_cancelled && !m_failed)
+			pthread_cond_wait(&m_cond, &m_lock);
+	}
+
+	if (m_cancelled || !buffer.m_full) {
+		available = 0;
+		return NULL;
+	}
+
+	available = buffer.m_count - buffer.m_head;
+	return buffer.m_data.data() + buffer.m_head;
+}
+
+void RandomStream::Consume(size_t used) {
+	Buffer& buffer = m_buffers[m_drain];
+
+	SecureWipeBuffer(buffer.m_data.data() + buffer.m_head, used);
+	buffer.m_head += used;
+
+	AddStat(STAT_STREAM_BYTES, used);
+
+	if (buffer.m_head < buffer.m_count)
+		return;
+
+	MutexLock lock(m_lock);
+
+	buffer.m_full = false;
+	m_drain ^= 1;
+
+	pthread_cond_broadcast(&m_cond);
+}
+
+void RandomStream::Cancel() {
+	{
+		MutexLock lock(m_lock);
+		if (m_cancelled)
+			return;
+
+		m_cancelled = true;
+		pthread_cond_broadcast(&m_cond);
+	}
+
+	if (m_wake[1] >= 0) {
+		const char wake = 1;
+		(void) write(m_wake[1], &wake, 1);
+	}
+}
+
+bool RandomStream::WaitWritable(int fd) {
+	for (;;) {
+		struct pollfd fds[2];
+		fds[0].fd = fd;
+		fds[0].events = POLLOUT;
+		fds[0].revents = 0;
+		fds[1].fd = m_wake[0];
+		fds[1].events = POLLIN;
+		fds[1].revents = 0;
+
+		const int n = poll(fds, 2, -1);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 || fds[1].revents)
+			return false;
+		if (fds[0].revents & POLLOUT)
+			return true;
+		if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+			return false;
+	}
+}
+
+unsigned long long RandomStream::WriteTo(int fd, unsigned long long count) {
+	MutexLock lock(m_consumerLock);
+
+	/* send, where fd is a socket, so a closed peer is an EPIPE */
+	/*   and not a SIGPIPE                                       */
+	bool socket = true;
+	unsigned long long written = 0;
+
+	while (count == 0 || written < count) {
+		size_t available;
+		const uint8_t* data = Acquire(available);
+		if (data == NULL)
+			break;
+
+		if (count != 0)
+			available = (size_t) std::min<unsigned long long>(available,
+					count - written);
+		available = std::min(available, STREAM_WRITE_BYTES);
+
+		/* A blocking write cannot be cancelled, so only write to */
+		/*   a descriptor that is ready, a bounded amount at once */
+		if (!WaitWritable(fd))
+			break;
+
+		ssize_t n = socket ? send(fd, data, available, MSG_NOSIGNAL) : -1;
+		if (socket && n < 0 && errno == ENOTSOCK) {
+			socket = false;
+		}
+		if (!socket) {
+			n = write(fd, data, available);
+		}
+
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		/* A non-blocking descriptor filled up after the poll */
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			continue;
+
+		if (n <= 0) {
+			LOG_ERROR("Stream: write to %d failed, error %d", fd, errno);
+			break;
+		}
+
+		Consume((size_t) n);
+		written += (unsigned long long) n;
+	}
+
+	LOG_DEBUG("Stream: wrote %llu bytes to %d", written, fd);
+
+	return written;
+}
@@ -0,0 +1,101 @@
+/* Streaming output. A RandomStream owns a producer thread and two */
+/* buffers: the producer generates into one while the caller       */
+/* writes the other to a file descriptor or copies it out, so the  */
+/* generator and the consumer run in parallel. Output comes from   */
+/* GenerateBlock on the producer thread, and a consumed buffer is  */
+/* wiped before it is refilled. Streams do not survive a fork.     */
+
+#ifndef _Included_com_cryptopp_prng_stream
+#define _Included_com_cryptopp_prng_stream
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <cryptopp/secblock.h>
+using CryptoPP::SecByteBlock;
+
+/* Bytes in each of the two buffers. */
+static const size_t STREAM_BUFFER_BYTES = 256 * 1024;
+
+/* Most bytes handed to a single write, so a cancel is noticed */
+/*   while a slow reader drains a pipe or socket.              */
+static const size_t STREAM_WRITE_BYTES = 64 * 1024;
+
+class RandomStream
+{
+public:
+	RandomStream();
+
+	/* Cancels, waits for the consumer, stops the producer and */
+	/*   wipes both buffers.                                   */
+	~RandomStream();
+
+	/* Starts the producer. Returns false on failure. */
+	bool Start();
+
+	/* Writes count bytes to fd, or until cancelled if count is 0. */
+	/*   Blocking and non-blocking descriptors both work. Returns   */
+	/*   the bytes written; fewer than count means the stream was   */
+	/*   cancelled or failed, or fd reported an error.              */
+	unsigned long long WriteTo(int fd, unsigned long long count);
+
+	/* For copying out without a descriptor. Acquire waits for output */
+	/*   and returns it, setting available, or returns NULL once the  */
+	/*   stream is cancelled or failed. Consume then releases the     */
+	/*   first used bytes. The caller holds the consumer lock across  */
+	/*   both; see ConsumerLock.                                      */
+	const uint8_t* Acquire(size_t& available);
+	void Consume(size_t used);
+
+	/* One consumer at a time. WriteTo takes it itself. */
+	pthread_mutex_t& ConsumerLock() {
+		return m_consumerLock;
+	}
+
+	/* Ends the stream. A WriteTo or Acquire in progress returns, and */
+	/*   later ones return at once. Safe from any thread.             */
+	void Cancel();
+
+private:
+	// Not copyable
+	RandomStream(const RandomStream&);
+	RandomStream& operator=(const RandomStream&);
+
+	static void* ProducerThread(void* data);
+	void Produce();
+
+	/* Waits until fd is writable, or the stream is cancelled. */
+	bool WaitWritable(int fd);
+
+	struct Buffer {
+		SecByteBlock m_data;
+
+		// Unread bytes are [m_head, m_count). Only the producer
+		// touches an empty buffer and only the consumer a full one
+		size_t m_head;
+		size_t m_count;
+		bool m_full;
+	};
+
+	Buffer m_buffers[2];
+
+	// Next buffer each side uses. Guarded by m_lock
+	int m_fill;
+	int m_drain;
+
+	bool m_cancelled;
+	bool m_failed;
+
+	pthread_mutex_t m_lock;
+	pthread_cond_t m_cond;
+	pthread_mutex_t m_consumerLock;
+
+	pthread_t m_producer;
+	bool m_started;
+
+	// Written by Cancel so a consumer blocked in poll wakes up
+	int m_wake[2];
+};
+
+#endif
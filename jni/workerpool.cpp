@@ -0,0 +1,157 @@
+#include "prng.h"
+#include "workerpool.h"
+
+#include <new>
+
+WorkerPool::WorkerPool() :
+		m_stop(false), m_job(0), m_function(NULL), m_context(NULL), m_count(0), m_next(
+				0), m_unfinished(0) {
+	pthread_mutex_init(&m_runLock, NULL);
+	pthread_mutex_init(&m_lock, NULL);
+	pthread_cond_init(&m_workCond, NULL);
+	pthread_cond_init(&m_doneCond, NULL);
+}
+
+/* The thread may first run after TryRun has started the next job, */
+/*   so it must not read m_job itself; it would take that job as     */
+/*   already seen.                                                   */
+void* WorkerPool::WorkerThread(void* data) {
+	WorkerStart* start = reinterpret_cast<WorkerStart*>(data);
+	WorkerPool* pool = start->m_pool;
+	unsigned long seen = start->m_seen;
+	delete start;
+
+	MutexLock lock(pool->m_lock);
+
+	for (;;) {
+		while (!pool->m_stop && pool->m_job == seen)
+			pthread_cond_wait(&pool->m_workCond, &pool->m_lock);
+
+		if (pool->m_stop)
+			break;
+
+		seen = pool->m_job;
+		pool->RunTasks(seen);
+	}
+
+	return NULL;
+}
+
+void WorkerPool::RunTasks(unsigned long job) {
+	while (m_job == job && m_next < m_count) {
+		const size_t index = m_next++;
+		WorkFunction function = m_function;
+		void* context = m_context;
+
+		pthread_mutex_unlock(&m_lock);
+		function(context, index);
+		pthread_mutex_lock(&m_lock);
+
+		if (--m_unfinished == 0)
+			pthread_cond_broadcast(&m_doneCond);
+	}
+}
+
+/* The caller holds m_runLock, so no job is running. */
+void WorkerPool::Resize(size_t workers) {
+	if (m_threads.size() > workers) {
+		{
+			MutexLock lock(m_lock);
+			m_stop = true;
+			pthread_cond_broadcast(&m_workCond);
+		}
+
+		for (size_t i = 0; i < m_threads.size(); i++)
+			pthread_join(m_threads[i], NULL);
+
+		m_threads.clear();
+
+		MutexLock lock(m_lock);
+		m_stop = false;
+	}
+
+	unsigned long job;
+	{
+		MutexLock lock(m_lock);
+		job = m_job;
+	}
+
+	while (m_threads.size() < workers) {
+		WorkerStart* start = new (std::nothrow) WorkerStart;
+		if (start == NULL) {
+			LOG_ERROR("WorkerPool: failed to allocate worker");
+			break;
+		}
+
+		start->m_pool = this;
+		start->m_seen = job;
+
+		pthread_t thread;
+		int rc = pthread_create(&thread, NULL, WorkerThread, start);
+		if (rc != 0) {
+			LOG_ERROR("WorkerPool: pthread_create failed, error %d", rc);
+			delete start;
+			break;
+		}
+
+		m_threads.push_back(thread);
+	}
+
+	LOG_DEBUG("WorkerPool: %d workers", (int )m_threads.size());
+}
+
+bool WorkerPool::TryRun(size_t workers, WorkFunction function, void* context,
+		size_t count) {
+	if (pthread_mutex_trylock(&m_runLock) != 0)
+		return false;
+
+	if (m_threads.size() != workers)
+		Resize(workers);
+
+	if (m_threads.empty()) {
+		pthread_mutex_unlock(&m_runLock);
+		return false;
+	}
+
+	{
+		MutexLock lock(m_lock);
+
+		m_function = function;
+		m_context = context;
+		m_count = count;
+		m_next = 0;
+		m_unfinished = count;
+		const unsigned long job = ++m_job;
+
+		pthread_cond_broadcast(&m_workCond);
+
+		RunTasks(job);
+
+		while (m_unfinished != 0)
+			pthread_cond_wait(&m_doneCond, &m_lock);
+
+		m_function = NULL;
+		m_context = NULL;
+	}
+
+	pthread_mutex_unlock(&m_runLock);
+	return true;
+}
+
+/* Only the forking thread exists in the child, so the locks are */
+/*   rebuilt rather than unlocked; a job in flight in the parent */
+/*   is abandoned. The next TryRun starts fresh workers.          */
+void WorkerPool::ResetAfterFork() {
+	pthread_mutex_init(&m_runLock, NULL);
+	pthread_mutex_init(&m_lock, NULL);
+	pthread_cond_init(&m_workCond, NULL);
+	pthread_cond_init(&m_doneCond, NULL);
+
+	m_threads.clear();
+	m_stop = false;
+	m_function = NULL;
+	m_context = NULL;
+	m_count = 0;
+	m_next = 0;
+	m_unfinished = 0;
+}
@@ -0,0 +1,74 @@
+/* A small pool of worker threads for splitting one large request */
+/* across cores. One job runs at a time; the thread that submits  */
+/* it works on it too, and returns once every task has finished.  */
+
+#ifndef _Included_com_cryptopp_prng_workerpool
+#define _Included_com_cryptopp_prng_workerpool
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include <vector>
+
+/* Runs task index of a job. Tasks of one job run concurrently, */
+/*   so each must touch only its own part of the context.       */
+typedef void (*WorkFunction)(void* context, size_t index);
+
+class WorkerPool
+{
+public:
+	WorkerPool();
+
+	/* Runs function over tasks 0 to count - 1 on workers threads */
+	/*   plus the caller, starting or stopping threads to match.  */
+	/*   Returns false, having run nothing, if another job holds  */
+	/*   the pool or no worker could be started; the caller then  */
+	/*   does the work itself.                                    */
+	bool TryRun(size_t workers, WorkFunction function, void* context,
+			size_t count);
+
+	/* Called in a forked child, where the workers no longer exist. */
+	void ResetAfterFork();
+
+private:
+	// Not copyable
+	WorkerPool(const WorkerPool&);
+	WorkerPool& operator=(const WorkerPool&);
+
+	/* What a new worker starts from: its pool, and the job that was */
+	/*   current when Resize created it, read under m_lock.          */
+	struct WorkerStart {
+		WorkerPool* m_pool;
+		unsigned long m_seen;
+	};
+
+	static void* WorkerThread(void* data);
+
+	void Resize(size_t workers);
+
+	/* Claims and runs tasks of job until none are left. Called */
+	/*   and returns with m_lock held.                          */
+	void RunTasks(unsigned long job);
+
+	// Held for the whole of a job, and while resizing
+	pthread_mutex_t m_runLock;
+
+	// Guards everything below
+	pthread_mutex_t m_lock;
+	pthread_cond_t m_workCond;
+	pthread_cond_t m_doneCond;
+
+	std::vector<pthread_t> m_threads;
+	bool m_stop;
+
+	// The current job. m_job changes with each job, so a worker that
+	// wakes late never claims tasks of a newer one
+	unsigned long m_job;
+	WorkFunction m_function;
+	void* m_context;
+	size_t m_count;
+	size_t m_next;
+	size_t m_unfinished;
+};
+
+#endif
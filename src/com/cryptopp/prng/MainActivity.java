@@ -47,6 +47,21 @@ public class MainActivity extends Activity {
 		prng.getBytes(bytes);
 	}
 
+	@Override
+	protected void onPause() {
+		super.onPause();
+
+		// No need to sample sensors while in the background
+		PRNG.PauseHarvester();
+	}
+
+	@Override
+	protected void onResume() {
+		super.onResume();
+
+		PRNG.ResumeHarvester();
+	}
+
 	public void btnReseed_onClick(View view) {
 
 		new AsyncTask<Void, Void, Void>() {
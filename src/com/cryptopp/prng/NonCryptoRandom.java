@@ -0,0 +1,137 @@
+package com.cryptopp.prng;
+
+// A fast, seedable generator for simulations and load tests. It is NOT
+// cryptographically secure: its output is predictable from a few values,
+// so never use it for keys, nonces, tokens or anything an attacker may
+// see. Use PRNG for those. It shares nothing with PRNG's pool.
+//
+// The generator is xoshiro256**. The same seed gives the same sequence
+// on every device, however the values are drawn. For parallel work,
+// give each thread its own generator from split(). Methods are
+// synchronized, but one generator shared between threads is slower and
+// its order between them is not reproducible.
+public final class NonCryptoRandom {
+
+    // The natives are registered when the library loads, whichever
+    // class loads it first.
+    static {
+        System.loadLibrary("c++_shared");
+        System.loadLibrary("cryptopp");
+        System.loadLibrary("prng");
+    }
+
+    private static native long NonCrypto_Create(long seed);
+
+    private static native long NonCrypto_Split(long generator);
+
+    private static native int NonCrypto_Jump(long generator);
+
+    private static native int NonCrypto_Destroy(long generator);
+
+    private static native int NonCrypto_NextBytes(long generator,
+            byte[] bytes, int offset, int length);
+
+    private static native int NonCrypto_NextInts(long generator,
+            int[] values, int bound);
+
+    private static native int NonCrypto_NextLongs(long generator,
+            long[] values, long lo, long hi);
+
+    private static native int NonCrypto_NextDoubles(long generator,
+            double[] values);
+
+    private long generator;
+
+    public NonCryptoRandom(long seed) {
+        generator = checked(NonCrypto_Create(seed));
+    }
+
+    private NonCryptoRandom() {
+    }
+
+    // Returns a generator that continues this one's sequence, and jumps
+    // this one ahead, so the two never overlap. Call it once per worker
+    // thread.
+    public synchronized NonCryptoRandom split() {
+        NonCryptoRandom other = new NonCryptoRandom();
+        other.generator = checked(NonCrypto_Split(handle()));
+        return other;
+    }
+
+    // Moves 2^192 steps ahead. Up to 2^64 jumps give streams that do
+    // not overlap.
+    public synchronized void jump() {
+        NonCrypto_Jump(handle());
+    }
+
+    public void nextBytes(byte[] bytes) {
+        nextBytes(bytes, 0, bytes.length);
+    }
+
+    // Fills bytes[offset, offset + length).
+    public synchronized void nextBytes(byte[] bytes, int offset, int length) {
+        if (offset < 0 || length < 0 || length > bytes.length - offset) {
+            throw new IndexOutOfBoundsException();
+        }
+        if (length > 0) {
+            NonCrypto_NextBytes(handle(), bytes, offset, length);
+        }
+    }
+
+    // Fills values with uniform ints in [0, bound).
+    public synchronized void nextInts(int[] values, int bound) {
+        if (bound <= 0) {
+            throw new IllegalArgumentException("bound must be positive");
+        }
+        if (values.length > 0) {
+            NonCrypto_NextInts(handle(), values, bound);
+        }
+    }
+
+    // Fills values with uniform longs in [lo, hi).
+    public synchronized void nextLongs(long[] values, long lo, long hi) {
+        if (lo >= hi) {
+            throw new IllegalArgumentException("lo must be less than hi");
+        }
+        if (values.length > 0) {
+            NonCrypto_NextLongs(handle(), values, lo, hi);
+        }
+    }
+
+    // Fills values with uniform doubles in [0, 1).
+    public synchronized void nextDoubles(double[] values) {
+        if (values.length > 0) {
+            NonCrypto_NextDoubles(handle(), values);
+        }
+    }
+
+    public synchronized void close() {
+        if (generator != 0) {
+            NonCrypto_Destroy(generator);
+            generator = 0;
+        }
+    }
+
+    @Override
+    protected void finalize() throws Throwable {
+        try {
+            close();
+        } finally {
+            super.finalize();
+        }
+    }
+
+    private static long checked(long generator) {
+        if (generator == 0) {
+            throw new OutOfMemoryError("Failed to create native generator");
+        }
+        return generator;
+    }
+
+    private long handle() {
+        if (generator == 0) {
+            throw new IllegalStateException("Generator closed");
+        }
+        return generator;
+    }
+}
@@ -1,5 +1,9 @@
 package com.cryptopp.prng;
 
+import java.nio.ByteBuffer;
+
+// The native library keeps a generator per calling thread, so these
+// methods do not need to be synchronized.
 public class PRNG {
 
     static {
@@ -12,34 +16,517 @@ public class PRNG {
 
     private static native int CryptoPP_GetBytes(byte[] bytes);
 
-    private static Object lock = new Object();
+    private static native int CryptoPP_ReseedRange(byte[] bytes, int offset,
+            int length);
+
+    private static native int CryptoPP_GetBytesRange(byte[] bytes, int offset,
+            int length);
+
+    private static native int CryptoPP_GetBytesDirect(ByteBuffer buffer,
+            int offset, int length);
+
+    private static native int CryptoPP_GetBytesBatch(byte[][] arrays);
+
+    private static native int CryptoPP_NextInts(int[] values, int bound);
+
+    private static native int CryptoPP_NextLongs(long[] values, long lo,
+            long hi);
+
+    private static native int CryptoPP_NextDoubles(double[] values);
+
+    private static native int CryptoPP_NextFloats(float[] values);
+
+    private static native int CryptoPP_StartHarvester();
+
+    private static native int CryptoPP_StopHarvester();
+
+    private static native int CryptoPP_PauseHarvester();
+
+    private static native int CryptoPP_ResumeHarvester();
+
+    private static native int CryptoPP_ConfigureRing(int size, int lowWater,
+            int maxRequest);
+
+    private static native int CryptoPP_GetStats(long[] stats);
+
+    private static native int CryptoPP_SelectBackend(int type);
+
+    private static native int CryptoPP_GetBackend();
+
+    private static native int CryptoPP_StartRecording(String path);
+
+    private static native int CryptoPP_StopRecording();
+
+    private static native int CryptoPP_SetProfilePath(String path);
+
+    private static native int CryptoPP_GetEntropyEstimates(double[] estimates);
+
+    private static native int CryptoPP_RequestReseed();
+
+    private static native int CryptoPP_ConfigureReseed(long bytes,
+            int milliseconds);
+
+    private static native int CryptoPP_GetLatencyStats(long[] stats);
+
+    private static native int CryptoPP_SetSeedFile(String path);
+
+    private static native int CryptoPP_IsReady();
+
+    private static native int CryptoPP_AwaitReady(int milliseconds);
+
+    private static native int CryptoPP_ConfigureParallel(long threshold,
+            int workers);
+
+    private static native long CryptoPP_OpenStream();
+
+    private static native long CryptoPP_WriteStream(long stream, int fd,
+            long count);
+
+    private static native int CryptoPP_ReadStream(long stream, byte[] bytes,
+            int offset, int length);
+
+    private static native int CryptoPP_CancelStream(long stream);
+
+    private static native int CryptoPP_CloseStream(long stream);
+
+    private static native int CryptoPP_StartDaemon(String path);
+
+    private static native int CryptoPP_StopDaemon();
+
+    private static native int CryptoPP_UseDaemon(String path);
+
+    private static native int CryptoPP_GetBytesWithin(byte[] bytes,
+            long deadlineMicros);
+
+    // Generator backends for SelectBackend. BACKEND_AUTO picks AES-CTR
+    // when the CPU has AES instructions, and ChaCha20 otherwise.
+    public static final int BACKEND_AUTO = 0;
+    public static final int BACKEND_POOL = 1;
+    public static final int BACKEND_AES_CTR = 2;
+    public static final int BACKEND_CHACHA20 = 3;
+
+    // Indexes into the array filled by GetStats
+    public static final int STAT_RING_HITS = 0;
+    public static final int STAT_RING_MISSES = 1;
+    public static final int STAT_RING_BYPASSES = 2;
+    public static final int STAT_RING_REFILLS = 3;
+    public static final int STAT_RING_REFILL_BYTES = 4;
+    public static final int STAT_SENSOR_ROUNDS = 5;
+    public static final int STAT_SENSOR_TARGET_MET = 6;
+    public static final int STAT_SENSOR_CREDITED_BITS = 7;
+    public static final int STAT_HEALTH_RCT_FAILURES = 8;
+    public static final int STAT_HEALTH_APT_FAILURES = 9;
+    public static final int STAT_RESEED_BYTES = 10;
+    public static final int STAT_RESEED_TIME = 11;
+    public static final int STAT_RESEED_FORK = 12;
+    public static final int STAT_RESEED_EXPLICIT = 13;
+    public static final int STAT_SEED_LOADS = 14;
+    public static final int STAT_SEED_SAVES = 15;
+    public static final int STAT_SEED_FAILURES = 16;
+    public static final int STAT_ENTROPY_COMMITS = 17;
+    public static final int STAT_ENTROPY_COMMIT_BYTES = 18;
+    public static final int STAT_ACCUMULATOR_OVERFLOWS = 19;
+    public static final int STAT_PARALLEL_REQUESTS = 20;
+    public static final int STAT_PARALLEL_FALLBACKS = 21;
+    public static final int STAT_STREAM_BYTES = 22;
+    public static final int STAT_DAEMON_REQUESTS = 23;
+    public static final int STAT_DAEMON_SEEDS = 24;
+    public static final int STAT_DAEMON_FALLBACKS = 25;
+    public static final int STAT_DEADLINE_REQUESTS = 26;
+    public static final int STAT_DEADLINE_ROUNDS = 27;
+    public static final int STAT_DEADLINE_FALLBACKS = 28;
+    public static final int STAT_COUNT = 29;
+
+    // Timed stages, in the order GetLatencyStats fills them
+    public static final int STAGE_JNI_PIN = 0;
+    public static final int STAGE_JNI_UNPIN = 1;
+    public static final int STAGE_SENSOR_DATA = 2;
+    public static final int STAGE_RANDOM_DEVICE = 3;
+    public static final int STAGE_PROCESS_INFO = 4;
+    public static final int STAGE_MIX = 5;
+    public static final int STAGE_GENERATE = 6;
+    public static final int STAGE_SEED_LOAD = 7;
+    public static final int STAGE_SEED_SAVE = 8;
+    public static final int STAGE_ACCUMULATE = 9;
+    public static final int STAGE_GETRANDOM = 10;
+    public static final int STAGE_URANDOM = 11;
+    public static final int STAGE_CPU_RANDOM = 12;
+    public static final int STAGE_PARALLEL_CHUNK = 13;
+    public static final int STAGE_STREAM_WAIT = 14;
+    public static final int STAGE_DAEMON_REQUEST = 15;
+    public static final int STAGE_COUNT = 16;
+
+    // Layout of the array filled by GetLatencyStats: LATENCY_FIELDS
+    // longs per stage. Bucket 0 counts samples under 128 ns, bucket i
+    // counts [2^(i+6), 2^(i+7)) ns, and the last bucket is open ended.
+    public static final int LATENCY_COUNT = 0;
+    public static final int LATENCY_TOTAL_NANOS = 1;
+    public static final int LATENCY_MAX_NANOS = 2;
+    public static final int LATENCY_FIRST_BUCKET = 3;
+    public static final int LATENCY_BUCKETS = 24;
+    public static final int LATENCY_FIELDS = 27;
+
+    // Layout of the array filled by GetEntropyEstimates: ESTIMATE_FIELDS
+    // doubles per sensor channel. Channel 0 is the timestamp, and 1 and
+    // up are the value words.
+    public static final int ESTIMATE_TYPE = 0;
+    public static final int ESTIMATE_CHANNEL = 1;
+    public static final int ESTIMATE_SAMPLES = 2;
+    public static final int ESTIMATE_MIN_ENTROPY = 3;
+    public static final int ESTIMATE_RCT_FAILURES = 4;
+    public static final int ESTIMATE_APT_FAILURES = 5;
+    public static final int ESTIMATE_FIELDS = 6;
+
+    // Class method. Opens a native stream: a producer thread generates
+    // into one buffer while the caller drains the other. Returns a handle
+    // for the *Stream methods, or 0 on failure. Close it with CloseStream.
+    // Streams do not survive a fork. See also RandomInputStream.
+    public static long OpenStream() {
+        return CryptoPP_OpenStream();
+    }
+
+    // Class method. Writes count bytes to the file descriptor fd (a file,
+    // pipe or socket, e.g. from ParcelFileDescriptor.getFd()), or until
+    // the stream is cancelled if count is 0. Blocks the calling thread.
+    // Returns the bytes written; fewer than count means the stream was
+    // cancelled or the descriptor failed.
+    public static long WriteStream(long stream, int fd, long count) {
+        return CryptoPP_WriteStream(stream, fd, count);
+    }
+
+    // Class method. Copies length bytes from the stream into
+    // bytes[offset, offset + length). Returns the bytes copied, which is
+    // fewer than length only once the stream is cancelled.
+    public static int ReadStream(long stream, byte[] bytes, int offset,
+            int length) {
+        return CryptoPP_ReadStream(stream, bytes, offset, length);
+    }
+
+    // Class method. Ends the stream from any thread. A WriteStream or
+    // ReadStream in progress returns, and later ones return at once.
+    public static int CancelStream(long stream) {
+        return CryptoPP_CancelStream(stream);
+    }
+
+    // Class method. Cancels the stream and frees it. The handle must not
+    // be used afterwards.
+    public static int CloseStream(long stream) {
+        return CryptoPP_CloseStream(stream);
+    }
+
+    // Class method. Makes this process the entropy daemon: it keeps its
+    // own harvester and serves seeds and output to processes that call
+    // UseDaemon with the same path, over a Unix domain socket. A path
+    // starting with '@' is in the abstract namespace and needs no file.
+    // Only processes with the same uid are served. Returns 1 if the
+    // daemon is listening.
+    public static int StartDaemon(String path) {
+        return CryptoPP_StartDaemon(path);
+    }
+
+    // Class method. Closes the socket and every client connection.
+    // Returns 1 if the daemon was running.
+    public static int StopDaemon() {
+        return CryptoPP_StopDaemon();
+    }
+
+    // Class method. Reseeds this process from the daemon at path instead
+    // of sampling sensors. While the daemon is absent or does not answer,
+    // the harvester collects locally and tries the daemon again later.
+    // null goes back to local collection. Returns 1 on success.
+    public static int UseDaemon(String path) {
+        return CryptoPP_UseDaemon(path);
+    }
 
     // Class method. Returns the number of bytes consumed from the seed.
     public static int Reseed(byte[] seed) {
+        return CryptoPP_Reseed(seed);
+    }
 
-        synchronized (lock) {
-            return CryptoPP_Reseed(seed);
-        }
+    // Class method. Collects fresh entropy now, regardless of the reseed
+    // policy. The harvester runs a sensor round in the background if it
+    // is running; otherwise the random device is mixed in before this
+    // returns. Returns 1 on success.
+    public static int Reseed() {
+        return CryptoPP_RequestReseed();
     }
 
     // Class method. Returns the number of bytes generated.
     public static int GetBytes(byte[] bytes) {
-        synchronized (lock) {
-            return CryptoPP_GetBytes(bytes);
-        }
+        return CryptoPP_GetBytes(bytes);
+    }
+
+    // Class method. Like GetBytes, but first mixes in as much fresh
+    // entropy as fits in deadlineMicros: a shortened sensor round when
+    // the harvester can finish one in time, otherwise the kernel's
+    // generator. 0 generates from the pool alone, the cheapest choice for
+    // UI paths. Returns the bits of fresh entropy credited, or -1 on
+    // failure.
+    public static int GetBytes(byte[] bytes, long deadlineMicros) {
+        return CryptoPP_GetBytesWithin(bytes, deadlineMicros);
+    }
+
+    // Class method. Returns the number of bytes consumed from
+    // seed[offset, offset + length).
+    public static int Reseed(byte[] seed, int offset, int length) {
+        return CryptoPP_ReseedRange(seed, offset, length);
+    }
+
+    // Class method. Fills bytes[offset, offset + length), so a caller can
+    // reuse one array. Returns the number of bytes generated.
+    public static int GetBytes(byte[] bytes, int offset, int length) {
+        return CryptoPP_GetBytesRange(bytes, offset, length);
+    }
+
+    // Class method. Writes straight into a direct ByteBuffer, starting at
+    // the absolute index offset. The buffer's position and limit are not
+    // changed. Returns the number of bytes generated, or 0 if the buffer
+    // is not direct.
+    public static int GetBytes(ByteBuffer buffer, int offset, int length) {
+        return CryptoPP_GetBytesDirect(buffer, offset, length);
+    }
+
+    // Class method. Fills every array in one native call, for callers that
+    // need several values at once (session id, token, nonce, key). Null
+    // entries are skipped. Returns the total number of bytes generated.
+    public static int GetBytes(byte[][] arrays) {
+        return CryptoPP_GetBytesBatch(arrays);
+    }
+
+    // Class method. Fills values with uniform ints in [0, bound). bound
+    // must be positive. Returns the number of values generated.
+    public static int NextInts(int[] values, int bound) {
+        return CryptoPP_NextInts(values, bound);
+    }
+
+    // Class method. Fills values with uniform longs in [lo, hi). lo must
+    // be less than hi. Returns the number of values generated.
+    public static int NextLongs(long[] values, long lo, long hi) {
+        return CryptoPP_NextLongs(values, lo, hi);
+    }
+
+    // Class method. Fills values with uniform doubles in [0, 1).
+    // Returns the number of values generated.
+    public static int NextDoubles(double[] values) {
+        return CryptoPP_NextDoubles(values);
+    }
+
+    // Class method. Fills values with uniform floats in [0, 1).
+    // Returns the number of values generated.
+    public static int NextFloats(float[] values) {
+        return CryptoPP_NextFloats(values);
+    }
+
+    // Class method. The library warms up in the background when it is
+    // loaded: it builds the generator, lists the sensors, and runs a first
+    // entropy round. Requests made before then still work; they wait only
+    // for the generator. Returns true once the warm-up is complete.
+    public static boolean IsReady() {
+        return CryptoPP_IsReady() != 0;
+    }
+
+    // Class method. Waits up to timeoutMillis for the warm-up. Returns
+    // true if the library is ready.
+    public static boolean AwaitReady(int timeoutMillis) {
+        return CryptoPP_AwaitReady(timeoutMillis) != 0;
+    }
+
+    // Class method. Starts the background entropy harvester. The library
+    // starts it when loaded, so this is only needed after StopHarvester.
+    // Returns 1 if the harvester is running.
+    public static int StartHarvester() {
+        return CryptoPP_StartHarvester();
+    }
+
+    // Class method. Stops the harvester and releases its sensor queue.
+    // Returns 1 if the harvester was stopped.
+    public static int StopHarvester() {
+        return CryptoPP_StopHarvester();
+    }
+
+    // Class method. Suspends sensor sampling, for example when the app
+    // moves to the background. Returns 1 if the harvester is running.
+    public static int PauseHarvester() {
+        return CryptoPP_PauseHarvester();
+    }
+
+    // Class method. Resumes sensor sampling after PauseHarvester.
+    // Returns 1 if the harvester is running.
+    public static int ResumeHarvester() {
+        return CryptoPP_ResumeHarvester();
+    }
+
+    // Class method. Tunes the per-thread ring of pre-generated output.
+    // Requests of at most maxRequest bytes are served from the ring, which
+    // is refilled when fewer than lowWater bytes remain. A size of 0
+    // disables the ring. Returns 1 if the settings were accepted.
+    public static int ConfigureRing(int size, int lowWater, int maxRequest) {
+        return CryptoPP_ConfigureRing(size, lowWater, maxRequest);
+    }
+
+    // Class method. Sets the reseed policy. The harvester collects fresh
+    // entropy after bytes of output or milliseconds since its last round,
+    // whichever comes first; 0 turns a trigger off. A fork always reseeds
+    // the child, and a child whose parent had a running harvester starts
+    // its own on its first output, so the policy carries over. Returns 1
+    // if the policy was accepted, 0 if milliseconds is under one second.
+    public static int ConfigureReseed(long bytes, int milliseconds) {
+        return CryptoPP_ConfigureReseed(bytes, milliseconds);
+    }
+
+    // Class method. Requests of at least threshold bytes are split across
+    // a pool of workers threads, each filling its own part of the array
+    // from an independently keyed generator. 0 workers turns splitting
+    // off. Returns 1 if the settings were accepted, 0 if threshold is
+    // under 64 KiB or workers is over 16.
+    public static int ConfigureParallel(long threshold, int workers) {
+        return CryptoPP_ConfigureParallel(threshold, workers);
+    }
+
+    // Class method. Selects the generator backend used by every thread.
+    // Threads switch on their next request. Returns the backend in use
+    // (BACKEND_AUTO resolved to a concrete backend), or 0 if type is not
+    // valid.
+    public static int SelectBackend(int type) {
+        return CryptoPP_SelectBackend(type);
+    }
+
+    // Class method. Returns the backend in use, one of the BACKEND_*
+    // constants other than BACKEND_AUTO.
+    public static int GetBackend() {
+        return CryptoPP_GetBackend();
+    }
+
+    // Class method. Records the sensor events the harvester collects,
+    // with their arrival times, to path (for example under getFilesDir()).
+    // The recording can be replayed through the collector on a host with
+    // prng-bench. Returns 1 if recording started.
+    //
+    // This is a debugging aid. The file holds, in the clear, the sensor
+    // data mixed into the generator, so anyone who can read it learns
+    // part of the input behind every key made while recording. Recorded
+    // events are therefore not credited as entropy: each round is topped
+    // up from the kernel instead. Release builds (NDEBUG) refuse to
+    // record and return 0. Delete recordings once they are copied off
+    // the device, and never record on a device whose keys matter.
+    public static int StartRecording(String path) {
+        return CryptoPP_StartRecording(path);
+    }
+
+    // Class method. Stops and closes the recording. Returns 1 if a
+    // recording was running.
+    public static int StopRecording() {
+        return CryptoPP_StopRecording();
+    }
+
+    // Class method. Caches the sensor profiles in path (for example under
+    // getFilesDir()), so a new process does not have to profile the
+    // sensors again before it can skip the slow ones. null turns the
+    // cache off. Returns 1.
+    public static int SetProfilePath(String path) {
+        return CryptoPP_SetProfilePath(path);
+    }
+
+    // Class method. Keeps a seed in path (for example under getFilesDir()).
+    // Call it early, such as from Application.onCreate: a seed saved by
+    // an earlier process is mixed in at once and then replaced, so it is
+    // never used twice. The seed is refreshed periodically and when the
+    // harvester is paused or stopped. null turns the seed file off.
+    // Returns 1 if a saved seed was mixed in.
+    public static int SetSeedFile(String path) {
+        return CryptoPP_SetSeedFile(path);
+    }
+
+    // Class method. Fills stats with the library counters, indexed by the
+    // STAT_* constants. Returns the number of counters copied.
+    public static int GetStats(long[] stats) {
+        return CryptoPP_GetStats(stats);
+    }
+
+    // Class method. Fills stats with a latency histogram for each timed
+    // stage, laid out by the STAGE_* and LATENCY_* constants. Only whole
+    // stages are copied, so size the array STAGE_COUNT * LATENCY_FIELDS.
+    // Returns the number of stages copied.
+    public static int GetLatencyStats(long[] stats) {
+        return CryptoPP_GetLatencyStats(stats);
+    }
+
+    // Class method. Fills estimates with the online min-entropy estimate
+    // and health test failures for each sensor channel seen so far, laid
+    // out by the ESTIMATE_* constants. Returns the number of channels
+    // copied.
+    public static int GetEntropyEstimates(double[] estimates) {
+        return CryptoPP_GetEntropyEstimates(estimates);
+    }
+
+    // Instance method. Returns true once the warm-up is complete.
+    public boolean isReady() {
+        return CryptoPP_IsReady() != 0;
+    }
+
+    // Instance method. Returns true if the library is ready.
+    public boolean awaitReady(int timeoutMillis) {
+        return CryptoPP_AwaitReady(timeoutMillis) != 0;
     }
 
     // Instance method. Returns the number of bytes consumed from the seed.
     public int reseed(byte[] seed) {
-        synchronized (lock) {
-            return CryptoPP_Reseed(seed);
-        }
+        return CryptoPP_Reseed(seed);
+    }
+
+    // Instance method. Returns 1 on success.
+    public int reseed() {
+        return CryptoPP_RequestReseed();
     }
 
     // Instance method. Returns the number of bytes generated.
     public int getBytes(byte[] bytes) {
-        synchronized (lock) {
-            return CryptoPP_GetBytes(bytes);
-        }
+        return CryptoPP_GetBytes(bytes);
+    }
+
+    // Instance method. Returns the bits of fresh entropy credited, or -1
+    // on failure.
+    public int getBytes(byte[] bytes, long deadlineMicros) {
+        return CryptoPP_GetBytesWithin(bytes, deadlineMicros);
+    }
+
+    // Instance method. Returns the number of bytes consumed from the seed.
+    public int reseed(byte[] seed, int offset, int length) {
+        return CryptoPP_ReseedRange(seed, offset, length);
+    }
+
+    // Instance method. Returns the number of bytes generated.
+    public int getBytes(byte[] bytes, int offset, int length) {
+        return CryptoPP_GetBytesRange(bytes, offset, length);
+    }
+
+    // Instance method. Returns the number of bytes generated.
+    public int getBytes(ByteBuffer buffer, int offset, int length) {
+        return CryptoPP_GetBytesDirect(buffer, offset, length);
+    }
+
+    // Instance method. Returns the total number of bytes generated.
+    public int getBytes(byte[][] arrays) {
+        return CryptoPP_GetBytesBatch(arrays);
+    }
+
+    // Instance method. Returns the number of values generated.
+    public int nextInts(int[] values, int bound) {
+        return CryptoPP_NextInts(values, bound);
+    }
+
+    // Instance method. Returns the number of values generated.
+    public int nextLongs(long[] values, long lo, long hi) {
+        return CryptoPP_NextLongs(values, lo, hi);
+    }
+
+    // Instance method. Returns the number of values generated.
+    public int nextDoubles(double[] values) {
+        return CryptoPP_NextDoubles(values);
+    }
+
+    // Instance method. Returns the number of values generated.
+    public int nextFloats(float[] values) {
+        return CryptoPP_NextFloats(values);
     }
 }
@@ -0,0 +1,73 @@
+package com.cryptopp.prng;
+
+import java.io.IOException;
+import java.io.InputStream;
+
+// An endless stream of random bytes, backed by a native stream (see
+// PRNG.OpenStream). A native thread generates the next buffer while the
+// caller reads the current one, so a read only costs the copy into the
+// caller's array. Reads are synchronized; one stream serves one reader
+// at a time.
+public class RandomInputStream extends InputStream {
+
+    private long stream;
+
+    public RandomInputStream() throws IOException {
+        stream = PRNG.OpenStream();
+        if (stream == 0) {
+            throw new IOException("Failed to open native stream");
+        }
+    }
+
+    @Override
+    public synchronized int read() throws IOException {
+        byte[] one = new byte[1];
+        return read(one, 0, 1) == 1 ? (one[0] & 0xff) : -1;
+    }
+
+    @Override
+    public synchronized int read(byte[] bytes, int offset, int length)
+            throws IOException {
+        if (bytes == null) {
+            throw new NullPointerException();
+        }
+        if (offset < 0 || length < 0 || length > bytes.length - offset) {
+            throw new IndexOutOfBoundsException();
+        }
+        if (stream == 0) {
+            throw new IOException("Stream closed");
+        }
+        if (length == 0) {
+            return 0;
+        }
+
+        int read = PRNG.ReadStream(stream, bytes, offset, length);
+        return read > 0 ? read : -1;
+    }
+
+    // The native stream does not report how much of its current buffer
+    // is left, and a read that outruns it waits for the next one. So no
+    // count can be promised without blocking, and 0 is the honest
+    // answer, even though the stream never ends.
+    @Override
+    public int available() throws IOException {
+        return 0;
+    }
+
+    @Override
+    public synchronized void close() {
+        if (stream != 0) {
+            PRNG.CloseStream(stream);
+            stream = 0;
+        }
+    }
+
+    @Override
+    protected void finalize() throws Throwable {
+        try {
+            close();
+        } finally {
+            super.finalize();
+        }
+    }
+}